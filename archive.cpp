@@ -0,0 +1,598 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: archive.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - A sailing archived twice keeps the reservations of both copies
+ *        - The LZ77 coder is public as archiveCompress and
+ *          archiveDecompress for the unit test
+ *
+ * Description: Implementation file of the Archive module of the Ferry
+ *              Reservation System. A block is a BlockHeader followed by
+ *              the compressed body. The body lists the sailings in ID
+ *              order, each followed by its reservations in licence order;
+ *              IDs, vessel names and licences are front coded against the
+ *              previous one (shared prefix length, suffix length, suffix)
+ *              and counts are varints.
+ *
+ * Design Issues: The compressor is LZ77 with a 4096 entry hash table of
+ *                4 byte sequences, 64KB window and LZ4 style tokens
+ *                (literal run length, match length, 2 byte offset)
+ *                A block cut short at the end of the file is a torn
+ *                append and is ignored; a checksum mismatch anywhere is
+ *                reported as corruption
+ */
+//================================================================
+#include "archive.hpp"
+#include "atomicFile.hpp"
+#include "mappedFile.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+
+//============================================================
+// Module scope constants
+//------------------------------------------------------------
+static const char BLOCKMAGIC[4] = {'F', 'A', 'B', '1'}; // Start of every block
+static const int HASHBITS = 12; // Size of the match finder table
+static const std::size_t MINMATCH = 4; // Shortest match worth encoding
+static const std::size_t MAXOFFSET = 65535; // Window of the compressor
+
+//============================================================
+// Struct: BlockHeader
+// Purpose: Fixed header written before each compressed block
+//------------------------------------------------------------
+struct BlockHeader
+{
+    char magic[4]; // BLOCKMAGIC
+    std::uint32_t sailings; // Sailings in the block
+    std::uint32_t reservations; // Reservations in the block
+    std::uint32_t rawBytes; // Size of the records in the data files
+    std::uint32_t encodedBytes; // Size of the body before compression
+    std::uint32_t storedBytes; // Size of the compressed body
+    std::uint32_t checksum; // FNV-1a of the compressed body
+};
+
+//================================================================
+// Helper function checksum returns the 32 bit FNV-1a hash of the bytes
+//----------------------------------------------------------------
+static std::uint32_t checksum(const unsigned char* bytes, std::size_t length)
+{
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Helper function putVarint appends value in 7 bit groups, low first
+//----------------------------------------------------------------
+static void putVarint(std::vector<unsigned char>& out, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Helper function putKey front codes key against previous; both are
+// null terminated within fieldSize bytes
+//----------------------------------------------------------------
+static void putKey(std::vector<unsigned char>& out, const char previous[], const char key[], std::size_t fieldSize)
+{
+    std::size_t length = strnlen(key, fieldSize - 1);
+    std::size_t shared = 0;
+    while (shared < length && previous[shared] == key[shared])
+    {
+        shared++;
+    }
+    out.push_back(static_cast<unsigned char>(shared));
+    out.push_back(static_cast<unsigned char>(length - shared));
+    out.insert(out.end(), key + shared, key + length);
+}
+
+// Helper function putFloat appends the bytes of a float
+//----------------------------------------------------------------
+static void putFloat(std::vector<unsigned char>& out, float value)
+{
+    unsigned char bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    out.insert(out.end(), bytes, bytes + sizeof(bytes));
+}
+
+//================================================================
+// Struct: BodyReader
+// Purpose: Bounds checked cursor over a decompressed block body
+//------------------------------------------------------------
+struct BodyReader
+{
+    const unsigned char* next; // Next byte to read
+    const unsigned char* end; // End of the body
+
+    unsigned char byte()
+    {
+        if (next == end)
+        {
+            throw std::runtime_error("Archive block is corrupt.");
+        }
+        return *next++;
+    }
+
+    std::uint32_t varint()
+    {
+        std::uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            unsigned char b = byte();
+            value |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        throw std::runtime_error("Archive block is corrupt.");
+    }
+
+    // Function key rebuilds a front coded key in place over the previous one
+    void key(char field[], std::size_t fieldSize)
+    {
+        std::size_t shared = byte();
+        std::size_t suffix = byte();
+        if (shared > strnlen(field, fieldSize) || shared + suffix >= fieldSize ||
+            static_cast<std::size_t>(end - next) < suffix)
+        {
+            throw std::runtime_error("Archive block is corrupt.");
+        }
+        std::memcpy(field + shared, next, suffix);
+        std::memset(field + shared + suffix, 0, fieldSize - shared - suffix);
+        next += suffix;
+    }
+
+    float number()
+    {
+        if (static_cast<std::size_t>(end - next) < sizeof(float))
+        {
+            throw std::runtime_error("Archive block is corrupt.");
+        }
+        float value;
+        std::memcpy(&value, next, sizeof(value));
+        next += sizeof(value);
+        return value;
+    }
+};
+
+//================================================================
+// Helper function putLength appends the part of a run length that did
+// not fit in its 4 bit token field
+//----------------------------------------------------------------
+static void putLength(std::vector<unsigned char>& out, std::size_t length)
+{
+    for (length -= 15; length >= 255; length -= 255)
+    {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+// Helper function putSequence appends literals and then a match; a
+// matchLength of 0 ends the block with literals only
+//----------------------------------------------------------------
+static void putSequence(std::vector<unsigned char>& out, const unsigned char* literals, std::size_t literalLength,
+                        std::size_t offset, std::size_t matchLength)
+{
+    std::size_t matchCode = matchLength == 0 ? 0 : matchLength - MINMATCH;
+    unsigned char token = static_cast<unsigned char>((std::min<std::size_t>(literalLength, 15) << 4) |
+                                                     std::min<std::size_t>(matchCode, 15));
+    out.push_back(token);
+    if (literalLength >= 15)
+    {
+        putLength(out, literalLength);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength == 0)
+    {
+        return;
+    }
+    out.push_back(static_cast<unsigned char>(offset));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchCode >= 15)
+    {
+        putLength(out, matchCode);
+    }
+}
+
+// Function archiveCompress returns the LZ77 coding of the bytes
+//----------------------------------------------------------------
+std::vector<unsigned char> archiveCompress(const std::vector<unsigned char>& in)
+{
+    std::vector<unsigned char> out;
+    out.reserve(in.size() / 2 + 16);
+    std::vector<std::size_t> table(std::size_t(1) << HASHBITS, SIZE_MAX);
+    std::size_t n = in.size();
+    std::size_t literalStart = 0;
+    std::size_t i = 0;
+    while (i + MINMATCH <= n)
+    {
+        std::uint32_t sequence;
+        std::memcpy(&sequence, &in[i], sizeof(sequence));
+        std::size_t slot = (sequence * 2654435761u) >> (32 - HASHBITS);
+        std::size_t candidate = table[slot];
+        table[slot] = i;
+        if (candidate == SIZE_MAX || i - candidate > MAXOFFSET ||
+            std::memcmp(&in[candidate], &in[i], MINMATCH) != 0)
+        {
+            i++;
+            continue;
+        }
+        std::size_t length = MINMATCH;
+        while (i + length < n && in[candidate + length] == in[i + length])
+        {
+            length++;
+        }
+        putSequence(out, &in[literalStart], i - literalStart, i - candidate, length);
+        i += length;
+        literalStart = i;
+    }
+    putSequence(out, in.data() + literalStart, n - literalStart, 0, 0);
+    return out;
+}
+
+// Helper function getLength reads the rest of a run length after its
+// 4 bit token field
+//----------------------------------------------------------------
+static std::size_t getLength(BodyReader& in, std::size_t length)
+{
+    if (length < 15)
+    {
+        return length;
+    }
+    unsigned char b;
+    do
+    {
+        b = in.byte();
+        length += b;
+    } while (b == 255);
+    return length;
+}
+
+// Function archiveDecompress returns the expectedSize bytes coded in the
+// compressed body
+//----------------------------------------------------------------
+std::vector<unsigned char> archiveDecompress(const unsigned char* body, std::size_t length, std::size_t expectedSize)
+{
+    std::vector<unsigned char> out;
+    out.reserve(expectedSize);
+    BodyReader in = {body, body + length};
+    while (in.next != in.end)
+    {
+        unsigned char token = in.byte();
+        std::size_t literals = getLength(in, token >> 4);
+        if (static_cast<std::size_t>(in.end - in.next) < literals || out.size() + literals > expectedSize)
+        {
+            throw std::runtime_error("Archive block is corrupt.");
+        }
+        out.insert(out.end(), in.next, in.next + literals);
+        in.next += literals;
+        if (in.next == in.end)
+        {
+            break;
+        }
+        std::size_t offset = in.byte();
+        offset |= static_cast<std::size_t>(in.byte()) << 8;
+        std::size_t match = getLength(in, token & 15) + MINMATCH;
+        if (offset == 0 || offset > out.size() || out.size() + match > expectedSize)
+        {
+            throw std::runtime_error("Archive block is corrupt.");
+        }
+        // Byte by byte, since a match may overlap the bytes it produces
+        std::size_t from = out.size() - offset;
+        for (std::size_t k = 0; k < match; ++k)
+        {
+            out.push_back(out[from + k]);
+        }
+    }
+    if (out.size() != expectedSize)
+    {
+        throw std::runtime_error("Archive block is corrupt.");
+    }
+    return out;
+}
+
+//================================================================
+// Helper function departure returns day * 100 + hour of a sailing ID in
+// the ttt-dd-hh format, or -1 if it is not in that format
+//----------------------------------------------------------------
+static int departure(const char sailingID[])
+{
+    const char* dd = sailingID + 4;
+    const char* hh = sailingID + 7;
+    if (strnlen(sailingID, sizeof(Sailing::sailingID)) != 9 ||
+        !std::isdigit(static_cast<unsigned char>(dd[0])) || !std::isdigit(static_cast<unsigned char>(dd[1])) ||
+        !std::isdigit(static_cast<unsigned char>(hh[0])) || !std::isdigit(static_cast<unsigned char>(hh[1])))
+    {
+        return -1;
+    }
+    return ((dd[0] - '0') * 10 + (dd[1] - '0')) * 100 + (hh[0] - '0') * 10 + (hh[1] - '0');
+}
+
+// Helper function sailingBefore orders sailings by ID
+//----------------------------------------------------------------
+static bool sailingBefore(const Sailing& a, const Sailing& b)
+{
+    return std::strncmp(a.sailingID, b.sailingID, sizeof(a.sailingID)) < 0;
+}
+
+// Helper function reservationBefore orders reservations by licence
+//----------------------------------------------------------------
+static bool reservationBefore(const Reservation& a, const Reservation& b)
+{
+    return std::strncmp(a.vehicleLicence, b.vehicleLicence, sizeof(a.vehicleLicence)) < 0;
+}
+
+// Helper function encodeBlock front codes the sailings, sorted by ID, and
+// the reservations of each, sorted by licence, into a block body
+//----------------------------------------------------------------
+static std::vector<unsigned char> encodeBlock(const std::vector<Sailing>& sailings,
+                                              const std::vector<std::vector<Reservation> >& reservations)
+{
+    std::vector<unsigned char> body;
+    Sailing previous = {};
+    putVarint(body, static_cast<std::uint32_t>(sailings.size()));
+    for (std::size_t s = 0; s < sailings.size(); ++s)
+    {
+        const Sailing& sailing = sailings[s];
+        putKey(body, previous.sailingID, sailing.sailingID, sizeof(sailing.sailingID));
+        putKey(body, previous.vesselName, sailing.vesselName, sizeof(sailing.vesselName));
+        putFloat(body, sailing.lowRemainingLength);
+        putFloat(body, sailing.highRemainingLength);
+        previous = sailing;
+
+        char previousLicence[sizeof(Reservation::vehicleLicence)] = {};
+        putVarint(body, static_cast<std::uint32_t>(reservations[s].size()));
+        for (const Reservation& r : reservations[s])
+        {
+            putKey(body, previousLicence, r.vehicleLicence, sizeof(r.vehicleLicence));
+            body.push_back(static_cast<unsigned char>((r.onBoard ? 1 : 0) | (r.isLRL ? 2 : 0)));
+            std::memcpy(previousLicence, r.vehicleLicence, sizeof(previousLicence));
+        }
+    }
+    return body;
+}
+
+// Helper function decodeBlock adds the sailings of a block body to
+// sailings. A sailing already there takes the later record and keeps the
+// reservations of both copies, the later one winning for a licence in
+// both: a run cut short after rewriting reservations.dat archives the
+// sailing again with none of its reservations
+//----------------------------------------------------------------
+static void decodeBlock(const std::vector<unsigned char>& body, std::map<std::string, ArchivedSailing>& sailings)
+{
+    BodyReader in = {body.data(), body.data() + body.size()};
+    Sailing previous = {};
+    std::uint32_t sailingCount = in.varint();
+    for (std::uint32_t s = 0; s < sailingCount; ++s)
+    {
+        ArchivedSailing archived;
+        archived.sailing = previous;
+        in.key(archived.sailing.sailingID, sizeof(archived.sailing.sailingID));
+        in.key(archived.sailing.vesselName, sizeof(archived.sailing.vesselName));
+        archived.sailing.lowRemainingLength = in.number();
+        archived.sailing.highRemainingLength = in.number();
+        previous = archived.sailing;
+
+        Reservation r = {};
+        std::memcpy(r.sailingID, archived.sailing.sailingID, sizeof(r.sailingID));
+        std::uint32_t reservationCount = in.varint();
+        for (std::uint32_t i = 0; i < reservationCount; ++i)
+        {
+            in.key(r.vehicleLicence, sizeof(r.vehicleLicence));
+            unsigned char flags = in.byte();
+            r.onBoard = (flags & 1) != 0;
+            r.isLRL = (flags & 2) != 0;
+            archived.reservations.push_back(r);
+        }
+        std::map<std::string, ArchivedSailing>::iterator earlier = sailings.find(archived.sailing.sailingID);
+        if (earlier != sailings.end())
+        {
+            std::vector<Reservation> merged;
+            std::set_union(archived.reservations.begin(), archived.reservations.end(),
+                           earlier->second.reservations.begin(), earlier->second.reservations.end(),
+                           std::back_inserter(merged), reservationBefore);
+            archived.reservations = std::move(merged);
+        }
+        sailings[archived.sailing.sailingID] = std::move(archived);
+    }
+    if (in.next != in.end)
+    {
+        throw std::runtime_error("Archive block is corrupt.");
+    }
+}
+
+//================================================================
+// Function archiveFileName builds archive-PERIOD.dat
+//----------------------------------------------------------------
+std::string archiveFileName(const char period[])
+{
+    std::string name(period);
+    if (name.empty() || name.size() > 32)
+    {
+        throw std::runtime_error("Archive period must be 1 to 32 characters.");
+    }
+    for (char c : name)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+        {
+            throw std::runtime_error("Archive period may only contain letters, digits, '-' and '_'.");
+        }
+    }
+    return "archive-" + name + ".dat";
+}
+
+// Function archiveDepartedSailings appends one block holding the departed
+// sailings to the archive, then rewrites the data files without them
+//----------------------------------------------------------------
+ArchiveSummary archiveDepartedSailings(int day, int hour, const char period[])
+{
+    TIME_FUNCTION("archiveDepartedSailings");
+    if (day < 0 || day > 99 || hour < 0 || hour > 99)
+    {
+        throw std::runtime_error("archiveDepartedSailings: day and hour must be 00-99.");
+    }
+    std::string fileName = archiveFileName(period);
+    int cutoff = day * 100 + hour;
+    ArchiveSummary summary = {};
+
+    std::vector<Sailing> departed;
+    std::vector<Sailing> keptSailings;
+    {
+        RecordSnapshot<Sailing> snapshot = sailingSnapshot();
+        for (const Sailing& s : snapshot.records())
+        {
+            int when = departure(s.sailingID);
+            if (when >= 0 && when < cutoff)
+            {
+                departed.push_back(s);
+            }
+            else
+            {
+                keptSailings.push_back(s);
+            }
+        }
+    }
+    if (departed.empty())
+    {
+        std::cout << "No departed sailings to archive." << std::endl;
+        return summary;
+    }
+    std::sort(departed.begin(), departed.end(), sailingBefore);
+
+    std::vector<std::vector<Reservation> > moved(departed.size());
+    std::vector<Reservation> keptReservations;
+    {
+        RecordSnapshot<Reservation> snapshot = reservationSnapshot();
+        for (const Reservation& r : snapshot.records())
+        {
+            Sailing key = {};
+            std::memcpy(key.sailingID, r.sailingID, sizeof(key.sailingID));
+            std::vector<Sailing>::const_iterator s = std::lower_bound(departed.begin(), departed.end(), key, sailingBefore);
+            if (s != departed.end() && std::strncmp(s->sailingID, r.sailingID, sizeof(r.sailingID)) == 0)
+            {
+                moved[s - departed.begin()].push_back(r);
+                summary.reservations++;
+            }
+            else
+            {
+                keptReservations.push_back(r);
+            }
+        }
+    }
+    for (std::vector<Reservation>& list : moved)
+    {
+        std::sort(list.begin(), list.end(), reservationBefore);
+    }
+
+    std::vector<unsigned char> body = encodeBlock(departed, moved);
+    std::vector<unsigned char> stored = archiveCompress(body);
+    summary.sailings = static_cast<int>(departed.size());
+    summary.rawBytes = static_cast<long>(departed.size() * sizeof(Sailing) + summary.reservations * sizeof(Reservation));
+    summary.storedBytes = static_cast<long>(sizeof(BlockHeader) + stored.size());
+
+    BlockHeader header = {};
+    std::memcpy(header.magic, BLOCKMAGIC, sizeof(header.magic));
+    header.sailings = static_cast<std::uint32_t>(summary.sailings);
+    header.reservations = static_cast<std::uint32_t>(summary.reservations);
+    header.rawBytes = static_cast<std::uint32_t>(summary.rawBytes);
+    header.encodedBytes = static_cast<std::uint32_t>(body.size());
+    header.storedBytes = static_cast<std::uint32_t>(stored.size());
+    header.checksum = checksum(stored.data(), stored.size());
+    std::vector<unsigned char> block(sizeof(header) + stored.size());
+    std::memcpy(block.data(), &header, sizeof(header));
+    std::memcpy(block.data() + sizeof(header), stored.data(), stored.size());
+
+    // The archive is durable before anything leaves the data files
+    appendDurably(fileName, block.data(), block.size());
+    rewriteReservations(keptReservations.data(), static_cast<int>(keptReservations.size()));
+    rewriteSailings(keptSailings.data(), static_cast<int>(keptSailings.size()));
+
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Archived " << summary.sailings << " sailings and " << summary.reservations
+              << " reservations to " << fileName << ": " << summary.rawBytes << " bytes stored in "
+              << summary.storedBytes << " (" << std::fixed << std::setprecision(1)
+              << static_cast<double>(summary.rawBytes) / summary.storedBytes << "x)" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    return summary;
+}
+
+// Function readArchive decodes every block of the archive in file order
+//----------------------------------------------------------------
+std::vector<ArchivedSailing> readArchive(const char period[])
+{
+    TIME_FUNCTION("readArchive");
+    std::string fileName = archiveFileName(period);
+    std::vector<ArchivedSailing> result;
+    if (!std::filesystem::exists(fileName))
+    {
+        return result;
+    }
+    MappedFile file(fileName);
+    std::map<std::string, ArchivedSailing> sailings;
+    std::size_t position = 0;
+    while (file.size() - position >= sizeof(BlockHeader))
+    {
+        BlockHeader header;
+        std::memcpy(&header, file.data() + position, sizeof(header));
+        if (std::memcmp(header.magic, BLOCKMAGIC, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error(fileName + " is corrupt.");
+        }
+        const unsigned char* stored = file.data() + position + sizeof(header);
+        if (file.size() - position - sizeof(header) < header.storedBytes)
+        {
+            break; // torn append
+        }
+        if (checksum(stored, header.storedBytes) != header.checksum)
+        {
+            throw std::runtime_error(fileName + " is corrupt.");
+        }
+        decodeBlock(archiveDecompress(stored, header.storedBytes, header.encodedBytes), sailings);
+        position += sizeof(header) + header.storedBytes;
+    }
+    result.reserve(sailings.size());
+    for (std::pair<const std::string, ArchivedSailing>& entry : sailings)
+    {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+// Function findArchivedSailing searches the decoded archive
+//----------------------------------------------------------------
+bool findArchivedSailing(const char period[], const char sailingID[], ArchivedSailing& found)
+{
+    std::vector<ArchivedSailing> sailings = readArchive(period);
+    for (ArchivedSailing& archived : sailings)
+    {
+        if (std::strncmp(archived.sailing.sailingID, sailingID, sizeof(archived.sailing.sailingID)) == 0)
+        {
+            found = std::move(archived);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,94 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: archive.hpp
+ *
+ * Description: Header file of the Archive module of the Ferry
+ *              Reservation System. Moves departed sailings and their
+ *              reservations out of sailings.dat and reservations.dat into
+ *              compressed, append-only archive files, one per period
+ *              (archive-PERIOD.dat), and reads them back for historical
+ *              queries. The storage modules must be opened first.
+ *
+ * Design Issues: Sailing IDs carry only the day and hour, so the caller
+ *                names the period (e.g. 2026-10) the sailings belong to
+ *                Each archive run appends one block: a header with a
+ *                checksum, then the records front coded (each key stores
+ *                only what differs from the previous key) and compressed
+ *                with a small LZ77 coder
+ *                The block is synced before the data files are rewritten,
+ *                so a crash in between archives the sailings twice rather
+ *                than losing them; a crash after reservations.dat is
+ *                rewritten archives them again with no reservations, so
+ *                readers keep the latest sailing record and the
+ *                reservations of every copy, merged by licence
+ */
+//================================================================
+#pragma once
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//================================================================
+// Struct: ArchivedSailing
+// Purpose: A sailing read back from an archive with its reservations
+//----------------------------------------------------------------
+struct ArchivedSailing
+{
+    Sailing sailing; // Sailing as it was when archived
+    std::vector<Reservation> reservations; // Its reservations by licence
+};
+
+// Struct: ArchiveSummary
+// Purpose: What one archive run moved and how well it compressed
+//----------------------------------------------------------------
+struct ArchiveSummary
+{
+    int sailings; // Sailings moved
+    int reservations; // Reservations moved
+    long rawBytes; // Size of the records in the data files
+    long storedBytes; // Size of the archive block written
+};
+
+//================================================================
+// Function archiveFileName returns the archive file of the period
+// Throws an exception if the period is empty or not made of letters,
+// digits, '-' and '_'
+//----------------------------------------------------------------
+std::string archiveFileName(const char period[]);
+
+// Function archiveDepartedSailings moves every sailing departing before
+// hour on day, with its reservations, into the archive of the period
+// Prints what was moved and the compression ratio
+// Throws an exception if the day, hour or period is invalid or a file
+// cannot be written; the data files are then unchanged
+//----------------------------------------------------------------
+ArchiveSummary archiveDepartedSailings(int day, int hour, const char period[]);
+
+// Function readArchive returns every sailing in the archive of the period
+// in sailing ID order; a sailing archived twice keeps its latest record
+// and the reservations of both copies, the latest winning by licence
+// Returns nothing if the period has no archive
+// Throws an exception if the archive is corrupt
+//----------------------------------------------------------------
+std::vector<ArchivedSailing> readArchive(const char period[]);
+
+// Function findArchivedSailing looks up one sailing in the archive of the
+// period. Returns true and fills in found if it was archived
+// Throws an exception if the archive is corrupt
+//----------------------------------------------------------------
+bool findArchivedSailing(const char period[], const char sailingID[], ArchivedSailing& found);
+
+// Function archiveCompress returns the LZ77 coding of the bytes used for
+// archive block bodies
+//----------------------------------------------------------------
+std::vector<unsigned char> archiveCompress(const std::vector<unsigned char>& in);
+
+// Function archiveDecompress returns the expectedSize bytes coded in a
+// body written by archiveCompress
+// Throws an exception if the body does not decode to exactly that size
+//----------------------------------------------------------------
+std::vector<unsigned char> archiveDecompress(const unsigned char* body, std::size_t length, std::size_t expectedSize);
@@ -0,0 +1,739 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: asyncIo.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Added asyncWaitAny for event loops
+ *        - Waiting steps keep reaping until an operation finishes, as a
+ *          synced write completes in two parts
+ *
+ * Description: Implementation file of the AsyncIo module of the Ferry
+ *              Reservation System. The io_uring backend talks to the
+ *              kernel through the raw io_uring_setup/io_uring_enter/
+ *              io_uring_register system calls and the shared rings, so no
+ *              library is needed. Operations live in a table of slots;
+ *              a slot number is the user_data of its submission entries.
+ *              Completions are collected first and their callbacks run
+ *              afterwards, so a callback may safely queue more work.
+ */
+//================================================================
+#include "asyncIo.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+  #include <io.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+#endif
+#if defined(__linux__) && defined(__has_include)
+  #if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #define HAVE_IO_URING 1
+  #endif
+#endif
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const unsigned DEFAULTQUEUEDEPTH = 256;
+
+//================================================================
+// Enum: OperationKind
+// Purpose: What a queued operation does
+//----------------------------------------------------------------
+enum OperationKind {readOperation, writeOperation, readaheadOperation};
+
+//================================================================
+// Struct: Operation
+// Purpose: One queued or in-flight operation
+//----------------------------------------------------------------
+struct Operation
+{
+    OperationKind kind;
+    int fd; // File descriptor
+    char* buffer; // Read target, or data below for writes
+    std::vector<char> data; // Copy of the bytes to write
+    std::size_t bytes; // Bytes to transfer
+    long long offset; // File offset
+    bool sync; // Write is followed by fdatasync
+    IoCallback done; // Callback, may be empty
+    AsyncRecordFile* file; // File whose pending count to update
+    long result; // Bytes transferred or -errno
+    int parts; // Completions still expected
+};
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static bool started = false;
+static IoBackend backend = posixBackend;
+static unsigned queueDepth = DEFAULTQUEUEDEPTH;
+static std::vector<Operation> operations; // slot table
+static std::vector<unsigned> freeSlots; // slots not in use
+static std::vector<unsigned> queued; // slots waiting for asyncSubmit
+static std::vector<unsigned> finished; // slots complete, callbacks not run
+
+#ifdef HAVE_IO_URING
+//================================================================
+// Struct: Ring
+// Purpose: Mapped submission and completion rings of the io_uring
+//----------------------------------------------------------------
+struct Ring
+{
+    int fd;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned* sqArray;
+    io_uring_sqe* sqes;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    unsigned cqEntries;
+    io_uring_cqe* cqes;
+    void* sqMap;
+    std::size_t sqMapSize;
+    void* cqMap;
+    std::size_t cqMapSize;
+    std::size_t sqeMapSize;
+    unsigned expected; // completions not yet reaped
+};
+
+static Ring ring = {-1, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0, nullptr,
+                    nullptr, 0, nullptr, 0, 0, 0};
+
+//================================================================
+// Helper function ringEnter submits toSubmit entries and waits for
+// minComplete completions, retrying when interrupted
+//----------------------------------------------------------------
+static int ringEnter(unsigned toSubmit, unsigned minComplete)
+{
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true)
+    {
+        long submitted = syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, flags, nullptr, 0);
+        if (submitted >= 0)
+        {
+            return static_cast<int>(submitted);
+        }
+        if (errno != EINTR)
+        {
+            throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+        }
+    }
+}
+
+// Helper function ringTeardown unmaps the rings and closes the ring
+//----------------------------------------------------------------
+static void ringTeardown()
+{
+    if (ring.fd < 0)
+    {
+        return;
+    }
+    if (ring.sqes != nullptr)
+    {
+        munmap(ring.sqes, ring.sqeMapSize);
+    }
+    if (ring.cqMap != nullptr && ring.cqMap != ring.sqMap)
+    {
+        munmap(ring.cqMap, ring.cqMapSize);
+    }
+    if (ring.sqMap != nullptr)
+    {
+        munmap(ring.sqMap, ring.sqMapSize);
+    }
+    close(ring.fd);
+    ring = Ring{-1, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0, nullptr,
+                nullptr, 0, nullptr, 0, 0, 0};
+}
+
+// Helper function ringSupportsOperations asks the kernel whether it
+// knows the read, write, fsync and fadvise operations
+//----------------------------------------------------------------
+static bool ringSupportsOperations()
+{
+    std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+    {
+        return false;
+    }
+    const unsigned char needed[] = {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FSYNC, IORING_OP_FADVISE};
+    for (unsigned char op : needed)
+    {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helper function ringSetup creates an io_uring with room for entries
+// submissions and maps its rings
+// Returns false if the kernel does not offer a usable io_uring
+//----------------------------------------------------------------
+static bool ringSetup(unsigned entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0)
+    {
+        return false; // ENOSYS on old kernels, EPERM under some sandboxes
+    }
+    ring.fd = fd;
+    ring.sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single)
+    {
+        ring.sqMapSize = ring.cqMapSize = std::max(ring.sqMapSize, ring.cqMapSize);
+    }
+    void* sqMap = mmap(nullptr, ring.sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED)
+    {
+        ringTeardown();
+        return false;
+    }
+    ring.sqMap = sqMap;
+    void* cqMap = sqMap;
+    if (!single)
+    {
+        cqMap = mmap(nullptr, ring.cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED)
+        {
+            ringTeardown();
+            return false;
+        }
+    }
+    ring.cqMap = cqMap;
+    ring.sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring.sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        ringTeardown();
+        return false;
+    }
+    ring.sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqMap);
+    ring.sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring.sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring.sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring.sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    ring.sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cqMap);
+    ring.cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring.cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring.cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring.cqEntries = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_entries);
+    ring.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    ring.expected = 0;
+
+    if (!ringSupportsOperations())
+    {
+        ringTeardown();
+        return false;
+    }
+    return true;
+}
+
+// Helper function ringReap records every available completion without
+// running callbacks. A write with sync completes after its fsync.
+// Returns the number of completions reaped
+//----------------------------------------------------------------
+static int ringReap()
+{
+    unsigned head = *ring.cqHead;
+    unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    int reaped = 0;
+    for (; head != tail; ++head, ++reaped)
+    {
+        const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+        Operation& op = operations[cqe.user_data >> 1];
+        bool isSync = (cqe.user_data & 1) != 0;
+        if (!isSync)
+        {
+            op.result = cqe.res;
+        }
+        else if (cqe.res < 0 && cqe.res != -ECANCELED && op.result >= 0)
+        {
+            op.result = cqe.res; // the data sync failed
+        }
+        if (--op.parts == 0)
+        {
+            finished.push_back(static_cast<unsigned>(cqe.user_data >> 1));
+        }
+    }
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    ring.expected -= reaped;
+    return reaped;
+}
+
+// Helper function ringEntry fills the next submission entry
+//----------------------------------------------------------------
+static io_uring_sqe* ringEntry(unsigned& tail)
+{
+    unsigned index = tail & ring.sqMask;
+    io_uring_sqe* sqe = &ring.sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ring.sqArray[index] = index;
+    tail++;
+    return sqe;
+}
+
+// Helper function ringSubmit puts every queued operation on the
+// submission ring, making room by waiting for completions when the
+// submission or completion ring is full
+//----------------------------------------------------------------
+static void ringSubmit()
+{
+    unsigned tail = *ring.sqTail;
+    unsigned toSubmit = 0;
+    std::size_t next = 0;
+    while (next < queued.size())
+    {
+        unsigned slot = queued[next];
+        Operation& op = operations[slot];
+        unsigned needed = (op.kind == writeOperation && op.sync) ? 2 : 1;
+        unsigned head = __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+        if (ring.sqEntries - (tail - head) < needed || ring.expected + needed > ring.cqEntries)
+        {
+            // Rings full: submit what is there and wait for a completion
+            __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+            ringEnter(toSubmit, ring.expected > 0 ? 1 : 0);
+            toSubmit = 0;
+            ringReap();
+            continue;
+        }
+
+        io_uring_sqe* sqe = ringEntry(tail);
+        sqe->fd = op.fd;
+        sqe->user_data = static_cast<unsigned long long>(slot) << 1;
+        switch (op.kind)
+        {
+        case readOperation:
+        case writeOperation:
+            sqe->opcode = op.kind == readOperation ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->off = static_cast<unsigned long long>(op.offset);
+            sqe->addr = reinterpret_cast<unsigned long long>(op.buffer);
+            sqe->len = static_cast<unsigned>(op.bytes);
+            break;
+        case readaheadOperation:
+            sqe->opcode = IORING_OP_FADVISE;
+            sqe->fadvise_advice = POSIX_FADV_WILLNEED;
+            break;
+        }
+        if (needed == 2)
+        {
+            // The data sync only runs once the write has succeeded
+            sqe->flags |= IOSQE_IO_LINK;
+            io_uring_sqe* sync = ringEntry(tail);
+            sync->opcode = IORING_OP_FSYNC;
+            sync->fd = op.fd;
+            sync->fsync_flags = IORING_FSYNC_DATASYNC;
+            sync->user_data = (static_cast<unsigned long long>(slot) << 1) | 1;
+        }
+        op.parts = static_cast<int>(needed);
+        ring.expected += needed;
+        toSubmit += needed;
+        next++;
+    }
+    queued.clear();
+    __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+    if (toSubmit > 0)
+    {
+        ringEnter(toSubmit, 0);
+    }
+}
+#endif
+
+//================================================================
+// Helper function positioned reads or writes all bytes at offset,
+// returning the bytes transferred or -errno
+//----------------------------------------------------------------
+static long positioned(bool write, int fd, char* buffer, std::size_t bytes, long long offset)
+{
+    std::size_t done = 0;
+    while (done < bytes)
+    {
+#ifdef _WIN32
+        if (_lseeki64(fd, offset + done, SEEK_SET) < 0)
+        {
+            return -errno;
+        }
+        unsigned chunk = static_cast<unsigned>(std::min<std::size_t>(bytes - done, 1u << 30));
+        long n = write ? _write(fd, buffer + done, chunk) : _read(fd, buffer + done, chunk);
+#else
+        long n = write ? pwrite(fd, buffer + done, bytes - done, offset + done)
+                       : pread(fd, buffer + done, bytes - done, offset + done);
+#endif
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            return -errno;
+        }
+        if (n == 0)
+        {
+            break; // end of file
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return static_cast<long>(done);
+}
+
+// Helper function posixRun carries out one operation right away
+//----------------------------------------------------------------
+static void posixRun(Operation& op)
+{
+    switch (op.kind)
+    {
+    case readOperation:
+        op.result = positioned(false, op.fd, op.buffer, op.bytes, op.offset);
+        break;
+    case writeOperation:
+        op.result = positioned(true, op.fd, op.buffer, op.bytes, op.offset);
+        if (op.sync && op.result >= 0)
+        {
+#ifdef _WIN32
+            int synced = _commit(op.fd);
+#elif defined(__APPLE__)
+            int synced = fsync(op.fd);
+#else
+            int synced = fdatasync(op.fd);
+#endif
+            if (synced != 0)
+            {
+                op.result = -errno;
+            }
+        }
+        break;
+    case readaheadOperation:
+#if defined(POSIX_FADV_WILLNEED) && !defined(_WIN32)
+        posix_fadvise(op.fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        op.result = 0;
+        break;
+    }
+    op.parts = 0;
+}
+
+// Helper function runFinished runs the callbacks of completed operations
+// and frees their slots. Returns the number run.
+//----------------------------------------------------------------
+static int runFinished()
+{
+    std::vector<unsigned> ready;
+    ready.swap(finished);
+    for (unsigned slot : ready)
+    {
+        // Take what the callback needs first: it may queue more work
+        Operation& op = operations[slot];
+        IoCallback done = std::move(op.done);
+        long result = op.result;
+        if (op.file != nullptr)
+        {
+            op.file->pending--;
+        }
+        op.done = nullptr;
+        op.file = nullptr;
+        freeSlots.push_back(slot);
+        if (done)
+        {
+            done(result);
+        }
+    }
+    return static_cast<int>(ready.size());
+}
+
+// Helper function step submits queued work, reaps what has completed,
+// waiting for at least one operation to finish if wait is true, and runs
+// callbacks
+//----------------------------------------------------------------
+static int step(bool wait)
+{
+    asyncSubmit();
+#ifdef HAVE_IO_URING
+    if (backend == uringBackend)
+    {
+        ringReap();
+        // A synced write needs both of its completions before it finishes
+        while (wait && finished.empty() && ring.expected > 0)
+        {
+            ringEnter(0, 1);
+            ringReap();
+        }
+    }
+#endif
+    return runFinished();
+}
+
+// Helper function ensureStarted starts the default backend if needed
+//----------------------------------------------------------------
+static void ensureStarted()
+{
+    if (!started)
+    {
+        asyncIoStart(true, DEFAULTQUEUEDEPTH);
+    }
+}
+
+// Helper function ensureOpen opens the file's async descriptor
+//----------------------------------------------------------------
+static void ensureOpen(AsyncRecordFile& file)
+{
+    if (file.fd >= 0)
+    {
+        return;
+    }
+#ifdef _WIN32
+    file.fd = _open(file.fileName, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    file.fd = open(file.fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+    if (file.fd < 0)
+    {
+        throw std::runtime_error(std::string("Cannot open ") + file.fileName + " for async I/O.");
+    }
+}
+
+// Helper function queueOperation takes a free slot for a new operation
+// on the file and queues it, submitting when the queue is full
+//----------------------------------------------------------------
+static Operation& queueOperation(AsyncRecordFile& file, OperationKind kind, IoCallback done)
+{
+    ensureStarted();
+    ensureOpen(file);
+    unsigned slot;
+    if (freeSlots.empty())
+    {
+        slot = static_cast<unsigned>(operations.size());
+        operations.push_back(Operation());
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    Operation& op = operations[slot];
+    op.kind = kind;
+    op.fd = file.fd;
+    op.buffer = nullptr;
+    op.bytes = 0;
+    op.offset = 0;
+    op.sync = false;
+    op.done = std::move(done);
+    op.file = &file;
+    op.result = 0;
+    op.parts = 0;
+    file.pending++;
+    queued.push_back(slot);
+    return op;
+}
+
+//================================================================
+// Function asyncIoStart sets up io_uring if allowed and available,
+// otherwise the pread/pwrite backend
+//----------------------------------------------------------------
+void asyncIoStart(bool allowUring, unsigned depth)
+{
+    asyncIoStop();
+    queueDepth = depth > 0 ? depth : DEFAULTQUEUEDEPTH;
+    backend = posixBackend;
+#ifdef HAVE_IO_URING
+    if (allowUring && ringSetup(queueDepth))
+    {
+        backend = uringBackend;
+    }
+#endif
+    started = true;
+}
+
+// Function asyncIoStop waits for every operation and releases the backend
+//----------------------------------------------------------------
+void asyncIoStop()
+{
+    if (!started)
+    {
+        return;
+    }
+    asyncWait();
+#ifdef HAVE_IO_URING
+    ringTeardown();
+#endif
+    started = false;
+}
+
+// Function asyncIoBackend returns the backend in use
+//----------------------------------------------------------------
+IoBackend asyncIoBackend()
+{
+    ensureStarted();
+    return backend;
+}
+
+// Function asyncIoBackendName returns the name of the backend in use
+//----------------------------------------------------------------
+const char* asyncIoBackendName()
+{
+    return asyncIoBackend() == uringBackend ? "io_uring" : "pread/pwrite";
+}
+
+// Function asyncSubmit submits every queued operation
+//----------------------------------------------------------------
+void asyncSubmit()
+{
+    if (queued.empty())
+    {
+        return;
+    }
+#ifdef HAVE_IO_URING
+    if (backend == uringBackend)
+    {
+        ringSubmit();
+        return;
+    }
+#endif
+    // Without io_uring the batch runs now; callbacks wait for asyncPoll
+    std::vector<unsigned> batch;
+    batch.swap(queued);
+    for (unsigned slot : batch)
+    {
+        posixRun(operations[slot]);
+        finished.push_back(slot);
+    }
+}
+
+// Function asyncPoll runs the callbacks of completed operations
+//----------------------------------------------------------------
+int asyncPoll()
+{
+    return step(false);
+}
+
+// Function asyncWaitAny waits for at least one completion if any is due
+//----------------------------------------------------------------
+int asyncWaitAny()
+{
+    return step(true);
+}
+
+// Function asyncWait runs callbacks until nothing is in flight
+//----------------------------------------------------------------
+void asyncWait()
+{
+    while (!queued.empty() || !finished.empty()
+#ifdef HAVE_IO_URING
+           || ring.expected > 0
+#endif
+          )
+    {
+        step(true);
+    }
+}
+
+//================================================================
+// Function asyncAppendOffset returns the offset the next append goes to
+//----------------------------------------------------------------
+long long asyncAppendOffset(AsyncRecordFile& file)
+{
+    ensureStarted();
+    ensureOpen(file);
+    if (file.pending == 0)
+    {
+        // Synchronous writers may have grown the file since the last append
+        struct stat status;
+        if (fstat(file.fd, &status) != 0)
+        {
+            throw std::runtime_error(std::string("Cannot read the size of ") + file.fileName + ".");
+        }
+        file.end = status.st_size;
+    }
+    return file.end;
+}
+
+// Function asyncAppend queues a copy of bytes to append to the file
+//----------------------------------------------------------------
+void asyncAppend(AsyncRecordFile& file, const void* data, std::size_t bytes, bool sync, IoCallback done)
+{
+    asyncAppendOffset(file);
+    Operation& op = queueOperation(file, writeOperation, std::move(done));
+    const char* first = static_cast<const char*>(data);
+    op.data.assign(first, first + bytes);
+    op.buffer = op.data.data();
+    op.bytes = bytes;
+    op.offset = file.end;
+    op.sync = sync;
+    file.end += static_cast<long long>(bytes);
+    if (queued.size() >= queueDepth)
+    {
+        asyncSubmit();
+    }
+}
+
+// Function asyncReadAt queues a read into the caller's buffer
+//----------------------------------------------------------------
+void asyncReadAt(AsyncRecordFile& file, void* buffer, std::size_t bytes, long long offset, IoCallback done)
+{
+    Operation& op = queueOperation(file, readOperation, std::move(done));
+    op.buffer = static_cast<char*>(buffer);
+    op.bytes = bytes;
+    op.offset = offset;
+    if (queued.size() >= queueDepth)
+    {
+        asyncSubmit();
+    }
+}
+
+// Function asyncReadahead queues readahead of the whole file
+//----------------------------------------------------------------
+void asyncReadahead(AsyncRecordFile& file)
+{
+    queueOperation(file, readaheadOperation, nullptr);
+    asyncSubmit();
+}
+
+// Function asyncSettle waits until no operation on the file is pending
+//----------------------------------------------------------------
+void asyncSettle(AsyncRecordFile& file)
+{
+    while (file.pending > 0)
+    {
+        step(true);
+    }
+}
+
+// Function asyncRecordFileClose settles the file and closes its descriptor
+//----------------------------------------------------------------
+void asyncRecordFileClose(AsyncRecordFile& file)
+{
+    asyncSettle(file);
+    if (file.fd >= 0)
+    {
+#ifdef _WIN32
+        _close(file.fd);
+#else
+        close(file.fd);
+#endif
+        file.fd = -1;
+    }
+}
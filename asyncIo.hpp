@@ -0,0 +1,126 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: asyncIo.hpp
+ *
+ * Description: Header file of the AsyncIo module of the Ferry Reservation
+ *              System. Queues reads, appends, data syncs and readahead on
+ *              the record files and submits them in batches, calling each
+ *              operation's callback when it completes. On Linux the
+ *              operations go through io_uring; elsewhere, or when the
+ *              kernel refuses io_uring, they run with pread/pwrite when
+ *              the batch is submitted.
+ *
+ * Design Issues: The system is single threaded, so callbacks only run
+ *                inside asyncPoll and asyncWait, never concurrently
+ *                An append with sync set is linked to an fdatasync, so
+ *                its callback runs once the records are on disk
+ *                The storage modules open their own descriptor for async
+ *                work (see AsyncRecordFile) and settle it before any of
+ *                their synchronous functions touch the file
+ */
+//================================================================
+#pragma once
+#include <cstddef>
+#include <functional>
+
+//================================================================
+// Enum: IoBackend
+// Purpose: How queued operations are carried out
+//----------------------------------------------------------------
+enum IoBackend {uringBackend, posixBackend};
+
+// Called with the bytes transferred, or a negative errno
+typedef std::function<void(long result)> IoCallback;
+
+// Called with the records transferred, or -1 if the operation failed
+typedef std::function<void(int records)> RecordCallback;
+
+//================================================================
+// Struct: AsyncRecordFile
+// Purpose: Async state of one record file, kept by its storage module
+//----------------------------------------------------------------
+struct AsyncRecordFile
+{
+    const char* fileName; // Data file name
+    int fd; // Descriptor for async work, -1 until first used
+    long long end; // Append offset, including queued appends
+    int pending; // Operations queued or in flight
+};
+
+//================================================================
+// Function asyncIoStart sets up the backend with room for queueDepth
+// operations in flight. io_uring is used if allowUring is true and the
+// kernel supports it, otherwise pread/pwrite. Stops any backend running.
+// The first async operation starts the default backend if needed.
+//----------------------------------------------------------------
+void asyncIoStart(bool allowUring, unsigned queueDepth);
+
+// Function asyncIoStop waits for every operation and releases the backend
+//----------------------------------------------------------------
+void asyncIoStop();
+
+// Function asyncIoBackend returns the backend in use
+//----------------------------------------------------------------
+IoBackend asyncIoBackend();
+
+// Function asyncIoBackendName returns "io_uring" or "pread/pwrite"
+//----------------------------------------------------------------
+const char* asyncIoBackendName();
+
+// Function asyncSubmit submits every queued operation
+// Throws an exception if the kernel refuses the submission
+//----------------------------------------------------------------
+void asyncSubmit();
+
+// Function asyncPoll runs the callbacks of completed operations without
+// waiting. Returns the number of operations completed.
+//----------------------------------------------------------------
+int asyncPoll();
+
+// Function asyncWaitAny submits everything queued, waits until at least
+// one operation has completed if any is in flight, and runs callbacks.
+// Returns the number of operations completed.
+//----------------------------------------------------------------
+int asyncWaitAny();
+
+// Function asyncWait submits everything queued and runs callbacks until
+// no operation is left in flight
+//----------------------------------------------------------------
+void asyncWait();
+
+//================================================================
+// Function asyncAppendOffset returns the file offset the next append to
+// the file will be written at
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+long long asyncAppendOffset(AsyncRecordFile& file);
+
+// Function asyncAppend queues bytes to be appended to the file. The data
+// is copied, so the caller's buffer may be reused at once. With sync set
+// the write is linked to an fdatasync. The callback gets the bytes written
+// or a negative errno.
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+void asyncAppend(AsyncRecordFile& file, const void* data, std::size_t bytes, bool sync, IoCallback done);
+
+// Function asyncReadAt queues a read of bytes at offset into buffer,
+// which must stay valid until the callback runs. The callback gets the
+// bytes read or a negative errno.
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+void asyncReadAt(AsyncRecordFile& file, void* buffer, std::size_t bytes, long long offset, IoCallback done);
+
+// Function asyncReadahead asks the kernel to start reading the whole file
+// into the page cache. No callback; failures are ignored.
+//----------------------------------------------------------------
+void asyncReadahead(AsyncRecordFile& file);
+
+// Function asyncSettle waits until no operation on the file is pending
+//----------------------------------------------------------------
+void asyncSettle(AsyncRecordFile& file);
+
+// Function asyncRecordFileClose settles the file and closes its descriptor
+//----------------------------------------------------------------
+void asyncRecordFileClose(AsyncRecordFile& file);
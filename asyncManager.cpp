@@ -0,0 +1,488 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: asyncManager.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - createReservationAsync refuses a vehicle size out of range, as
+ *          bookVehicle does
+ *
+ * Description: Implementation file of the AsyncManager module of the Ferry
+ *              Reservation System. A coroutine waiting for storage parks
+ *              its handle with the AsyncIo callback; the callback moves it
+ *              to the ready queue and the event loop resumes it, so no
+ *              coroutine is ever resumed from inside an I/O callback.
+ */
+//================================================================
+#include "asyncManager.hpp"
+#if defined(__cpp_impl_coroutine)
+#include "reservationManager.hpp"
+#include "reservationScan.hpp"
+#include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include "metrics.hpp"
+#include <cstring>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const int SCANBLOCKRECORDS = 4096; // Records read per block in scans
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static std::deque<std::coroutine_handle<> > ready; // Coroutines to resume
+static int sessions = 0; // Sessions spawned and not finished
+static std::map<std::string, Vehicle> registered; // Vehicles added while sessions run
+
+//================================================================
+// Struct: RecordAwaiter
+// Purpose: Suspends a coroutine on one storage call taking a
+// RecordCallback, resuming it from the event loop with the record count
+//----------------------------------------------------------------
+struct RecordAwaiter
+{
+    std::function<void(RecordCallback)> start;
+    int records;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> waiting)
+    {
+        start([this, waiting](int n)
+        {
+            records = n;
+            ready.push_back(waiting);
+        });
+    }
+    int await_resume() const noexcept { return records; }
+};
+
+//================================================================
+// Struct: DetachedSession
+// Purpose: Coroutine type of a session; starts from the ready queue and
+// frees itself when it finishes
+//----------------------------------------------------------------
+struct DetachedSession
+{
+    struct promise_type
+    {
+        struct Schedule
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) const { ready.push_back(h); }
+            void await_resume() const noexcept {}
+        };
+        DetachedSession get_return_object() { return DetachedSession(); }
+        Schedule initial_suspend() noexcept { return Schedule(); }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+//================================================================
+// Helper function sameKey compares a fixed-length field with a key
+//----------------------------------------------------------------
+static bool sameKey(const char field[], std::size_t size, const std::string& key)
+{
+    return std::strncmp(field, key.c_str(), size) == 0;
+}
+
+// Helper function findRegistered looks for a vehicle added by a session
+// since the event loop was last idle
+//----------------------------------------------------------------
+static bool findRegistered(const std::string& licence, Vehicle& found)
+{
+    std::map<std::string, Vehicle>::const_iterator added = registered.find(licence);
+    if (added == registered.end())
+    {
+        return false;
+    }
+    found = added->second;
+    return true;
+}
+
+// Helper function findVehicleAsync scans vehicles.dat in blocks for the
+// licence, unless the filter rules it out
+//----------------------------------------------------------------
+static task<bool> findVehicleAsync(std::string licence, Vehicle& found)
+{
+    if (findRegistered(licence, found))
+    {
+        co_return true;
+    }
+    if (!vehicleMayExist(licence.c_str()))
+    {
+        co_return false;
+    }
+    std::vector<Vehicle> block(SCANBLOCKRECORDS);
+    for (int first = 0; ; first += SCANBLOCKRECORDS)
+    {
+        int n = co_await RecordAwaiter{[&](RecordCallback done)
+        {
+            readVehiclesAsync(block.data(), first, SCANBLOCKRECORDS, done);
+        }, 0};
+        if (n < 0)
+        {
+            throw std::runtime_error("Cannot read vehicles.dat");
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            if (sameKey(block[i].vehicleLicence, sizeof(block[i].vehicleLicence), licence))
+            {
+                found = block[i];
+                co_return true;
+            }
+        }
+        if (n < SCANBLOCKRECORDS)
+        {
+            vehicleFilterFalsePositive();
+            co_return false;
+        }
+    }
+}
+
+// Helper function findReservationAsync scans reservations.dat in blocks
+// for the booking of the vehicle on the sailing, unless the filter rules
+// it out; recordNumber gets its position if given
+//----------------------------------------------------------------
+static task<bool> findReservationAsync(std::string sailingID, std::string licence, Reservation& found,
+                                       int* recordNumber = nullptr)
+{
+    if (!reservationMayExist(sailingID.c_str(), licence.c_str()))
+    {
+        co_return false;
+    }
+    std::vector<Reservation> block(SCANBLOCKRECORDS);
+    for (int first = 0; ; first += SCANBLOCKRECORDS)
+    {
+        int n = co_await RecordAwaiter{[&](RecordCallback done)
+        {
+            readReservationsAsync(block.data(), first, SCANBLOCKRECORDS, done);
+        }, 0};
+        if (n < 0)
+        {
+            throw std::runtime_error("Cannot read reservations.dat");
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            if (sameKey(block[i].sailingID, sizeof(block[i].sailingID), sailingID) &&
+                sameKey(block[i].vehicleLicence, sizeof(block[i].vehicleLicence), licence))
+            {
+                found = block[i];
+                if (recordNumber != nullptr)
+                {
+                    *recordNumber = first + i;
+                }
+                co_return true;
+            }
+        }
+        if (n < SCANBLOCKRECORDS)
+        {
+            reservationFilterFalsePositive();
+            co_return false;
+        }
+    }
+}
+
+// Helper function bookingAt copies the record at recordNumber into r and
+// returns true if it is still the booking; another session may have
+// checked it in or moved it with a swap delete since its block was read
+//----------------------------------------------------------------
+static bool bookingAt(int recordNumber, const std::string& sailingID, const std::string& licence, Reservation& r)
+{
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    RecordView<Reservation> records = reservations.records();
+    if (recordNumber < 0 || static_cast<std::size_t>(recordNumber) >= records.size())
+    {
+        return false;
+    }
+    r = records[static_cast<std::size_t>(recordNumber)];
+    return sameKey(r.sailingID, sizeof(r.sailingID), sailingID) &&
+           sameKey(r.vehicleLicence, sizeof(r.vehicleLicence), licence);
+}
+
+// Helper function returnLaneSpace gives length back to a lane of the
+// sailing after a booking that took it could not be written. The current
+// record is updated rather than the one read before the booking, since
+// other sessions may have booked on the sailing meanwhile
+//----------------------------------------------------------------
+static void returnLaneSpace(const std::string& sailingID, bool lowLane, float length)
+{
+    const SailingIndexEntry* entry = sailingIndexFind(sailingID.c_str());
+    if (entry == nullptr)
+    {
+        return;
+    }
+    Sailing s = entry->sailing;
+    if (lowLane)
+    {
+        s.lowRemainingLength += length;
+    }
+    else
+    {
+        s.highRemainingLength += length;
+    }
+    updateSailingRecord(s);
+}
+
+//================================================================
+// Function createReservationAsync books the vehicle on the sailing
+//----------------------------------------------------------------
+task<ReservationResult> createReservationAsync(std::string sailingID, Vehicle vehicle)
+{
+    ReservationResult result = {};
+    float taken = 0; // Lane length updated in the sailing and not yet booked
+    bool lowLane = false;
+    std::string addedVehicle; // Licence put in registered and not yet written
+    try
+    {
+        if (sailingIndexFind(sailingID.c_str()) == nullptr)
+        {
+            throw std::runtime_error("Sailing ID not found");
+        }
+        std::string licence(vehicle.vehicleLicence, strnlen(vehicle.vehicleLicence, sizeof(vehicle.vehicleLicence)));
+        Vehicle known;
+        bool isNewVehicle = !(co_await findVehicleAsync(licence, known));
+
+        // No suspension from here until the sailing is updated, so other
+        // sessions cannot take the same lane space. A session whose scan
+        // overlapped this one may have added the vehicle meanwhile.
+        if (isNewVehicle && findRegistered(licence, known))
+        {
+            isNewVehicle = false;
+        }
+        const Vehicle& v = isNewVehicle ? vehicle : known;
+        std::string sizeError = vehicleSizeError(v);
+        if (!sizeError.empty())
+        {
+            throw std::runtime_error(sizeError);
+        }
+        const SailingIndexEntry* entry = sailingIndexFind(sailingID.c_str());
+        if (entry == nullptr)
+        {
+            throw std::runtime_error("Sailing ID not found");
+        }
+        Sailing s = entry->sailing;
+        Reservation newRes = {};
+        std::memcpy(newRes.sailingID, s.sailingID, strnlen(s.sailingID, sizeof(newRes.sailingID) - 1));
+        std::memcpy(newRes.vehicleLicence, v.vehicleLicence, strnlen(v.vehicleLicence, sizeof(newRes.vehicleLicence) - 1));
+        newRes.onBoard = false;
+        bool lowVehicle = (v.vehicleHeight <= 2 && v.vehicleLength <= 7);
+        if (lowVehicle && v.vehicleLength <= s.lowRemainingLength)
+        {
+            s.lowRemainingLength -= v.vehicleLength;
+            newRes.isLRL = true;
+        }
+        else if (v.vehicleLength <= s.highRemainingLength)
+        {
+            s.highRemainingLength -= v.vehicleLength;
+            newRes.isLRL = false;
+        }
+        else
+        {
+            countMetric(capacityRejectionsTotal);
+            throw std::runtime_error("Insufficient space in both low and high roof lanes");
+        }
+        updateSailingRecord(s);
+        taken = v.vehicleLength;
+        lowLane = newRes.isLRL;
+
+        // Register a new vehicle first, then the booking, each synced
+        if (isNewVehicle)
+        {
+            registered[licence] = v;
+            addedVehicle = licence;
+            int written = co_await RecordAwaiter{[&](RecordCallback done)
+            {
+                appendVehiclesAsync(&v, 1, true, done);
+            }, 0};
+            if (written != 1)
+            {
+                throw std::runtime_error("Failed writing vehicle " + licence);
+            }
+            addedVehicle.clear();
+        }
+        int written = co_await RecordAwaiter{[&](RecordCallback done)
+        {
+            appendReservationsAsync(&newRes, 1, true, done);
+        }, 0};
+        if (written != 1)
+        {
+            throw std::runtime_error("Failed writing reservation for " + licence);
+        }
+        taken = 0;
+        countMetric(bookingsTotal);
+        result.ok = true;
+        result.reservation = newRes;
+    }
+    catch (const std::exception& e)
+    {
+        result.ok = false;
+        result.error = e.what();
+    }
+    if (!addedVehicle.empty())
+    {
+        registered.erase(addedVehicle);
+    }
+    if (taken > 0)
+    {
+        try
+        {
+            returnLaneSpace(sailingID, lowLane, taken);
+        }
+        catch (const std::exception& e)
+        {
+            result.error += std::string("; lane space not returned: ") + e.what();
+        }
+    }
+    co_return result;
+}
+
+// Function checkInAsync finds the reservation, writes its onBoard flag
+// and works out the fare
+//----------------------------------------------------------------
+task<ReservationResult> checkInAsync(std::string sailingID, std::string vehicleLicence)
+{
+    ReservationResult result = {};
+    try
+    {
+        int recordNumber = -1;
+        if (!(co_await findReservationAsync(sailingID, vehicleLicence, result.reservation, &recordNumber)))
+        {
+            throw std::runtime_error("Reservation not found for check in.");
+        }
+        // No suspension from here until the flag is written
+        if (!bookingAt(recordNumber, sailingID, vehicleLicence, result.reservation) &&
+            !findReservation(bookingQuery(sailingID.c_str(), vehicleLicence.c_str()), result.reservation, &recordNumber))
+        {
+            throw std::runtime_error("Reservation not found for check in.");
+        }
+        if (result.reservation.onBoard)
+        {
+            throw std::runtime_error("Already checked in");
+        }
+        markReservationsOnBoard(&recordNumber, 1);
+        result.reservation.onBoard = true;
+        countMetric(checkInsTotal);
+        if (result.reservation.isLRL)
+        {
+            result.fare = 14;
+        }
+        else
+        {
+            // Use the registered vehicle size
+            Vehicle v;
+            if (!(co_await findVehicleAsync(vehicleLicence, v)))
+            {
+                throw std::runtime_error("Vehicle not found for check in.");
+            }
+            result.fare = (v.vehicleLength * 2) + (v.vehicleHeight * 3);
+        }
+        result.ok = true;
+    }
+    catch (const std::exception& e)
+    {
+        result.ok = false;
+        result.error = e.what();
+    }
+    co_return result;
+}
+
+// Function deleteReservationAsync cancels one reservation
+//----------------------------------------------------------------
+task<ReservationResult> deleteReservationAsync(std::string sailingID, std::string vehicleLicence)
+{
+    ReservationResult result = {};
+    try
+    {
+        if (!(co_await findReservationAsync(sailingID, vehicleLicence, result.reservation)))
+        {
+            throw std::runtime_error("deleteReservation: Reservation with sailingID '" + sailingID +
+                                     "' and vehicleLicence '" + vehicleLicence + "' not found");
+        }
+
+        // The swap delete moves records, so it runs without suspending
+        char id[10] = {};
+        char licence[11] = {};
+        std::strncpy(id, sailingID.c_str(), sizeof(id) - 1);
+        std::strncpy(licence, vehicleLicence.c_str(), sizeof(licence) - 1);
+        deleteReservations(id, licence);
+        result.ok = true;
+    }
+    catch (const std::exception& e)
+    {
+        result.ok = false;
+        result.error = e.what();
+    }
+    co_return result;
+}
+
+//================================================================
+// Helper function runSession awaits one operation and reports its result
+//----------------------------------------------------------------
+static DetachedSession runSession(task<ReservationResult> operation, std::function<void(const ReservationResult&)> done)
+{
+    ReservationResult result = {};
+    try
+    {
+        result = co_await operation;
+    }
+    catch (const std::exception& e)
+    {
+        result.ok = false;
+        result.error = e.what();
+    }
+    // Scans only overlap while sessions run, so the added vehicles need
+    // remembering until the loop is idle
+    if (--sessions == 0)
+    {
+        registered.clear();
+    }
+    if (done)
+    {
+        done(result);
+    }
+}
+
+// Function spawnSession schedules an operation on the event loop
+//----------------------------------------------------------------
+void spawnSession(task<ReservationResult> operation, std::function<void(const ReservationResult&)> done)
+{
+    sessions++;
+    runSession(std::move(operation), std::move(done));
+}
+
+// Function runEventLoop resumes ready sessions and waits for I/O until
+// every session has finished
+//----------------------------------------------------------------
+void runEventLoop()
+{
+    while (sessions > 0 || !ready.empty())
+    {
+        while (!ready.empty())
+        {
+            std::coroutine_handle<> next = ready.front();
+            ready.pop_front();
+            next.resume();
+        }
+        if (sessions > 0 && asyncWaitAny() == 0 && ready.empty())
+        {
+            throw std::runtime_error("runEventLoop: sessions are waiting but no I/O is in flight");
+        }
+    }
+}
+
+// Function sessionsInFlight returns the number of unfinished sessions
+//----------------------------------------------------------------
+int sessionsInFlight()
+{
+    return sessions;
+}
+#endif
@@ -0,0 +1,144 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: asyncManager.hpp
+ *
+ * Description: Header file of the AsyncManager module of the Ferry
+ *              Reservation System. Coroutine versions of createReservation,
+ *              checkIn and deleteReservations that co_await the block reads
+ *              and appends of the AsyncIo module, and a single-threaded
+ *              event loop that keeps many such sessions (one per kiosk) in
+ *              flight at once.
+ *
+ * Design Issues: Needs C++20 coroutines; when built as C++17 the module
+ *                compiles to nothing
+ *                Sessions only interleave at co_await points, so each
+ *                capacity check and its sailing update run without a
+ *                suspension in between and cannot oversell a lane
+ *                Removing a reservation reorders the file, so that step
+ *                uses the synchronous deleteReservation after an async
+ *                scan has confirmed the booking
+ */
+//================================================================
+#pragma once
+#if defined(__cpp_impl_coroutine)
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+
+//================================================================
+// Struct: ReservationResult
+// Purpose: Outcome of one async manager operation
+//----------------------------------------------------------------
+struct ReservationResult
+{
+    bool ok; // Operation succeeded
+    std::string error; // Reason it failed
+    Reservation reservation; // Reservation made, checked in or removed
+    float fare; // Fare to collect, for check in
+};
+
+//================================================================
+// Class: task
+// Purpose: Lazily started coroutine producing a T, awaitable from other
+// coroutines; the awaiting coroutine resumes when the task finishes
+//----------------------------------------------------------------
+template <typename T>
+class task
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        task get_return_object()
+        {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                std::coroutine_handle<> next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume()
+    {
+        if (handle.promise().error)
+        {
+            std::rethrow_exception(handle.promise().error);
+        }
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+//================================================================
+// Function createReservationAsync books the vehicle on the sailing like
+// createReservation(sailingID, vehicle), reading vehicles.dat in blocks
+// and appending the records with a data sync through AsyncIo
+//----------------------------------------------------------------
+task<ReservationResult> createReservationAsync(std::string sailingID, Vehicle vehicle);
+
+// Function checkInAsync checks in the reservation and works out the fare
+// like checkIn(sailingID, vehicleLicence, false), scanning in blocks
+//----------------------------------------------------------------
+task<ReservationResult> checkInAsync(std::string sailingID, std::string vehicleLicence);
+
+// Function deleteReservationAsync cancels one reservation like
+// deleteReservations(sailingID, vehicleLicence)
+//----------------------------------------------------------------
+task<ReservationResult> deleteReservationAsync(std::string sailingID, std::string vehicleLicence);
+
+//================================================================
+// Function spawnSession schedules an operation on the event loop; done is
+// called with its result when it finishes
+//----------------------------------------------------------------
+void spawnSession(task<ReservationResult> operation, std::function<void(const ReservationResult&)> done);
+
+// Function runEventLoop runs sessions and I/O completions on the calling
+// thread until every session has finished
+//----------------------------------------------------------------
+void runEventLoop();
+
+// Function sessionsInFlight returns the number of unfinished sessions
+//----------------------------------------------------------------
+int sessionsInFlight();
+#endif
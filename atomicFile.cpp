@@ -0,0 +1,216 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: atomicFile.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Added appendDurably for append-only files
+ *
+ * Description: Implementation file of the AtomicFile module of the Ferry
+ *              Reservation System. Uses POSIX open/write/fdatasync/rename,
+ *              or _commit and MoveFileEx on Windows.
+ */
+//================================================================
+#include "atomicFile.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+  #include <io.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <windows.h>
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+#endif
+
+//================================================================
+// Helper function fail removes the temporary file and throws
+//----------------------------------------------------------------
+static void fail(const std::string& temporary, const std::string& message)
+{
+    std::remove(temporary.c_str());
+    throw std::runtime_error("rewriteAtomically: " + message + " (" + std::strerror(errno) + ")");
+}
+
+#ifndef _WIN32
+// Helper function syncDirectory syncs the directory holding fileName so a
+// rename in it survives a crash
+//----------------------------------------------------------------
+static void syncDirectory(const std::string& fileName)
+{
+    std::string::size_type slash = fileName.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : fileName.substr(0, slash + 1);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+#endif
+
+//================================================================
+// Function rewriteAtomically replaces the contents of fileName with the
+// given bytes through a synced temporary file and a rename
+//----------------------------------------------------------------
+void rewriteAtomically(const std::string& fileName, const void* data, std::size_t bytes)
+{
+    std::string temporary = fileName + ".tmp";
+    const char* next = static_cast<const char*>(data);
+#ifdef _WIN32
+    int fd = _open(temporary.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0)
+    {
+        fail(temporary, "cannot create " + temporary);
+    }
+    while (bytes > 0)
+    {
+        unsigned int chunk = bytes > (1u << 30) ? (1u << 30) : static_cast<unsigned int>(bytes);
+        int written = _write(fd, next, chunk);
+        if (written <= 0)
+        {
+            _close(fd);
+            fail(temporary, "cannot write " + temporary);
+        }
+        next += written;
+        bytes -= static_cast<std::size_t>(written);
+    }
+    if (_commit(fd) != 0)
+    {
+        _close(fd);
+        fail(temporary, "cannot sync " + temporary);
+    }
+    _close(fd);
+    if (!MoveFileExA(temporary.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        fail(temporary, "cannot replace " + fileName);
+    }
+#else
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fail(temporary, "cannot create " + temporary);
+    }
+    while (bytes > 0)
+    {
+        ssize_t written = ::write(fd, next, bytes);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            ::close(fd);
+            fail(temporary, "cannot write " + temporary);
+        }
+        next += written;
+        bytes -= static_cast<std::size_t>(written);
+    }
+#ifdef __APPLE__
+    int synced = ::fsync(fd);
+#else
+    int synced = ::fdatasync(fd);
+#endif
+    if (synced != 0)
+    {
+        ::close(fd);
+        fail(temporary, "cannot sync " + temporary);
+    }
+    if (::close(fd) != 0)
+    {
+        fail(temporary, "cannot close " + temporary);
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        fail(temporary, "cannot replace " + fileName);
+    }
+    syncDirectory(fileName);
+#endif
+}
+
+// Function appendDurably appends the bytes in one write and syncs them,
+// truncating back to the old size if the write or sync fails
+//----------------------------------------------------------------
+void appendDurably(const std::string& fileName, const void* data, std::size_t bytes)
+{
+    const char* next = static_cast<const char*>(data);
+#ifdef _WIN32
+    int fd = _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0)
+    {
+        throw std::runtime_error("appendDurably: cannot open " + fileName + " (" + std::strerror(errno) + ")");
+    }
+    __int64 oldSize = _lseeki64(fd, 0, SEEK_END);
+    bool ok = oldSize >= 0;
+    while (ok && bytes > 0)
+    {
+        unsigned int chunk = bytes > (1u << 30) ? (1u << 30) : static_cast<unsigned int>(bytes);
+        int written = _write(fd, next, chunk);
+        ok = written > 0;
+        if (ok)
+        {
+            next += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+    }
+    ok = ok && _commit(fd) == 0;
+    if (!ok)
+    {
+        int error = errno;
+        if (oldSize >= 0)
+        {
+            _chsize_s(fd, oldSize);
+        }
+        _close(fd);
+        throw std::runtime_error("appendDurably: cannot append to " + fileName + " (" + std::strerror(error) + ")");
+    }
+    _close(fd);
+#else
+    int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("appendDurably: cannot open " + fileName + " (" + std::strerror(errno) + ")");
+    }
+    off_t oldSize = ::lseek(fd, 0, SEEK_END);
+    bool ok = oldSize >= 0;
+    while (ok && bytes > 0)
+    {
+        ssize_t written = ::write(fd, next, bytes);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        ok = written > 0;
+        if (ok)
+        {
+            next += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+    }
+#ifdef __APPLE__
+    ok = ok && ::fsync(fd) == 0;
+#else
+    ok = ok && ::fdatasync(fd) == 0;
+#endif
+    if (!ok)
+    {
+        int error = errno;
+        if (oldSize >= 0 && ::ftruncate(fd, oldSize) == 0)
+        {
+            ::fsync(fd);
+        }
+        ::close(fd);
+        throw std::runtime_error("appendDurably: cannot append to " + fileName + " (" + std::strerror(error) + ")");
+    }
+    ::close(fd);
+    if (oldSize == 0)
+    {
+        syncDirectory(fileName); // the file may be new
+    }
+#endif
+}
@@ -0,0 +1,40 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: atomicFile.hpp
+ *
+ * Description: Header file of the AtomicFile module of the Ferry
+ *              Reservation System. Replaces the whole contents of a data
+ *              file so that after a crash the file holds either the old
+ *              or the new contents, never a mix or nothing.
+ *
+ * Design Issues: The new contents are written to FILE.tmp in one write,
+ *                synced to disk, then renamed over the original; rename
+ *                replaces the directory entry atomically
+ *                The storage modules close their stream before calling
+ *                rewriteAtomically and reopen it afterwards (see
+ *                rewriteSailings and friends)
+ *                appendDurably is for append-only files: a failed append
+ *                is cut back off, and a crash can only leave a torn tail,
+ *                which readers of such files must detect
+ */
+//================================================================
+#pragma once
+#include <cstddef>
+#include <string>
+
+//================================================================
+// Function rewriteAtomically replaces the contents of fileName with the
+// given bytes: one write to a temporary file, a data sync, and a rename
+// over the original. The directory is synced so the rename is durable.
+// Throws an exception if any step fails; the original is then unchanged
+//----------------------------------------------------------------
+void rewriteAtomically(const std::string& fileName, const void* data, std::size_t bytes);
+
+// Function appendDurably appends the given bytes to fileName, creating it
+// if needed, in one write followed by a data sync
+// Throws an exception if any step fails; the file is then cut back to
+// its old size
+//----------------------------------------------------------------
+void appendDurably(const std::string& fileName, const void* data, std::size_t bytes);
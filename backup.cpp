@@ -0,0 +1,322 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: backup.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the Backup module of the Ferry
+ *              Reservation System. A block changed if its 64 bit hash or
+ *              length differs from the same block in the previous
+ *              snapshot's manifest; unchanged blocks are referenced where
+ *              an earlier snapshot stored them, so restoring never walks
+ *              a chain of snapshots.
+ *
+ * Design Issues: Change detection reads the whole store but writes only
+ *                changed blocks, and needs no tracking in the storage
+ *                modules, so it also works after a restart
+ *                Copied blocks are appended to the blocks file through
+ *                appendDurably in 4MB batches; the manifest is replaced
+ *                with rewriteAtomically once they are all synced
+ */
+//================================================================
+#include "backup.hpp"
+#include "atomicFile.hpp"
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//============================================================
+// Module scope constants
+//------------------------------------------------------------
+static const std::size_t BLOCKBYTES = 64 * 1024; // Unit of change detection
+static const std::size_t BATCHBYTES = 4 << 20; // Copied bytes per synced append
+
+//============================================================
+// Struct: BlockRef
+// Purpose: Where a snapshot keeps one block of a data file
+//------------------------------------------------------------
+struct BlockRef
+{
+    std::uint64_t hash; // Hash of the block contents
+    int snapshot; // Snapshot whose blocks file holds it
+    long long offset; // Offset in that blocks file
+    std::size_t length; // Bytes in the block; the last may be short
+};
+
+// Struct: FileManifest
+// Purpose: The blocks of one data file in a snapshot
+//------------------------------------------------------------
+struct FileManifest
+{
+    std::string name; // Data file name
+    long long size; // Bytes in the file
+    std::vector<BlockRef> blocks; // Its blocks in file order
+};
+
+// Struct: CapturedFile
+// Purpose: Contents of a data file at the snapshot point
+//------------------------------------------------------------
+struct CapturedFile
+{
+    const char* name; // Data file name
+    const unsigned char* data; // Mapped contents
+    std::size_t size; // Whole records only
+};
+
+//================================================================
+// Helper function blockHash returns a 64 bit hash of the bytes, mixing
+// eight bytes at a time
+//----------------------------------------------------------------
+static std::uint64_t blockHash(const unsigned char* bytes, std::size_t length)
+{
+    std::uint64_t hash = 0x9e3779b97f4a7c15ull ^ length;
+    std::size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    for (; i < length; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+// Helper function snapshotPath returns backupDir/snapshot-NNNNNN.extension
+//----------------------------------------------------------------
+static std::string snapshotPath(const std::string& backupDir, int snapshot, const char extension[])
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "snapshot-%06d.%s", snapshot, extension);
+    return (std::filesystem::path(backupDir) / name).string();
+}
+
+// Helper function readManifest loads the manifest of a snapshot
+// Throws an exception if it is missing or malformed
+//----------------------------------------------------------------
+static std::vector<FileManifest> readManifest(const std::string& backupDir, int snapshot)
+{
+    std::string path = snapshotPath(backupDir, snapshot, "manifest");
+    std::ifstream in(path);
+    std::string line;
+    if (!in.is_open() || !std::getline(in, line) || line != "ferry-snapshot 1")
+    {
+        throw std::runtime_error("Snapshot " + std::to_string(snapshot) + " not found in " + backupDir + ".");
+    }
+    std::vector<FileManifest> files;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "file")
+        {
+            FileManifest file;
+            if (!(fields >> file.name >> file.size))
+            {
+                throw std::runtime_error(path + " is corrupt.");
+            }
+            files.push_back(file);
+        }
+        else if (kind == "block")
+        {
+            BlockRef block;
+            if (files.empty() || !(fields >> std::hex >> block.hash >> std::dec >> block.snapshot
+                                         >> block.offset >> block.length))
+            {
+                throw std::runtime_error(path + " is corrupt.");
+            }
+            files.back().blocks.push_back(block);
+        }
+    }
+    return files;
+}
+
+// Helper function findFile returns the manifest entry of a data file, or
+// nullptr if the snapshot does not have it
+//----------------------------------------------------------------
+static const FileManifest* findFile(const std::vector<FileManifest>& files, const char name[])
+{
+    for (const FileManifest& file : files)
+    {
+        if (file.name == name)
+        {
+            return &file;
+        }
+    }
+    return nullptr;
+}
+
+//================================================================
+// Function latestSnapshot finds the highest numbered manifest
+//----------------------------------------------------------------
+int latestSnapshot(const char backupDir[])
+{
+    int latest = 0;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(backupDir, error))
+    {
+        int number = 0;
+        char extension[16];
+        std::string name = entry.path().filename().string();
+        if (std::sscanf(name.c_str(), "snapshot-%d.%15s", &number, extension) == 2 &&
+            std::strcmp(extension, "manifest") == 0 && number > latest)
+        {
+            latest = number;
+        }
+    }
+    return latest;
+}
+
+// Function takeSnapshot maps the four files, copies the blocks that
+// differ from the parent snapshot and then writes the manifest
+//----------------------------------------------------------------
+SnapshotSummary takeSnapshot(const char backupDir[], bool incremental)
+{
+    TIME_FUNCTION("takeSnapshot");
+    std::filesystem::create_directories(backupDir);
+    SnapshotSummary summary = {};
+    int latest = latestSnapshot(backupDir);
+    summary.snapshot = latest + 1;
+    summary.parent = incremental ? latest : 0;
+    std::vector<FileManifest> parentFiles;
+    if (summary.parent > 0)
+    {
+        parentFiles = readManifest(backupDir, summary.parent);
+    }
+    std::string blocksPath = snapshotPath(backupDir, summary.snapshot, "blocks");
+    std::filesystem::remove(blocksPath); // left by an interrupted snapshot
+
+    // The snapshot point: nothing runs between these four calls
+    RecordSnapshot<Vessel> vessels = vesselSnapshot();
+    RecordSnapshot<Sailing> sailings = sailingSnapshot();
+    RecordSnapshot<Vehicle> vehicles = vehicleSnapshot();
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    const CapturedFile captured[] = {
+        {"vessels.dat", reinterpret_cast<const unsigned char*>(vessels.records().data()),
+         vessels.records().size() * sizeof(Vessel)},
+        {"sailings.dat", reinterpret_cast<const unsigned char*>(sailings.records().data()),
+         sailings.records().size() * sizeof(Sailing)},
+        {"vehicles.dat", reinterpret_cast<const unsigned char*>(vehicles.records().data()),
+         vehicles.records().size() * sizeof(Vehicle)},
+        {"reservations.dat", reinterpret_cast<const unsigned char*>(reservations.records().data()),
+         reservations.records().size() * sizeof(Reservation)}};
+
+    std::ostringstream manifest;
+    manifest << "ferry-snapshot 1\nparent " << summary.parent << "\n";
+    std::vector<unsigned char> batch;
+    batch.reserve(BATCHBYTES);
+    long long blocksFileSize = 0;
+    for (const CapturedFile& file : captured)
+    {
+        const FileManifest* previous = findFile(parentFiles, file.name);
+        manifest << "file " << file.name << " " << file.size << "\n";
+        summary.fileBytes += static_cast<long long>(file.size);
+        for (std::size_t offset = 0, i = 0; offset < file.size; offset += BLOCKBYTES, ++i)
+        {
+            BlockRef block;
+            block.length = std::min(BLOCKBYTES, file.size - offset);
+            block.hash = blockHash(file.data + offset, block.length);
+            summary.blocks++;
+            if (previous != nullptr && i < previous->blocks.size() &&
+                previous->blocks[i].hash == block.hash && previous->blocks[i].length == block.length)
+            {
+                block.snapshot = previous->blocks[i].snapshot;
+                block.offset = previous->blocks[i].offset;
+            }
+            else
+            {
+                block.snapshot = summary.snapshot;
+                block.offset = blocksFileSize;
+                batch.insert(batch.end(), file.data + offset, file.data + offset + block.length);
+                blocksFileSize += static_cast<long long>(block.length);
+                summary.changedBlocks++;
+                if (batch.size() >= BATCHBYTES)
+                {
+                    appendDurably(blocksPath, batch.data(), batch.size());
+                    batch.clear();
+                }
+            }
+            manifest << "block " << std::hex << block.hash << std::dec << " " << block.snapshot << " "
+                     << block.offset << " " << block.length << "\n";
+        }
+    }
+    if (!batch.empty())
+    {
+        appendDurably(blocksPath, batch.data(), batch.size());
+    }
+    std::string text = manifest.str();
+    rewriteAtomically(snapshotPath(backupDir, summary.snapshot, "manifest"), text.data(), text.size());
+    summary.copiedBytes = blocksFileSize + static_cast<long long>(text.size());
+
+    std::cout << "Snapshot " << summary.snapshot;
+    if (summary.parent > 0)
+    {
+        std::cout << " (incremental to " << summary.parent << ")";
+    }
+    std::cout << ": copied " << summary.changedBlocks << " of " << summary.blocks << " blocks, "
+              << summary.copiedBytes << " bytes for " << summary.fileBytes << " bytes of data" << std::endl;
+    return summary;
+}
+
+// Function restoreSnapshot reads every block of every file from the
+// blocks file that holds it, checks its hash and writes the file
+//----------------------------------------------------------------
+void restoreSnapshot(const char backupDir[], int snapshot, const char targetDir[])
+{
+    TIME_FUNCTION("restoreSnapshot");
+    std::vector<FileManifest> files = readManifest(backupDir, snapshot);
+    std::filesystem::create_directories(targetDir);
+    if (std::filesystem::equivalent(targetDir, std::filesystem::current_path()))
+    {
+        throw std::runtime_error("Cannot restore over the open data files; choose another directory.");
+    }
+    std::map<int, std::ifstream> blocksFiles;
+    for (const FileManifest& file : files)
+    {
+        std::vector<unsigned char> contents(static_cast<std::size_t>(file.size));
+        std::size_t position = 0;
+        for (const BlockRef& block : file.blocks)
+        {
+            std::ifstream& in = blocksFiles[block.snapshot];
+            if (!in.is_open())
+            {
+                in.open(snapshotPath(backupDir, block.snapshot, "blocks"), std::ios::binary);
+            }
+            if (position + block.length > contents.size() || !in.seekg(block.offset) ||
+                !in.read(reinterpret_cast<char*>(contents.data() + position), static_cast<std::streamsize>(block.length)) ||
+                blockHash(contents.data() + position, block.length) != block.hash)
+            {
+                throw std::runtime_error("Snapshot " + std::to_string(snapshot) + ": block of " + file.name +
+                                         " at " + std::to_string(position) + " is missing or damaged.");
+            }
+            position += block.length;
+        }
+        if (position != contents.size())
+        {
+            throw std::runtime_error("Snapshot " + std::to_string(snapshot) + ": " + file.name + " is incomplete.");
+        }
+        rewriteAtomically((std::filesystem::path(targetDir) / file.name).string(), contents.data(), contents.size());
+    }
+    std::cout << "Restored snapshot " << snapshot << " to " << targetDir << std::endl;
+}
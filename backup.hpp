@@ -0,0 +1,63 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: backup.hpp
+ *
+ * Description: Header file of the Backup module of the Ferry
+ *              Reservation System. Takes point-in-time snapshots of the
+ *              four data files into a backup directory while the program
+ *              keeps running, and restores them into another directory.
+ *              An incremental snapshot only stores the 64KB blocks that
+ *              changed since the previous snapshot.
+ *              The storage modules must be opened first.
+ *
+ * Design Issues: A snapshot is taken between two requests: every file is
+ *                flushed, pending async writes are settled and the four
+ *                files are mapped back to back, so no booking can land
+ *                in some files and not others
+ *                The sailing index and Bloom filters are not copied; they
+ *                are rebuilt from the restored files when those are opened
+ *                Each snapshot N is snapshot-N.blocks, the blocks it
+ *                copied, and snapshot-N.manifest, which names the
+ *                snapshot and offset holding every block of every file.
+ *                The manifest is written last, so a snapshot without one
+ *                was interrupted and is ignored
+ */
+//================================================================
+#pragma once
+
+//================================================================
+// Struct: SnapshotSummary
+// Purpose: What one snapshot stored
+//----------------------------------------------------------------
+struct SnapshotSummary
+{
+    int snapshot; // Number of the snapshot taken
+    int parent; // Snapshot it is incremental to, 0 for a full snapshot
+    long long fileBytes; // Size of the data files captured
+    long long copiedBytes; // Bytes written to the backup directory
+    int blocks; // Blocks in the data files
+    int changedBlocks; // Blocks copied
+};
+
+//================================================================
+// Function takeSnapshot writes a snapshot of the data files to backupDir,
+// creating it if needed. If incremental is set and backupDir has a
+// snapshot, only blocks that differ from that snapshot are copied
+// Prints the blocks and bytes copied
+// Throws an exception if the backup cannot be written
+//----------------------------------------------------------------
+SnapshotSummary takeSnapshot(const char backupDir[], bool incremental);
+
+// Function latestSnapshot returns the number of the newest complete
+// snapshot in backupDir, or 0 if it has none
+//----------------------------------------------------------------
+int latestSnapshot(const char backupDir[]);
+
+// Function restoreSnapshot rebuilds the data files of a snapshot in
+// targetDir, creating it if needed
+// Throws an exception if the snapshot is missing or damaged, or if
+// targetDir is the working directory, whose files are open
+//----------------------------------------------------------------
+void restoreSnapshot(const char backupDir[], int snapshot, const char targetDir[]);
@@ -0,0 +1,542 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: benchmark.cpp
+*
+* Revision History:
+* Rev. 2 - 26/10/18 Modified by L. Xu
+* - Stores come from the DataGenerator module
+* - Compares fstream writes with the AsyncIo pread/pwrite and io_uring
+*   backends for appends, synced appends and block scans
+* - Times batches of concurrent AsyncManager sessions when built as C++20
+* - Counts heap allocations per operation
+* - The array forms of operator new and delete are counted too
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Benchmark: Storage and manager layer speed
+* Builds synthetic stores of increasing size and times the main
+* storage and manager paths on each, printing the results as JSON
+* so that builds can be compared.
+*
+* Usage: benchmark [maxRecords] [outputFile]
+* - maxRecords is the largest store in reservations (default 100000,
+*   up to 10000000); sizes go up by 10x from 1000
+* - results go to outputFile, or to standard output
+*
+* Each store is generated with the default season options in its own
+* bench-<size> directory.
+* Every path runs for at most MAXOPS operations or TIMEBUDGET seconds.
+* Per-operation latency gives ops/s, p50 and p99; bytes of I/O come
+* from the process read/write counters where the system has them.
+* Heap allocations are counted by replacing the global operator new.
+*/
+//============================================================
+
+#include "sailing.hpp"
+#include "sailingManager.hpp"
+#include "reservation.hpp"
+#include "reservationManager.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include "dataGenerator.hpp"
+#include "asyncIo.hpp"
+#include "asyncManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+    #include <direct.h>
+    #define chdir _chdir
+#else
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const int MAXOPS = 1000; // operations per path
+static const double TIMEBUDGET = 2.0; // seconds per path
+static const double MAXREPORTWORK = 2e9; // sailings x reservations for the report
+static const int APPENDBATCH = 32; // reservations appended per operation
+static const int SCANBLOCK = 4096; // reservations per block in async scans
+static const char BENCHSAILING[] = "ZZZ-99-99"; // sailing of the appended bookings
+static const int SESSIONS = 64; // coroutine sessions in flight per operation
+
+//============================================================
+// Struct: BenchResult
+// Purpose: Timing and I/O of one path on one store size
+//------------------------------------------------------------
+struct BenchResult
+{
+    std::string name; // path being timed
+    long ops; // operations run
+    double seconds; // total time of all operations
+    double p50; // median latency (ms)
+    double p99; // 99th percentile latency (ms)
+    long long readBytes; // bytes read by the process
+    long long writeBytes; // bytes written by the process
+    long long allocations; // heap allocations made by the operations
+    bool skipped; // path too slow to run at this size
+};
+
+// Struct: NullBuffer
+// Purpose: Discards the console output of the manager functions
+//------------------------------------------------------------
+struct NullBuffer : std::streambuf
+{
+    int overflow(int c) override { return c; }
+};
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static long long allocationCount = 0; // heap allocations so far
+
+//============================================================
+// Replacement global operator new and delete, counting allocations.
+// The array forms are replaced too so every new pairs with a matching
+// delete. GCC inlines these into each other and then warns that free()
+// is given memory from operator new; they all use malloc and free, so
+// the warning does not apply here.
+//------------------------------------------------------------
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(std::size_t bytes)
+{
+    allocationCount++;
+    void* block = std::malloc(bytes > 0 ? bytes : 1);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new[](std::size_t bytes)
+{
+    return operator new(bytes);
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+#pragma GCC diagnostic pop
+
+//============================================================
+// Function readIoCounters reads the bytes read and written by this
+// process, or zeros if the system does not report them
+//------------------------------------------------------------
+static void readIoCounters(long long& readBytes, long long& writeBytes)
+{
+    readBytes = 0;
+    writeBytes = 0;
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    long long value;
+    while (io >> key >> value)
+    {
+        if (key == "rchar:")
+        {
+            readBytes = value;
+        }
+        else if (key == "wchar:")
+        {
+            writeBytes = value;
+        }
+    }
+}
+
+// Function timePath runs op(i) until MAXOPS operations or TIMEBUDGET
+// seconds have passed, and collects the latency and I/O of the runs
+//------------------------------------------------------------
+template <typename Operation>
+static BenchResult timePath(const char name[], long maxOps, Operation op)
+{
+    BenchResult result = {name, 0, 0.0, 0.0, 0.0, 0, 0, 0, false};
+    std::vector<double> latencies;
+    long long readBefore, writeBefore, readAfter, writeAfter;
+    readIoCounters(readBefore, writeBefore);
+    while (result.ops < maxOps && result.seconds < TIMEBUDGET)
+    {
+        long long allocationsBefore = allocationCount;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        op(result.ops);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.allocations += allocationCount - allocationsBefore;
+        latencies.push_back(seconds * 1000);
+        result.seconds += seconds;
+        result.ops++;
+    }
+    readIoCounters(readAfter, writeAfter);
+    result.readBytes = readAfter - readBefore;
+    result.writeBytes = writeAfter - writeBefore;
+    std::sort(latencies.begin(), latencies.end());
+    if (!latencies.empty())
+    {
+        result.p50 = latencies[latencies.size() / 2];
+        result.p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    }
+    return result;
+}
+
+// Function skippedPath records a path that was not run at this size
+//------------------------------------------------------------
+static BenchResult skippedPath(const char name[])
+{
+    BenchResult result = {name, 0, 0.0, 0.0, 0.0, 0, 0, 0, true};
+    return result;
+}
+
+// Function benchAsyncIo times appends and block scans of the reservation
+// file through fstream and through each AsyncIo backend
+//------------------------------------------------------------
+static void benchAsyncIo(std::vector<BenchResult>& results)
+{
+    std::vector<Reservation> batch(APPENDBATCH);
+    for (int i = 0; i < APPENDBATCH; ++i)
+    {
+        batch[i] = Reservation();
+        std::strcpy(batch[i].sailingID, BENCHSAILING);
+        std::snprintf(batch[i].vehicleLicence, sizeof(batch[i].vehicleLicence), "ASY%04d", i);
+    }
+
+    results.push_back(timePath("writeReservation x32 (fstream)", MAXOPS, [&](long)
+    {
+        for (const Reservation& r : batch)
+        {
+            writeReservation(r, false);
+        }
+    }));
+
+    const char* backends[] = {"pread/pwrite", "io_uring"};
+    for (int b = 0; b < 2; ++b)
+    {
+        asyncIoStart(b == 1, 256);
+        if (b == 1 && asyncIoBackend() != uringBackend)
+        {
+            results.push_back(skippedPath("appendReservationsAsync x32 (io_uring)"));
+            results.push_back(skippedPath("appendReservationsAsync x32 + fdatasync (io_uring)"));
+            results.push_back(skippedPath("readReservationsAsync scan (io_uring)"));
+            continue;
+        }
+        for (int sync = 0; sync < 2; ++sync)
+        {
+            std::string name = std::string("appendReservationsAsync x32") + (sync ? " + fdatasync" : "")
+                             + " (" + backends[b] + ")";
+            results.push_back(timePath(name.c_str(), MAXOPS, [&](long)
+            {
+                // One operation per record, the last one linked to the sync
+                for (int i = 0; i < APPENDBATCH; ++i)
+                {
+                    appendReservationsAsync(&batch[i], 1, sync == 1 && i == APPENDBATCH - 1, nullptr);
+                }
+                asyncWait();
+            }));
+            results.back().name = name;
+        }
+
+        // Queue every block of the file, then wait for them all
+        std::ifstream file("reservations.dat", std::ios::binary | std::ios::ate);
+        int records = static_cast<int>(file.tellg() / static_cast<std::streamoff>(sizeof(Reservation)));
+        std::vector<Reservation> blocks(records);
+        std::string name = std::string("readReservationsAsync scan (") + backends[b] + ")";
+        results.push_back(timePath(name.c_str(), MAXOPS, [&](long)
+        {
+            long read = 0;
+            for (int first = 0; first < records; first += SCANBLOCK)
+            {
+                readReservationsAsync(&blocks[first], first, std::min(SCANBLOCK, records - first), [&read](int n)
+                {
+                    read += n;
+                });
+            }
+            asyncWait();
+            if (read != records)
+            {
+                throw std::runtime_error("async scan read " + std::to_string(read) + " of " + std::to_string(records));
+            }
+        }));
+        results.back().name = name;
+    }
+    asyncIoStop();
+    deleteSailingReservations(BENCHSAILING);
+}
+
+// Function benchSessions books and cancels SESSIONS vehicles at a time on
+// the roomy sailings through the AsyncManager event loop
+//------------------------------------------------------------
+static void benchSessions(std::vector<BenchResult>& results, const std::vector<Sailing>& roomy)
+{
+#if defined(__cpp_impl_coroutine)
+    std::vector<std::pair<std::string, std::string> > booked;
+    long maxOps = std::min(static_cast<long>(roomy.size()) / SESSIONS, static_cast<long>(MAXOPS));
+    results.push_back(timePath("createReservationAsync x64 sessions", maxOps, [&](long i)
+    {
+        for (int k = 0; k < SESSIONS; ++k)
+        {
+            long n = i * SESSIONS + k;
+            Vehicle v = {};
+            std::snprintf(v.vehicleLicence, sizeof(v.vehicleLicence), "COR%07ld", n);
+            std::strcpy(v.phone, "604-555-0199");
+            v.vehicleLength = 5.0f;
+            v.vehicleHeight = 1.8f;
+            std::string sailingID = roomy[n].sailingID;
+            spawnSession(createReservationAsync(sailingID, v), [&booked, sailingID](const ReservationResult& r)
+            {
+                if (r.ok)
+                {
+                    booked.push_back(std::make_pair(sailingID, std::string(r.reservation.vehicleLicence)));
+                }
+            });
+        }
+        runEventLoop();
+    }));
+
+    std::size_t next = 0;
+    results.push_back(timePath("deleteReservationAsync x64 sessions", (booked.size() + SESSIONS - 1) / SESSIONS, [&](long)
+    {
+        for (int k = 0; k < SESSIONS && next < booked.size(); ++k, ++next)
+        {
+            spawnSession(deleteReservationAsync(booked[next].first, booked[next].second), nullptr);
+        }
+        runEventLoop();
+    }));
+#else
+    (void)roomy;
+    results.push_back(skippedPath("createReservationAsync x64 sessions"));
+    results.push_back(skippedPath("deleteReservationAsync x64 sessions"));
+#endif
+}
+
+// Function benchStore builds one store and times every path on it
+//------------------------------------------------------------
+static std::vector<BenchResult> benchStore(long records)
+{
+    GeneratorResult store = generateData(defaultGeneratorOptions(records));
+
+    vehicleOpen();
+    vesselOpen();
+    reservationOpen();
+    sailingOpen();
+
+    // Keys used by the paths: every sailing, the sailings with room for
+    // another car, and an even sample of the bookings
+    std::vector<Sailing> sailings, roomy;
+    std::vector<Reservation> bookings;
+    Sailing s;
+    sailingReset();
+    while (getNextSailing(s))
+    {
+        sailings.push_back(s);
+        if (s.lowRemainingLength >= 10)
+        {
+            roomy.push_back(s);
+        }
+    }
+    Reservation r;
+    long stride = std::max(1L, store.reservations / MAXOPS);
+    reservationReset();
+    for (long n = 0; getNextReservation(r); ++n)
+    {
+        if (n % stride == 0)
+        {
+            bookings.push_back(r);
+        }
+    }
+
+    std::vector<BenchResult> results;
+    char sailingID[10];
+    char licence[11];
+
+    results.push_back(timePath("getNextSailing scan", MAXOPS, [&](long)
+    {
+        sailingReset();
+        while (getNextSailing(s))
+        {
+        }
+    }));
+
+    results.push_back(timePath("checkSailingExists", MAXOPS, [&](long i)
+    {
+        std::strcpy(sailingID, sailings[(i * 7919) % sailings.size()].sailingID);
+        checkSailingExists(sailingID);
+    }));
+
+    results.push_back(timePath("createReservation", std::min(roomy.size(), static_cast<std::size_t>(MAXOPS)), [&](long i)
+    {
+        Vehicle v = {};
+        std::snprintf(v.vehicleLicence, sizeof(v.vehicleLicence), "NEW%07ld", i);
+        std::strcpy(v.phone, "604-555-0199");
+        v.vehicleLength = 5.0f;
+        v.vehicleHeight = 1.8f;
+        std::strcpy(sailingID, roomy[i].sailingID);
+        createReservation(sailingID, v);
+    }));
+    long created = results.back().ops;
+
+    results.push_back(timePath("deleteReservation", created, [&](long i)
+    {
+        std::snprintf(licence, sizeof(licence), "NEW%07ld", i);
+        std::strcpy(sailingID, roomy[i].sailingID);
+        deleteReservations(sailingID, licence);
+    }));
+
+    benchSessions(results, roomy);
+
+    results.push_back(timePath("checkIn", static_cast<long>(bookings.size()), [&](long i)
+    {
+        std::strcpy(sailingID, bookings[i].sailingID);
+        std::strcpy(licence, bookings[i].vehicleLicence);
+        checkIn(sailingID, licence, false);
+    }));
+
+    results.push_back(timePath("updateSailing", MAXOPS, [&](long i)
+    {
+        std::strcpy(sailingID, sailings[(i * 7919) % sailings.size()].sailingID);
+        updateSailing(sailingID, 0);
+    }));
+
+    if (static_cast<double>(store.sailings) * store.reservations <= MAXREPORTWORK)
+    {
+        results.push_back(timePath("printSailingReport", MAXOPS, [&](long)
+        {
+            char printerName[] = "benchmark";
+            printSailingReport(printerName);
+        }));
+    }
+    else
+    {
+        results.push_back(skippedPath("printSailingReport"));
+    }
+
+    benchAsyncIo(results);
+
+    // Runs last since it removes bookings
+    results.push_back(timePath("deleteReservations(sailingID)", std::min(sailings.size(), static_cast<std::size_t>(MAXOPS)), [&](long i)
+    {
+        std::strcpy(sailingID, sailings[i].sailingID);
+        deleteReservations(sailingID);
+    }));
+
+    vehicleClose();
+    vesselClose();
+    reservationClose();
+    sailingClose();
+    return results;
+}
+
+// Function writeJson prints all results as a JSON document
+//------------------------------------------------------------
+static void writeJson(std::ostream& out, const std::vector<std::pair<long, std::vector<BenchResult> > >& runs)
+{
+    out << "{\n  \"benchmark\": \"ferry storage and manager\",\n  \"stores\": [";
+    for (std::size_t r = 0; r < runs.size(); ++r)
+    {
+        out << (r == 0 ? "\n" : ",\n") << "    {\"records\": " << runs[r].first << ", \"paths\": [";
+        const std::vector<BenchResult>& results = runs[r].second;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult& b = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "      {\"name\": \"" << b.name << "\"";
+            if (b.skipped)
+            {
+                out << ", \"skipped\": true}";
+                continue;
+            }
+            out << ", \"ops\": " << b.ops
+                << ", \"opsPerSec\": " << (b.seconds > 0 ? b.ops / b.seconds : 0.0)
+                << ", \"p50Ms\": " << b.p50
+                << ", \"p99Ms\": " << b.p99
+                << ", \"readBytes\": " << b.readBytes
+                << ", \"writeBytes\": " << b.writeBytes
+                << ", \"allocsPerOp\": " << (b.ops > 0 ? static_cast<double>(b.allocations) / b.ops : 0.0) << "}";
+        }
+        out << "\n    ]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+//============================================================
+// Function main runs the benchmark for every store size
+//------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    long maxRecords = argc > 1 ? std::atol(argv[1]) : 100000;
+    if (maxRecords < 1000 || maxRecords > 10000000)
+    {
+        std::cerr << "maxRecords must be between 1000 and 10000000\n";
+        return 1;
+    }
+
+    std::vector<std::pair<long, std::vector<BenchResult> > > runs;
+    NullBuffer nullBuffer;
+    std::streambuf* console = std::cout.rdbuf();
+    try
+    {
+        for (long records = 1000; records <= maxRecords; records *= 10)
+        {
+            std::cerr << "Benchmarking " << records << " records..." << std::endl;
+            std::string directory = "bench-" + std::to_string(records);
+#ifdef _WIN32
+            _mkdir(directory.c_str());
+#else
+            mkdir(directory.c_str(), 0755);
+#endif
+            if (chdir(directory.c_str()) != 0)
+            {
+                throw std::runtime_error("Cannot enter " + directory);
+            }
+            std::cout.rdbuf(&nullBuffer);
+            runs.push_back(std::make_pair(records, benchStore(records)));
+            std::cout.rdbuf(console);
+            if (chdir("..") != 0)
+            {
+                throw std::runtime_error("Cannot leave " + directory);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout.rdbuf(console);
+        std::cerr << "Problem with benchmark: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (argc > 2)
+    {
+        std::ofstream out(argv[2]);
+        writeJson(out, runs);
+    }
+    else
+    {
+        writeJson(std::cout, runs);
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: bloomFilter.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the BloomFilter module of the
+ *              Ferry Reservation System. One 64-bit FNV-1a hash per key;
+ *              the bit positions come from double hashing its two halves.
+ */
+//================================================================
+#include "bloomFilter.hpp"
+#include <algorithm>
+#include <cmath>
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const std::size_t BITSPERKEY = 10; // About 1% false positives
+static const int HASHES = 7; // Optimal for 10 bits per key
+static const std::size_t MINCAPACITY = 1024; // Smallest filter, in keys
+
+//================================================================
+// Helper function registry returns the list of live filters
+//----------------------------------------------------------------
+static std::vector<const BloomFilter*>& registry()
+{
+    static std::vector<const BloomFilter*> filters;
+    return filters;
+}
+
+// Helper function hashKey returns the FNV-1a hash of the key
+//----------------------------------------------------------------
+static std::uint64_t hashKey(const char key[], std::size_t length)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//================================================================
+// Constructor registers an empty filter
+//----------------------------------------------------------------
+BloomFilter::BloomFilter(const char name[])
+    : filterName(name), capacity(0), keyCount(0), queryCount(0), missCount(0), falsePositives(0)
+{
+    reset(MINCAPACITY);
+    registry().push_back(this);
+}
+
+// Destructor removes the filter from the registry
+//----------------------------------------------------------------
+BloomFilter::~BloomFilter()
+{
+    std::vector<const BloomFilter*>& filters = registry();
+    filters.erase(std::remove(filters.begin(), filters.end(), this), filters.end());
+}
+
+// Function reset empties the filter with room for capacity keys, using a
+// power of two number of bits so positions are found with a mask
+//----------------------------------------------------------------
+void BloomFilter::reset(std::size_t keys)
+{
+    capacity = std::max(keys, MINCAPACITY);
+    std::size_t bitCount = 64;
+    while (bitCount < capacity * BITSPERKEY)
+    {
+        bitCount *= 2;
+    }
+    words.assign(bitCount / 64, 0);
+    keyCount = 0;
+}
+
+// Function add sets the key's bits
+//----------------------------------------------------------------
+void BloomFilter::add(const char key[], std::size_t length)
+{
+    std::uint64_t hash = hashKey(key, length);
+    std::uint64_t h1 = hash & 0xffffffffULL;
+    std::uint64_t h2 = (hash >> 32) | 1;
+    std::uint64_t mask = bits() - 1;
+    for (int i = 0; i < HASHES; ++i)
+    {
+        std::uint64_t bit = (h1 + i * h2) & mask;
+        words[bit / 64] |= 1ULL << (bit % 64);
+    }
+    keyCount++;
+}
+
+// Function mayContain checks the key's bits
+//----------------------------------------------------------------
+bool BloomFilter::mayContain(const char key[], std::size_t length)
+{
+    queryCount++;
+    std::uint64_t hash = hashKey(key, length);
+    std::uint64_t h1 = hash & 0xffffffffULL;
+    std::uint64_t h2 = (hash >> 32) | 1;
+    std::uint64_t mask = bits() - 1;
+    for (int i = 0; i < HASHES; ++i)
+    {
+        std::uint64_t bit = (h1 + i * h2) & mask;
+        if ((words[bit / 64] & (1ULL << (bit % 64))) == 0)
+        {
+            missCount++;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function observedFalsePositiveRate is false positives over all lookups
+// of absent keys, or 0 before any
+//----------------------------------------------------------------
+double BloomFilter::observedFalsePositiveRate() const
+{
+    long long absent = missCount + falsePositives;
+    return absent > 0 ? static_cast<double>(falsePositives) / absent : 0.0;
+}
+
+// Function expectedFalsePositiveRate is (1 - e^(-kn/m))^k
+//----------------------------------------------------------------
+double BloomFilter::expectedFalsePositiveRate() const
+{
+    double fill = 1.0 - std::exp(-static_cast<double>(HASHES) * keyCount / bits());
+    return std::pow(fill, HASHES);
+}
+
+//================================================================
+// Function bloomFilters returns the registry
+//----------------------------------------------------------------
+const std::vector<const BloomFilter*>& bloomFilters()
+{
+    return registry();
+}
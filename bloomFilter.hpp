@@ -0,0 +1,80 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: bloomFilter.hpp
+ *
+ * Description: Header file of the BloomFilter module of the Ferry
+ *              Reservation System. A Bloom filter answers "certainly not
+ *              stored" or "maybe stored" for a key in a few memory reads,
+ *              so lookups of keys that are not there can skip the scan of
+ *              the data file.
+ *
+ * Design Issues: Keys cannot be removed; a deleted record leaves its bits
+ *                set, which can only cause false positives, never a
+ *                wrongly skipped scan. The owner rebuilds the filter from
+ *                its file when records are removed in bulk.
+ *                Sized at 10 bits per key with 7 hash functions, about a
+ *                1% false-positive rate at capacity; full() tells the
+ *                owner when to rebuild it larger
+ *                Every filter registers itself by name so the Stats and
+ *                Metrics modules can report its false-positive rate
+ */
+//================================================================
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//================================================================
+// Class: BloomFilter
+// Purpose: Set of byte-string keys with no false negatives
+//----------------------------------------------------------------
+class BloomFilter
+{
+public:
+    // Registers the filter under name, which must outlive it
+    explicit BloomFilter(const char name[]);
+    ~BloomFilter();
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+
+    // Function reset empties the filter, sized for capacity keys
+    void reset(std::size_t capacity);
+    // Function add inserts a key
+    void add(const char key[], std::size_t length);
+    // Function mayContain returns false if the key was certainly never added
+    bool mayContain(const char key[], std::size_t length);
+    // Function noteFalsePositive records that a key reported as maybe
+    // stored turned out not to be
+    void noteFalsePositive() { falsePositives++; }
+    // Function full returns true once more keys were added than it was sized for
+    bool full() const { return keyCount > capacity; }
+
+    const char* name() const { return filterName; }
+    std::size_t keys() const { return keyCount; }
+    std::size_t bits() const { return words.size() * 64; }
+    long long queries() const { return queryCount; }
+    long long definiteMisses() const { return missCount; }
+    long long falsePositiveCount() const { return falsePositives; }
+    // Function observedFalsePositiveRate returns the fraction of lookups of
+    // absent keys that the filter let through
+    double observedFalsePositiveRate() const;
+    // Function expectedFalsePositiveRate returns the rate predicted from
+    // the keys, bits and hash functions
+    double expectedFalsePositiveRate() const;
+
+private:
+    const char* filterName; // Name in reports
+    std::vector<std::uint64_t> words; // Bit array
+    std::size_t capacity; // Keys it was sized for
+    std::size_t keyCount; // Keys added since the last reset
+    long long queryCount; // Calls of mayContain
+    long long missCount; // Lookups answered "certainly not"
+    long long falsePositives; // Lookups answered "maybe" wrongly
+};
+
+//================================================================
+// Function bloomFilters returns every registered filter
+//----------------------------------------------------------------
+const std::vector<const BloomFilter*>& bloomFilters();
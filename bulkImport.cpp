@@ -0,0 +1,508 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: bulkImport.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Counted imported bookings and capacity rejections in the
+ *          Metrics module
+ *        - Sailing updates are written with one flush
+ *
+ * Description: Implementation file of the BulkImport module of the Ferry
+ *              Reservation System. CSV files are read in 1MB chunks and
+ *              split into lines and fields as string views into the chunk,
+ *              so rows are never copied until they become records.
+ *              Vehicles are checked against a hash table of the registry,
+ *              reservations are grouped by sailing so each sailing's lane
+ *              space is updated once, and new records are appended to the
+ *              data files in large blocks.
+ *
+ * Design Issues: The vehicle registry and the pending reservations are
+ *                held in memory for the duration of an import
+ *                Checking for existing bookings is one pass over
+ *                reservations.dat
+ */
+//================================================================
+#include "bulkImport.hpp"
+#include "vehicle.hpp"
+#include "reservation.hpp"
+#include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include "stats.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//============================================================
+// Module scope constants
+//------------------------------------------------------------
+static const std::size_t CHUNKSIZE = 1 << 20; // bytes read from the CSV at a time
+static const int BATCHSIZE = 65536; // records appended per write
+static const int MAXFIELDS = 8; // fields looked at per CSV row
+
+//============================================================
+// Struct: CsvStream
+// Purpose: Chunked reader that hands out lines as views into its buffer
+//------------------------------------------------------------
+struct CsvStream
+{
+    std::FILE* file; // CSV file being read
+    std::vector<char> buffer; // current chunk, holds at least one whole line
+    std::size_t pos; // start of the next unread line
+    std::size_t end; // end of valid data in buffer
+    bool eof; // no more data in the file
+    long bytesRead; // total bytes read so far
+};
+
+// Struct: PendingReservation
+// Purpose: Parsed reservation row waiting for its sailing group
+//------------------------------------------------------------
+struct PendingReservation
+{
+    Reservation reservation; // record to append if accepted
+    int lineNumber; // CSV line, for reporting rejects
+};
+
+//================================================================
+// Helper function csvOpen opens a CSV file for chunked reading
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+static void csvOpen(CsvStream& csv, const char fileName[])
+{
+    csv.file = std::fopen(fileName, "rb");
+    if (csv.file == nullptr)
+    {
+        throw std::runtime_error(std::string("Cannot open ") + fileName + ".");
+    }
+    csv.buffer.resize(CHUNKSIZE);
+    csv.pos = 0;
+    csv.end = 0;
+    csv.eof = false;
+    csv.bytesRead = 0;
+}
+
+// Helper function csvNextLine returns the next line without its line ending
+// The view stays valid until the next call
+// Returns false at the end of the file
+//----------------------------------------------------------------
+static bool csvNextLine(CsvStream& csv, std::string_view& line)
+{
+    while (true)
+    {
+        char* data = csv.buffer.data();
+        const char* newline = static_cast<const char*>(std::memchr(data + csv.pos, '\n', csv.end - csv.pos));
+        if (newline != nullptr || (csv.eof && csv.pos < csv.end))
+        {
+            std::size_t lineEnd = newline != nullptr ? static_cast<std::size_t>(newline - data) : csv.end;
+            line = std::string_view(data + csv.pos, lineEnd - csv.pos);
+            csv.pos = newline != nullptr ? lineEnd + 1 : csv.end;
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            return true;
+        }
+        if (csv.eof)
+        {
+            return false;
+        }
+
+        // Keep the partial line and refill the rest of the buffer
+        std::size_t rest = csv.end - csv.pos;
+        if (rest == csv.buffer.size())
+        {
+            csv.buffer.resize(csv.buffer.size() * 2);
+            data = csv.buffer.data();
+        }
+        std::memmove(data, data + csv.pos, rest);
+        csv.pos = 0;
+        csv.end = rest;
+        std::size_t got = std::fread(data + csv.end, 1, csv.buffer.size() - csv.end, csv.file);
+        csv.end += got;
+        csv.bytesRead += static_cast<long>(got);
+        if (got == 0)
+        {
+            csv.eof = true;
+        }
+    }
+}
+
+// Helper function csvSplit splits a line on commas into trimmed views
+// Returns the number of fields found, at most maxFields
+//----------------------------------------------------------------
+static int csvSplit(std::string_view line, std::string_view fields[], int maxFields)
+{
+    int count = 0;
+    while (count < maxFields)
+    {
+        std::size_t comma = line.find(',');
+        std::string_view field = line.substr(0, comma);
+        while (!field.empty() && (field.front() == ' ' || field.front() == '\t'))
+        {
+            field.remove_prefix(1);
+        }
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\t'))
+        {
+            field.remove_suffix(1);
+        }
+        fields[count++] = field;
+        if (comma == std::string_view::npos)
+        {
+            break;
+        }
+        line.remove_prefix(comma + 1);
+    }
+    return count;
+}
+
+// Helper function parseFloat parses a whole field as a number
+// Returns false if the field is not a number
+//----------------------------------------------------------------
+static bool parseFloat(std::string_view field, float& value)
+{
+    const char* last = field.data() + field.size();
+    std::from_chars_result result = std::from_chars(field.data(), last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// Helper function skipLine checks for blank and comment lines
+//----------------------------------------------------------------
+static bool skipLine(std::string_view line)
+{
+    return line.empty() || line.front() == '#';
+}
+
+// Helper function parseVehicle fills in a vehicle from licence, phone,
+// length and height fields, using the same limits as the reservation prompts
+// Returns an empty string if valid, otherwise the reason for rejecting it
+//----------------------------------------------------------------
+static std::string parseVehicle(const std::string_view fields[], Vehicle& v)
+{
+    if (fields[0].empty() || fields[0].size() > sizeof(v.vehicleLicence) - 1)
+    {
+        return "licence must be 1-10 characters";
+    }
+    if (fields[1].empty() || fields[1].size() > sizeof(v.phone) - 1)
+    {
+        return "phone number must be 1-14 characters";
+    }
+    if (!parseFloat(fields[2], v.vehicleLength) || v.vehicleLength < 0.1f || v.vehicleLength > 99.9f)
+    {
+        return "vehicle length is invalid (Range: 0.1-99.9)";
+    }
+    if (!parseFloat(fields[3], v.vehicleHeight) || v.vehicleHeight < 0.1f || v.vehicleHeight > 9.9f)
+    {
+        return "vehicle height is invalid (Range: 0.1-9.9)";
+    }
+    std::memset(v.vehicleLicence, 0, sizeof(v.vehicleLicence));
+    std::memset(v.phone, 0, sizeof(v.phone));
+    std::memcpy(v.vehicleLicence, fields[0].data(), fields[0].size());
+    std::memcpy(v.phone, fields[1].data(), fields[1].size());
+    return "";
+}
+
+// Helper function loadRegistry reads every vehicle into a hash table
+//----------------------------------------------------------------
+static void loadRegistry(std::unordered_map<std::string, Vehicle>& registry)
+{
+    Vehicle v;
+    vehicleReset();
+    while (getNextVehicle(v))
+    {
+        registry.emplace(v.vehicleLicence, v);
+    }
+}
+
+// Helper function reject prints a rejected row
+//----------------------------------------------------------------
+static void reject(int lineNumber, const std::string& reason)
+{
+    std::cout << "  Rejected line " << lineNumber << ": " << reason << "\n";
+}
+
+// Helper function printRate prints the rows/s summary of an import
+//----------------------------------------------------------------
+static void printRate(const char fileName[],
+                      int rows,
+                      int added,
+                      int rejected,
+                      std::chrono::steady_clock::time_point start)
+{
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Imported " << added << " of " << rows << " rows from " << fileName
+              << " (" << rejected << " rejected) in " << std::fixed << std::setprecision(3) << seconds << "s";
+    if (seconds > 0)
+    {
+        std::cout << ", " << std::setprecision(0) << rows / seconds << " rows/s";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+//================================================================
+// Function importVehicles streams a CSV file of
+// licence,phone,length,height rows into the Vehicle file
+// Returns the number of vehicles added
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+int importVehicles(const char fileName[])
+{
+    TIME_FUNCTION("importVehicles");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CsvStream csv;
+    csvOpen(csv, fileName);
+
+    std::unordered_map<std::string, Vehicle> registry;
+    loadRegistry(registry);
+
+    std::vector<Vehicle> batch;
+    batch.reserve(BATCHSIZE);
+    std::string_view line;
+    std::string_view fields[MAXFIELDS];
+    int lineNumber = 0;
+    int rows = 0;
+    int added = 0;
+    int rejected = 0;
+    int duplicates = 0;
+
+    try
+    {
+        while (csvNextLine(csv, line))
+        {
+            lineNumber++;
+            if (skipLine(line))
+            {
+                continue;
+            }
+            rows++;
+            Vehicle v;
+            std::string reason = csvSplit(line, fields, MAXFIELDS) < 4
+                ? "expected licence,phone,length,height" : parseVehicle(fields, v);
+            if (!reason.empty())
+            {
+                reject(lineNumber, reason);
+                rejected++;
+                continue;
+            }
+            if (!registry.emplace(v.vehicleLicence, v).second)
+            {
+                duplicates++;
+                continue;
+            }
+            batch.push_back(v);
+            if (static_cast<int>(batch.size()) == BATCHSIZE)
+            {
+                writeVehicles(batch.data(), BATCHSIZE);
+                added += BATCHSIZE;
+                batch.clear();
+            }
+        }
+        writeVehicles(batch.data(), static_cast<int>(batch.size()));
+        added += static_cast<int>(batch.size());
+    }
+    catch (...)
+    {
+        std::fclose(csv.file);
+        throw;
+    }
+    std::fclose(csv.file);
+
+    std::cout << "  " << duplicates << " vehicles were already registered\n";
+    printRate(fileName, rows, added, rejected, start);
+    return added;
+}
+
+// Function importReservations loads a CSV file of
+// sailingID,licence[,phone,length,height] rows
+// Returns the number of reservations added
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+int importReservations(const char fileName[])
+{
+    TIME_FUNCTION("importReservations");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CsvStream csv;
+    csvOpen(csv, fileName);
+
+    std::unordered_map<std::string, Vehicle> registry;
+    loadRegistry(registry);
+    std::unordered_set<std::string> newLicences; // vehicles first seen in this file
+
+    // Parse every row and group it by sailing, keeping file order
+    std::unordered_map<std::string, std::vector<PendingReservation> > bySailing;
+    std::vector<std::string> sailingOrder;
+    std::unordered_set<std::string> bookings; // sailingID + licence
+    std::string_view line;
+    std::string_view fields[MAXFIELDS];
+    int lineNumber = 0;
+    int rows = 0;
+    int rejected = 0;
+
+    try
+    {
+        while (csvNextLine(csv, line))
+        {
+            lineNumber++;
+            if (skipLine(line))
+            {
+                continue;
+            }
+            rows++;
+            int count = csvSplit(line, fields, MAXFIELDS);
+            if (count < 2 || fields[0].size() != 9 || fields[1].empty() ||
+                fields[1].size() > sizeof(Reservation::vehicleLicence) - 1)
+            {
+                reject(lineNumber, "expected sailingID,licence[,phone,length,height]");
+                rejected++;
+                continue;
+            }
+            std::string licence(fields[1]);
+            if (registry.find(licence) == registry.end())
+            {
+                // Register the vehicle from the optional columns
+                Vehicle v;
+                std::string reason = count < 5 ? "unknown vehicle " + licence : parseVehicle(fields + 1, v);
+                if (!reason.empty())
+                {
+                    reject(lineNumber, reason);
+                    rejected++;
+                    continue;
+                }
+                registry.emplace(licence, v);
+                newLicences.insert(licence);
+            }
+            std::string sailingID(fields[0]);
+            if (!bookings.insert(sailingID + licence).second)
+            {
+                reject(lineNumber, "duplicate booking for " + licence + " on " + sailingID);
+                rejected++;
+                continue;
+            }
+
+            PendingReservation pending;
+            std::memset(&pending.reservation, 0, sizeof(Reservation));
+            std::memcpy(pending.reservation.sailingID, fields[0].data(), fields[0].size());
+            std::memcpy(pending.reservation.vehicleLicence, fields[1].data(), fields[1].size());
+            pending.lineNumber = lineNumber;
+            std::vector<PendingReservation>& group = bySailing[sailingID];
+            if (group.empty())
+            {
+                sailingOrder.push_back(sailingID);
+            }
+            group.push_back(pending);
+        }
+    }
+    catch (...)
+    {
+        std::fclose(csv.file);
+        throw;
+    }
+    std::fclose(csv.file);
+
+    // One pass over the existing bookings of the affected sailings
+    std::unordered_set<std::string> existing;
+    Reservation r;
+    reservationReset();
+    while (getNextReservation(r))
+    {
+        if (bySailing.find(r.sailingID) != bySailing.end())
+        {
+            existing.insert(std::string(r.sailingID) + r.vehicleLicence);
+        }
+    }
+
+    // Apply lane space once per sailing
+    std::vector<Reservation> accepted;
+    std::vector<Vehicle> vehicles;
+    std::vector<Sailing> updatedSailings;
+    for (const std::string& sailingID : sailingOrder)
+    {
+        std::vector<PendingReservation>& group = bySailing[sailingID];
+        const SailingIndexEntry* entry = sailingIndexFind(sailingID.c_str());
+        if (entry == nullptr)
+        {
+            for (const PendingReservation& pending : group)
+            {
+                reject(pending.lineNumber, "unknown sailing " + sailingID);
+                rejected++;
+            }
+            continue;
+        }
+
+        Sailing s = entry->sailing;
+        bool changed = false;
+        for (PendingReservation& pending : group)
+        {
+            Reservation& res = pending.reservation;
+            if (existing.find(sailingID + res.vehicleLicence) != existing.end())
+            {
+                reject(pending.lineNumber, std::string("booking already exists for ") + res.vehicleLicence);
+                rejected++;
+                continue;
+            }
+            const Vehicle& v = registry[res.vehicleLicence];
+
+            // Same lane rule as createReservation, recording the lane used
+            bool lowVehicle = (v.vehicleHeight <= 2 && v.vehicleLength <= 7);
+            if (lowVehicle && v.vehicleLength <= s.lowRemainingLength)
+            {
+                s.lowRemainingLength -= v.vehicleLength;
+                res.isLRL = true;
+            }
+            else if (v.vehicleLength <= s.highRemainingLength)
+            {
+                s.highRemainingLength -= v.vehicleLength;
+                res.isLRL = false;
+            }
+            else
+            {
+                reject(pending.lineNumber, "over capacity on " + sailingID);
+                countMetric(capacityRejectionsTotal);
+                rejected++;
+                continue;
+            }
+            res.onBoard = false;
+            accepted.push_back(res);
+            changed = true;
+
+            // New vehicles are written with their first accepted booking
+            std::unordered_set<std::string>::iterator fresh = newLicences.find(res.vehicleLicence);
+            if (fresh != newLicences.end())
+            {
+                vehicles.push_back(v);
+                newLicences.erase(fresh);
+            }
+        }
+        if (changed)
+        {
+            updatedSailings.push_back(s);
+        }
+    }
+
+    // Write everything in large blocks
+    for (std::size_t i = 0; i < vehicles.size(); i += BATCHSIZE)
+    {
+        writeVehicles(vehicles.data() + i, static_cast<int>(std::min<std::size_t>(BATCHSIZE, vehicles.size() - i)));
+    }
+    for (std::size_t i = 0; i < accepted.size(); i += BATCHSIZE)
+    {
+        writeReservations(accepted.data() + i, static_cast<int>(std::min<std::size_t>(BATCHSIZE, accepted.size() - i)));
+    }
+    updateSailingRecords(updatedSailings.data(), static_cast<int>(updatedSailings.size()));
+    countMetric(bookingsTotal, static_cast<long long>(accepted.size()));
+
+    std::cout << "  " << vehicles.size() << " new vehicles registered, "
+              << updatedSailings.size() << " sailings updated\n";
+    printRate(fileName, rows, static_cast<int>(accepted.size()), rejected, start);
+    return static_cast<int>(accepted.size());
+}
@@ -0,0 +1,44 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: bulkImport.hpp
+ *
+ * Description: Header file of the BulkImport module of the Ferry
+ *              Reservation System. Loads vehicles and reservations from
+ *              CSV files (e.g. booking history or partner bookings)
+ *              without going through the interactive reservation prompts.
+ *              The storage modules must be opened before importing.
+ *
+ * Design Issues: Rows are tokenized in place in a large read buffer
+ *                Reservations are grouped by sailing before capacity is
+ *                applied, so each sailing record is written once
+ */
+//================================================================
+#pragma once
+#include <iostream>
+#include <string>
+
+//================================================================
+// Function importVehicles streams a CSV file of
+//   licence,phone,length,height
+// rows into the Vehicle file. Licences that are already registered, or
+// repeated in the file, are skipped. Blank lines and lines starting with
+// # are ignored.
+// Prints the rows/s rate and every rejected row
+// Returns the number of vehicles added
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+int importVehicles(const char fileName[]);
+
+// Function importReservations loads a CSV file of
+//   sailingID,licence[,phone,length,height]
+// rows. The vehicle columns are only needed for vehicles that are not yet
+// registered; those vehicles are added with their first accepted booking.
+// Rows for an unknown sailing, an unknown vehicle, a booking that already
+// exists, or a sailing without enough lane space are rejected.
+// Prints the rows/s rate and every rejected row
+// Returns the number of reservations added
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+int importReservations(const char fileName[]);
@@ -0,0 +1,443 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataExport.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the DataExport module of the Ferry
+ *              Reservation System. Each export reads the data files one
+ *              record at a time and formats rows straight into a 4MB
+ *              stdio buffer, so only the buffer and small lookup tables
+ *              (vessels, vehicles, per-sailing counts) are held in memory.
+ *
+ * Design Issues: Manifests look up vehicles in a hash table of the
+ *                registry, which grows with the number of vehicles but
+ *                not with the number of reservations
+ *                The fleet report counts reservations in one pass instead
+ *                of one pass per sailing as printSailingReport does
+ */
+//================================================================
+#include "dataExport.hpp"
+#include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include "stats.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+//============================================================
+// Module scope constants
+//------------------------------------------------------------
+static const std::size_t OUTPUTBUFFERSIZE = 4 << 20; // stdio buffer for export files
+
+//============================================================
+// Struct: ExportFile
+// Purpose: An export file being written and its running totals
+//------------------------------------------------------------
+struct ExportFile
+{
+    std::FILE* file; // output file
+    std::vector<char> buffer; // stdio buffer
+    ExportFormat format; // CSV or JSON
+    long bytes; // bytes written so far
+    long records; // rows written so far
+    std::chrono::steady_clock::time_point start; // when the export started
+};
+
+// Struct: ExportField
+// Purpose: One named value of an export row
+//------------------------------------------------------------
+struct ExportField
+{
+    const char* name; // column or key name
+    const char* text; // formatted value
+    bool isString; // quote the value in JSON
+};
+
+//================================================================
+// Helper function put writes raw text to the export file
+//----------------------------------------------------------------
+static void put(ExportFile& out, const char* text, std::size_t length)
+{
+    if (std::fwrite(text, 1, length, out.file) != length)
+    {
+        throw std::runtime_error("Error writing export file.");
+    }
+    out.bytes += static_cast<long>(length);
+}
+
+// Helper function putText writes a null terminated string
+//----------------------------------------------------------------
+static void putText(ExportFile& out, const char* text)
+{
+    put(out, text, std::strlen(text));
+}
+
+// Helper function putCsvValue writes a CSV value, quoting it if it holds
+// a comma, quote or line break
+//----------------------------------------------------------------
+static void putCsvValue(ExportFile& out, const char* text)
+{
+    if (std::strpbrk(text, ",\"\r\n") == nullptr)
+    {
+        putText(out, text);
+        return;
+    }
+    put(out, "\"", 1);
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"')
+        {
+            put(out, "\"", 1);
+        }
+        put(out, c, 1);
+    }
+    put(out, "\"", 1);
+}
+
+// Helper function putJsonString writes a quoted and escaped JSON string
+//----------------------------------------------------------------
+static void putJsonString(ExportFile& out, const char* text)
+{
+    put(out, "\"", 1);
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            put(out, "\\", 1);
+            put(out, c, 1);
+        }
+        else if (static_cast<unsigned char>(*c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+            putText(out, escaped);
+        }
+        else
+        {
+            put(out, c, 1);
+        }
+    }
+    put(out, "\"", 1);
+}
+
+// Helper function exportOpen creates the export file and writes the CSV
+// header or the start of the JSON array
+// Throws an exception if the file cannot be created
+//----------------------------------------------------------------
+static void exportOpen(ExportFile& out,
+                       const char fileName[],
+                       ExportFormat format,
+                       const ExportField fields[],
+                       int count)
+{
+    out.file = std::fopen(fileName, "wb");
+    if (out.file == nullptr)
+    {
+        throw std::runtime_error(std::string("Cannot create ") + fileName + ".");
+    }
+    out.buffer.resize(OUTPUTBUFFERSIZE);
+    std::setvbuf(out.file, out.buffer.data(), _IOFBF, out.buffer.size());
+    out.format = format;
+    out.bytes = 0;
+    out.records = 0;
+    out.start = std::chrono::steady_clock::now();
+
+    if (format == csvFormat)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (i > 0)
+            {
+                put(out, ",", 1);
+            }
+            putText(out, fields[i].name);
+        }
+        put(out, "\n", 1);
+    }
+    else
+    {
+        put(out, "[", 1);
+    }
+}
+
+// Helper function exportRow writes one row as a CSV line or JSON object
+//----------------------------------------------------------------
+static void exportRow(ExportFile& out, const ExportField fields[], int count)
+{
+    if (out.format == csvFormat)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (i > 0)
+            {
+                put(out, ",", 1);
+            }
+            // Missing numbers are left empty in CSV
+            bool missing = !fields[i].isString && std::strcmp(fields[i].text, "null") == 0;
+            putCsvValue(out, missing ? "" : fields[i].text);
+        }
+        put(out, "\n", 1);
+    }
+    else
+    {
+        putText(out, out.records == 0 ? "\n{" : ",\n{");
+        for (int i = 0; i < count; ++i)
+        {
+            if (i > 0)
+            {
+                put(out, ",", 1);
+            }
+            putJsonString(out, fields[i].name);
+            put(out, ":", 1);
+            if (fields[i].isString)
+            {
+                putJsonString(out, fields[i].text);
+            }
+            else
+            {
+                putText(out, fields[i].text);
+            }
+        }
+        put(out, "}", 1);
+    }
+    out.records++;
+}
+
+// Helper function exportClose finishes the file and prints the bytes/s rate
+// Throws an exception if the file could not be written
+//----------------------------------------------------------------
+static void exportClose(ExportFile& out, const char fileName[])
+{
+    if (out.format == jsonFormat)
+    {
+        putText(out, "\n]\n");
+    }
+    if (std::fclose(out.file) != 0)
+    {
+        throw std::runtime_error(std::string("Error writing ") + fileName + ".");
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - out.start).count();
+    std::cout << "Exported " << out.records << " rows (" << out.bytes << " bytes) to " << fileName
+              << " in " << std::fixed << std::setprecision(3) << seconds << "s";
+    if (seconds > 0)
+    {
+        std::cout << ", " << std::setprecision(0) << out.bytes / seconds << " bytes/s";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+// Helper function exportAbort closes a partly written file after an error
+//----------------------------------------------------------------
+static void exportAbort(ExportFile& out)
+{
+    if (out.file != nullptr)
+    {
+        std::fclose(out.file);
+        out.file = nullptr;
+    }
+}
+
+//================================================================
+// Function exportSailings writes every sailing in departure order
+// Returns the number of sailings written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportSailings(const char fileName[], ExportFormat format)
+{
+    TIME_FUNCTION("exportSailings");
+    char lrl[16];
+    char hrl[16];
+    ExportField fields[] = {
+        {"sailingID", "", true},
+        {"terminal", "", true},
+        {"day", "", false},
+        {"hour", "", false},
+        {"vesselName", "", true},
+        {"lowRemainingLength", lrl, false},
+        {"highRemainingLength", hrl, false}};
+    const int count = sizeof(fields) / sizeof(fields[0]);
+
+    ExportFile out = {};
+    exportOpen(out, fileName, format, fields, count);
+    try
+    {
+        for (const Sailing& s : sailingIndexAll())
+        {
+            // ttt-dd-hh split into its parts
+            char terminal[4] = {s.sailingID[0], s.sailingID[1], s.sailingID[2], '\0'};
+            char day[8];
+            char hour[8];
+            std::snprintf(day, sizeof(day), "%d", (s.sailingID[4] - '0') * 10 + (s.sailingID[5] - '0'));
+            std::snprintf(hour, sizeof(hour), "%d", (s.sailingID[7] - '0') * 10 + (s.sailingID[8] - '0'));
+            std::snprintf(lrl, sizeof(lrl), "%.1f", s.lowRemainingLength);
+            std::snprintf(hrl, sizeof(hrl), "%.1f", s.highRemainingLength);
+            fields[0].text = s.sailingID;
+            fields[1].text = terminal;
+            fields[2].text = day;
+            fields[3].text = hour;
+            fields[4].text = s.vesselName;
+            exportRow(out, fields, count);
+        }
+    }
+    catch (...)
+    {
+        exportAbort(out);
+        throw;
+    }
+    exportClose(out, fileName);
+    return out.records;
+}
+
+// Function exportManifest writes the reservations of one sailing, or of all
+// sailings if sailingID is nullptr
+// Returns the number of reservations written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportManifest(const char sailingID[], const char fileName[], ExportFormat format)
+{
+    TIME_FUNCTION("exportManifest");
+    // Vehicle details by licence
+    std::unordered_map<std::string, Vehicle> vehicles;
+    Vehicle v;
+    vehicleReset();
+    while (getNextVehicle(v))
+    {
+        vehicles.emplace(v.vehicleLicence, v);
+    }
+
+    char length[16];
+    char height[16];
+    ExportField fields[] = {
+        {"sailingID", "", true},
+        {"vehicleLicence", "", true},
+        {"phone", "", true},
+        {"vehicleLength", length, false},
+        {"vehicleHeight", height, false},
+        {"lane", "", true},
+        {"onBoard", "", false}};
+    const int count = sizeof(fields) / sizeof(fields[0]);
+
+    ExportFile out = {};
+    exportOpen(out, fileName, format, fields, count);
+    try
+    {
+        Reservation r;
+        reservationReset();
+        while (getNextReservation(r))
+        {
+            if (sailingID != nullptr && std::strncmp(r.sailingID, sailingID, sizeof(r.sailingID)) != 0)
+            {
+                continue;
+            }
+            std::unordered_map<std::string, Vehicle>::const_iterator found = vehicles.find(r.vehicleLicence);
+            if (found != vehicles.end())
+            {
+                fields[2].text = found->second.phone;
+                std::snprintf(length, sizeof(length), "%.1f", found->second.vehicleLength);
+                std::snprintf(height, sizeof(height), "%.1f", found->second.vehicleHeight);
+            }
+            else
+            {
+                fields[2].text = "";
+                std::strcpy(length, "null");
+                std::strcpy(height, "null");
+            }
+            fields[0].text = r.sailingID;
+            fields[1].text = r.vehicleLicence;
+            fields[5].text = r.isLRL ? "low" : "high";
+            fields[6].text = r.onBoard ? "true" : "false";
+            exportRow(out, fields, count);
+        }
+    }
+    catch (...)
+    {
+        exportAbort(out);
+        throw;
+    }
+    exportClose(out, fileName);
+    return out.records;
+}
+
+// Function exportFleetReport writes one line per sailing with its vessel,
+// remaining lane lengths, number of vehicles booked and percent used
+// Returns the number of sailings written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportFleetReport(const char fileName[], ExportFormat format)
+{
+    TIME_FUNCTION("exportFleetReport");
+    // Total lane length of every vessel
+    std::unordered_map<std::string, float> vesselLength;
+    Vessel vessel;
+    vesselReset();
+    while (getNextVessel(vessel))
+    {
+        vesselLength[vessel.name] = vessel.HCLL + vessel.LCLL;
+    }
+
+    // Vehicles booked per sailing, in one pass over the reservations
+    std::unordered_map<std::string, long> booked;
+    Reservation r;
+    reservationReset();
+    while (getNextReservation(r))
+    {
+        booked[r.sailingID]++;
+    }
+
+    char lrl[16];
+    char hrl[16];
+    char vehicles[24];
+    char percent[16];
+    ExportField fields[] = {
+        {"sailingID", "", true},
+        {"vesselName", "", true},
+        {"lowRemainingLength", lrl, false},
+        {"highRemainingLength", hrl, false},
+        {"vehicles", vehicles, false},
+        {"lengthUsedPercent", percent, false}};
+    const int count = sizeof(fields) / sizeof(fields[0]);
+
+    ExportFile out = {};
+    exportOpen(out, fileName, format, fields, count);
+    try
+    {
+        for (const Sailing& s : sailingIndexAll())
+        {
+            std::unordered_map<std::string, float>::const_iterator total = vesselLength.find(s.vesselName);
+            std::unordered_map<std::string, long>::const_iterator bookedCount = booked.find(s.sailingID);
+            std::snprintf(lrl, sizeof(lrl), "%.1f", s.lowRemainingLength);
+            std::snprintf(hrl, sizeof(hrl), "%.1f", s.highRemainingLength);
+            std::snprintf(vehicles, sizeof(vehicles), "%ld", bookedCount == booked.end() ? 0L : bookedCount->second);
+            if (total != vesselLength.end() && total->second > 0)
+            {
+                float remaining = s.lowRemainingLength + s.highRemainingLength;
+                std::snprintf(percent, sizeof(percent), "%.1f", (1.0f - remaining / total->second) * 100);
+            }
+            else
+            {
+                std::strcpy(percent, "null");
+            }
+            fields[0].text = s.sailingID;
+            fields[1].text = s.vesselName;
+            exportRow(out, fields, count);
+        }
+    }
+    catch (...)
+    {
+        exportAbort(out);
+        throw;
+    }
+    exportClose(out, fileName);
+    return out.records;
+}
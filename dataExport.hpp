@@ -0,0 +1,50 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataExport.hpp
+ *
+ * Description: Header file of the DataExport module of the Ferry
+ *              Reservation System. Writes sailings, sailing manifests and
+ *              the fleet report to CSV or JSON files for billing and port
+ *              systems. Records are streamed from the data files, so the
+ *              memory used does not grow with the number of reservations.
+ *              The storage modules must be opened before exporting.
+ */
+//================================================================
+#pragma once
+#include <iostream>
+#include <string>
+
+//================================================================
+// Enum: ExportFormat
+// Purpose: Output file format of an export
+//----------------------------------------------------------------
+enum ExportFormat {csvFormat, jsonFormat};
+
+//================================================================
+// Function exportSailings writes every sailing in departure order with its
+// vessel and remaining lane lengths
+// Prints the bytes written and bytes/s
+// Returns the number of sailings written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportSailings(const char fileName[], ExportFormat format);
+
+// Function exportManifest writes the reservations of one sailing, or of all
+// sailings if sailingID is nullptr, with each vehicle's phone number,
+// dimensions, lane and check in status
+// Prints the bytes written and bytes/s
+// Returns the number of reservations written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportManifest(const char sailingID[], const char fileName[], ExportFormat format);
+
+// Function exportFleetReport writes one line per sailing with its vessel,
+// remaining lane lengths, number of vehicles booked and percent of lane
+// length used
+// Prints the bytes written and bytes/s
+// Returns the number of sailings written
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+long exportFleetReport(const char fileName[], ExportFormat format);
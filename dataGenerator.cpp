@@ -0,0 +1,500 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataGenerator.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Vessel names use '_' between words so they can be typed back
+ *
+ * Description: Implementation file of the DataGenerator module of the
+ *              Ferry Reservation System. The fleet and the customer base
+ *              are built first; the season is then filled one sailing at a
+ *              time, drawing customers from a Zipf distribution and writing
+ *              each sailing record once its bookings are known. Records go
+ *              straight to the files through large stdio buffers.
+ *
+ * Design Issues: Customers are drawn with an alias table, so each booking
+ *                costs O(1) whatever the size of the customer base
+ *                A per-vehicle stamp of the last sailing drawn stops the
+ *                same vehicle being booked twice on one sailing without a
+ *                hash set of all bookings
+ *                mt19937_64 is used with our own conversions to numbers,
+ *                since the standard distributions differ between libraries
+ */
+//================================================================
+#include "dataGenerator.hpp"
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//============================================================
+// Module scope constants
+//------------------------------------------------------------
+static const std::size_t OUTPUTBUFFERSIZE = 4 << 20; // stdio buffer per data file
+static const int MAXATTEMPTS = 16; // failed draws before a sailing counts as full
+static const long LICENCECODES = 17576L * 10000L; // AAA0000 to ZZZ9999
+
+// Vessel classes of the fleet, largest first
+static const struct
+{
+    const char* prefix;
+    float LCLL;
+    float HCLL;
+} VESSELCLASSES[] =
+{
+    {"Spirit of", 2100.0f, 620.0f},
+    {"Coastal", 1650.0f, 480.0f},
+    {"Queen of", 1250.0f, 420.0f},
+    {"Salish", 700.0f, 250.0f},
+    {"Island", 320.0f, 110.0f}
+};
+static const int CLASSORDER[] = {0, 1, 2, 2, 3, 3, 4, 1}; // class of vessel i % 8
+static const char* VESSELNAMES[] =
+{
+    "Haida Gwaii", "Vancouver", "Renaissance", "Inspiration",
+    "Celebration", "Surrey", "Oak Bay", "Cowichan", "Alberni",
+    "Capilano", "Coquitlam", "Esquimalt", "Saanich", "Nanaimo",
+    "Orca", "Eagle", "Raven", "Heron", "Kwigwis", "Sointula"
+};
+static const char* TERMINALCODES[] =
+{
+    "TSA", "SWB", "HSB", "DPB", "NAN", "LNG", "CMX", "PWR", "BOW", "SGI",
+    "PEN", "FUL", "VES", "BRB", "CRO", "SAL", "QDR", "ALR", "PRT", "SKD",
+    "KLE", "BEL", "MIL", "GAB", "THE", "DEN", "HOR", "ROB", "MAY", "SAT"
+};
+static const double DAYWEIGHTS[] = {1.0, 0.8, 0.8, 0.9, 1.4, 1.6, 1.3}; // Monday to Sunday
+
+//============================================================
+// Struct: GeneratorFile
+// Purpose: A data file being written through a large buffer
+//------------------------------------------------------------
+struct GeneratorFile
+{
+    std::FILE* file; // output file
+    std::vector<char> buffer; // stdio buffer
+    long records; // records written so far
+};
+
+// Struct: AliasTable
+// Purpose: Draws an index with given weights in constant time
+//------------------------------------------------------------
+struct AliasTable
+{
+    std::vector<float> probability; // chance of keeping the drawn column
+    std::vector<std::uint32_t> alias; // index used otherwise
+};
+
+//================================================================
+// Helper function openFile creates a data file for writing
+//----------------------------------------------------------------
+static void openFile(GeneratorFile& out, const char fileName[])
+{
+    out.file = std::fopen(fileName, "wb");
+    if (out.file == nullptr)
+    {
+        throw std::runtime_error(std::string("Cannot create ") + fileName);
+    }
+    out.buffer.resize(OUTPUTBUFFERSIZE);
+    std::setvbuf(out.file, out.buffer.data(), _IOFBF, out.buffer.size());
+    out.records = 0;
+}
+
+// Helper function putRecord appends one fixed-length record
+//----------------------------------------------------------------
+template <typename Record>
+static void putRecord(GeneratorFile& out, const Record& record)
+{
+    if (std::fwrite(&record, sizeof(Record), 1, out.file) != 1)
+    {
+        throw std::runtime_error("Error writing generated data file.");
+    }
+    out.records++;
+}
+
+// Helper function closeFile flushes and closes a data file
+//----------------------------------------------------------------
+static void closeFile(GeneratorFile& out)
+{
+    if (std::fclose(out.file) != 0)
+    {
+        throw std::runtime_error("Error closing generated data file.");
+    }
+}
+
+// Helper function uniform returns a number in [0, 1)
+//----------------------------------------------------------------
+static double uniform(std::mt19937_64& random)
+{
+    return static_cast<double>(random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Helper function uniformIndex returns an integer in [0, n)
+//----------------------------------------------------------------
+static std::uint32_t uniformIndex(std::mt19937_64& random, std::uint32_t n)
+{
+    return static_cast<std::uint32_t>(((random() >> 32) * n) >> 32);
+}
+
+// Helper function between returns a length rounded to 0.1 in [low, high)
+//----------------------------------------------------------------
+static float between(std::mt19937_64& random, double low, double high)
+{
+    return static_cast<float>(std::floor((low + (high - low) * uniform(random)) * 10) / 10);
+}
+
+// Helper function buildAliasTable sets up Vose's alias method for the weights
+//----------------------------------------------------------------
+static void buildAliasTable(AliasTable& table, const std::vector<double>& weights)
+{
+    std::size_t n = weights.size();
+    double total = 0;
+    for (double w : weights)
+    {
+        total += w;
+    }
+    std::vector<double> scaled(n);
+    std::vector<std::uint32_t> small, large;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        scaled[i] = weights[i] * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+    table.probability.assign(n, 1.0f);
+    table.alias.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        table.alias[i] = static_cast<std::uint32_t>(i);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        std::uint32_t s = small.back();
+        small.pop_back();
+        std::uint32_t l = large.back();
+        table.probability[s] = static_cast<float>(scaled[s]);
+        table.alias[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+}
+
+// Helper function capWeights flattens the head of the Zipf curve so that no
+// customer expects more than maxTrips bookings (a commuter's two sailings a
+// day); the cap is found by bisection
+//----------------------------------------------------------------
+static void capWeights(std::vector<double>& weights, long reservations, double maxTrips)
+{
+    double low = 0;
+    double high = weights.empty() ? 0 : weights[0];
+    for (int i = 0; i < 50; ++i)
+    {
+        double cap = (low + high) / 2;
+        double total = 0;
+        for (double w : weights)
+        {
+            total += std::min(w, cap);
+        }
+        (reservations * cap / total > maxTrips ? high : low) = cap;
+    }
+    if (high < (weights.empty() ? 0 : weights[0]))
+    {
+        for (double& w : weights)
+        {
+            w = std::min(w, high);
+        }
+    }
+}
+
+// Helper function draw picks an index from an alias table
+//----------------------------------------------------------------
+static std::uint32_t draw(const AliasTable& table, std::mt19937_64& random)
+{
+    std::uint32_t i = uniformIndex(random, static_cast<std::uint32_t>(table.alias.size()));
+    return uniform(random) < table.probability[i] ? i : table.alias[i];
+}
+
+// Helper function makeLicence gives vehicle n a unique plate such as ABC1234,
+// scattered over the plate space so that nearby vehicles do not look alike
+//----------------------------------------------------------------
+static void makeLicence(long n, char licence[])
+{
+    long code = static_cast<long>((static_cast<long long>(n) * 1000003LL + 12345) % LICENCECODES);
+    long letters = code / 10000;
+    long digits = code % 10000;
+    // Formatted by hand; this runs once per booking
+    licence[0] = static_cast<char>('A' + letters / 676);
+    licence[1] = static_cast<char>('A' + letters / 26 % 26);
+    licence[2] = static_cast<char>('A' + letters % 26);
+    licence[3] = static_cast<char>('0' + digits / 1000);
+    licence[4] = static_cast<char>('0' + digits / 100 % 10);
+    licence[5] = static_cast<char>('0' + digits / 10 % 10);
+    licence[6] = static_cast<char>('0' + digits % 10);
+    licence[7] = '\0';
+}
+
+// Helper function makeVehicle fills in a vehicle of a random type:
+// cars, low vans, tall vans and campers, and commercial trucks
+//----------------------------------------------------------------
+static void makeVehicle(long n, std::mt19937_64& random, Vehicle& v)
+{
+    std::memset(&v, 0, sizeof(v));
+    makeLicence(n, v.vehicleLicence);
+    std::snprintf(v.phone, sizeof(v.phone), "%s-%03u-%04u",
+                  uniform(random) < 0.6 ? "604" : "250",
+                  200 + uniformIndex(random, 800), uniformIndex(random, 10000));
+    double type = uniform(random);
+    if (type < 0.70)
+    {
+        v.vehicleLength = between(random, 3.8, 5.2);
+        v.vehicleHeight = between(random, 1.4, 1.9);
+    }
+    else if (type < 0.82)
+    {
+        v.vehicleLength = between(random, 4.8, 6.5);
+        v.vehicleHeight = between(random, 1.8, 2.0);
+    }
+    else if (type < 0.92)
+    {
+        v.vehicleLength = between(random, 5.5, 7.5);
+        v.vehicleHeight = between(random, 2.1, 3.0);
+    }
+    else
+    {
+        v.vehicleLength = between(random, 8.0, 20.0);
+        v.vehicleHeight = between(random, 3.0, 4.2);
+    }
+}
+
+// Helper function makeTerminals picks the terminal codes, known codes first
+//----------------------------------------------------------------
+static std::vector<std::string> makeTerminals(int count)
+{
+    std::vector<std::string> terminals;
+    std::unordered_set<std::string> used;
+    const int known = sizeof(TERMINALCODES) / sizeof(TERMINALCODES[0]);
+    for (int i = 0; i < known && i < count; ++i)
+    {
+        terminals.push_back(TERMINALCODES[i]);
+        used.insert(TERMINALCODES[i]);
+    }
+    for (int code = 0; static_cast<int>(terminals.size()) < count; ++code)
+    {
+        char name[4] = {static_cast<char>('A' + code / 676), static_cast<char>('A' + code / 26 % 26),
+                        static_cast<char>('A' + code % 26), '\0'};
+        if (used.insert(name).second)
+        {
+            terminals.push_back(name);
+        }
+    }
+    return terminals;
+}
+
+//================================================================
+// Function defaultGeneratorOptions returns the options of a typical season
+//----------------------------------------------------------------
+GeneratorOptions defaultGeneratorOptions(long reservations)
+{
+    GeneratorOptions options;
+    options.seed = 2018;
+    options.reservations = reservations;
+    options.vehicles = 0;
+    options.terminals = 2;
+    options.days = 28;
+    options.departuresPerDay = 12;
+    options.vessels = 12;
+    options.zipfExponent = 1.0;
+    options.loadFactor = 0.6;
+    return options;
+}
+
+// Function generateData writes the four data files in the current directory
+//----------------------------------------------------------------
+GeneratorResult generateData(const GeneratorOptions& options)
+{
+    if (options.reservations < 0 || options.vehicles < 0 || options.vehicles > LICENCECODES
+        || options.days < 1 || options.days > 31
+        || options.departuresPerDay < 1 || options.departuresPerDay > 24
+        || options.vessels < 1 || options.terminals < 1 || options.terminals > 17576
+        || options.zipfExponent < 0 || options.loadFactor <= 0 || options.loadFactor > 1)
+    {
+        throw std::runtime_error("Generator option out of range.");
+    }
+    std::mt19937_64 random(options.seed);
+    GeneratorResult result = {0, 0, 0, 0};
+
+    // Fleet, with the largest vessels on the busiest routes
+    GeneratorFile file;
+    openFile(file, "vessels.dat");
+    std::vector<Vessel> fleet(options.vessels);
+    const int names = sizeof(VESSELNAMES) / sizeof(VESSELNAMES[0]);
+    double fleetCapacity = 0;
+    for (int i = 0; i < options.vessels; ++i)
+    {
+        Vessel& v = fleet[i];
+        std::memset(&v, 0, sizeof(v));
+        int vesselClass = CLASSORDER[i % 8];
+        std::string name = std::string(VESSELCLASSES[vesselClass].prefix) + " " + VESSELNAMES[i % names];
+        if (i >= names)
+        {
+            name += " " + std::to_string(i / names + 1);
+        }
+        // Names are read back as one word by the timetable, scripts and prompts
+        std::replace(name.begin(), name.end(), ' ', '_');
+        std::snprintf(v.name, sizeof(v.name), "%s", name.c_str());
+        v.LCLL = VESSELCLASSES[vesselClass].LCLL;
+        v.HCLL = VESSELCLASSES[vesselClass].HCLL;
+        fleetCapacity += v.LCLL + v.HCLL;
+        putRecord(file, v);
+    }
+    closeFile(file);
+    result.vessels = file.records;
+
+    // Customer base; rank n is the n-th most frequent traveller
+    long vehicleCount = options.vehicles > 0 ? options.vehicles : std::max(100L, options.reservations / 4);
+    std::vector<float> lengths(vehicleCount), heights(vehicleCount);
+    std::vector<double> weights(vehicleCount);
+    double totalLength = 0;
+    openFile(file, "vehicles.dat");
+    for (long n = 0; n < vehicleCount; ++n)
+    {
+        Vehicle v;
+        makeVehicle(n, random, v);
+        lengths[n] = v.vehicleLength;
+        heights[n] = v.vehicleHeight;
+        weights[n] = std::pow(n + 1.0, -options.zipfExponent);
+        totalLength += v.vehicleLength;
+        putRecord(file, v);
+    }
+    closeFile(file);
+    result.vehicles = file.records;
+    capWeights(weights, options.reservations, 2.0 * options.days);
+    AliasTable customers;
+    buildAliasTable(customers, weights);
+    std::vector<double>().swap(weights);
+
+    // Add terminals until the fleet can carry the bookings at the load factor
+    double averageLength = totalLength / vehicleCount;
+    double averageCapacity = fleetCapacity / options.vessels;
+    long sailingsPerTerminal = static_cast<long>(options.days) * options.departuresPerDay;
+    double needed = options.reservations * averageLength
+                    / (options.loadFactor * averageCapacity * sailingsPerTerminal);
+    int terminalCount = std::max(options.terminals, static_cast<int>(std::ceil(needed)));
+    if (terminalCount > 17576)
+    {
+        throw std::runtime_error("Too many reservations for the season and fleet.");
+    }
+    std::vector<std::string> terminals = makeTerminals(terminalCount);
+
+    // Demand of every sailing: route, weekday and time of day
+    std::vector<int> hours(options.departuresPerDay);
+    std::vector<double> hourWeights(options.departuresPerDay);
+    int firstHour = options.departuresPerDay <= 17 ? 6 : 0;
+    int span = options.departuresPerDay <= 17 ? 16 : 23;
+    for (int k = 0; k < options.departuresPerDay; ++k)
+    {
+        hours[k] = options.departuresPerDay == 1 ? 12 : firstHour + k * span / (options.departuresPerDay - 1);
+        double h = hours[k];
+        hourWeights[k] = 0.4 + std::exp(-(h - 8) * (h - 8) / 8) + 0.8 * std::exp(-(h - 17) * (h - 17) / 8);
+    }
+    double totalWeight = 0;
+    for (int t = 0; t < terminalCount; ++t)
+    {
+        for (int d = 0; d < options.days; ++d)
+        {
+            for (int k = 0; k < options.departuresPerDay; ++k)
+            {
+                totalWeight += DAYWEIGHTS[d % 7] * hourWeights[k] / std::sqrt(t + 1.0);
+            }
+        }
+    }
+
+    // Fill the season one sailing at a time
+    GeneratorFile sailingFile, reservationFile;
+    openFile(sailingFile, "sailings.dat");
+    openFile(reservationFile, "reservations.dat");
+    std::vector<std::uint32_t> lastSailing(vehicleCount, UINT32_MAX);
+    std::uint32_t sailingNumber = 0;
+    double cumulative = 0;
+    long planned = 0;
+    long carry = 0;
+    for (int t = 0; t < terminalCount; ++t)
+    {
+        const Vessel& vessel = fleet[t % options.vessels];
+        for (int d = 0; d < options.days; ++d)
+        {
+            for (int k = 0; k < options.departuresPerDay; ++k, ++sailingNumber)
+            {
+                Sailing s;
+                std::memset(&s, 0, sizeof(s));
+                char id[16];
+                std::snprintf(id, sizeof(id), "%s-%02d-%02d", terminals[t].c_str(), d + 1, hours[k]);
+                std::memcpy(s.sailingID, id, sizeof(s.sailingID));
+                std::strcpy(s.vesselName, vessel.name);
+                s.lowRemainingLength = vessel.LCLL;
+                s.highRemainingLength = vessel.HCLL;
+
+                cumulative += options.reservations * DAYWEIGHTS[d % 7] * hourWeights[k]
+                              / std::sqrt(t + 1.0) / totalWeight;
+                long demand = std::lround(cumulative) - planned + carry;
+                planned = std::lround(cumulative);
+                int failures = 0;
+                while (demand > 0 && failures < MAXATTEMPTS)
+                {
+                    std::uint32_t v = draw(customers, random);
+                    Reservation r;
+                    std::memset(&r, 0, sizeof(r));
+                    if (lastSailing[v] == sailingNumber)
+                    {
+                        failures++;
+                        continue;
+                    }
+                    bool isLow = heights[v] <= 2.0f && lengths[v] <= 7.0f;
+                    if (isLow && s.lowRemainingLength >= lengths[v])
+                    {
+                        s.lowRemainingLength -= lengths[v];
+                        r.isLRL = true;
+                    }
+                    else if (s.highRemainingLength >= lengths[v])
+                    {
+                        s.highRemainingLength -= lengths[v];
+                    }
+                    else
+                    {
+                        failures++;
+                        continue;
+                    }
+                    lastSailing[v] = sailingNumber;
+                    std::strcpy(r.sailingID, s.sailingID);
+                    makeLicence(v, r.vehicleLicence);
+                    putRecord(reservationFile, r);
+                    failures = 0;
+                    demand--;
+                }
+                // A full sailing passes its remaining demand to the next departure
+                carry = demand;
+                putRecord(sailingFile, s);
+            }
+        }
+    }
+    closeFile(sailingFile);
+    closeFile(reservationFile);
+    result.sailings = sailingFile.records;
+    result.reservations = reservationFile.records;
+    return result;
+}
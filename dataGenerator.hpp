@@ -0,0 +1,66 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataGenerator.hpp
+ *
+ * Description: Header file of the DataGenerator module of the Ferry
+ *              Reservation System. Writes a synthetic but realistic store
+ *              (fleet, a season of daily departures, a customer base and
+ *              their bookings) straight into vessels.dat, sailings.dat,
+ *              vehicles.dat and reservations.dat for capacity planning,
+ *              benchmarks and stress runs.
+ *
+ * Design Issues: The data files are overwritten, so the storage modules
+ *                must be closed while generating
+ *                The same options and seed always give the same files
+ */
+//================================================================
+#pragma once
+
+//================================================================
+// Struct: GeneratorOptions
+// Purpose: Size and shape of a generated store
+//----------------------------------------------------------------
+struct GeneratorOptions
+{
+    unsigned long long seed; // random seed
+    long reservations; // bookings to write
+    long vehicles; // registered vehicles, 0 for reservations / 4
+    int terminals; // minimum number of terminals
+    int days; // days of the season (1 to 31)
+    int departuresPerDay; // sailings per terminal per day (1 to 24)
+    int vessels; // vessels in the fleet
+    double zipfExponent; // skew of repeat customers (0 for uniform)
+                         // capped at an expected two sailings a day
+    double loadFactor; // average share of lane length booked
+};
+
+// Struct: GeneratorResult
+// Purpose: Number of records written to each file
+//----------------------------------------------------------------
+struct GeneratorResult
+{
+    long vessels;
+    long sailings;
+    long vehicles;
+    long reservations;
+};
+
+//================================================================
+// Function defaultGeneratorOptions returns the options of a typical season
+// (28 days, 12 departures a day, 12 vessels, Zipf exponent 1.0, 60% load)
+// for the given number of reservations
+//----------------------------------------------------------------
+GeneratorOptions defaultGeneratorOptions(long reservations);
+
+// Function generateData writes the four data files in the current directory.
+// More terminals than asked for are added if the fleet could not carry the
+// reservations at the requested load factor. Bookings follow weekday,
+// time of day and route demand curves; busy sailings fill up and spill
+// their demand to the next departure, and no booking exceeds lane capacity.
+// Returns the number of records written to each file
+// Throws an exception if an option is out of range or a file cannot be
+// written
+//----------------------------------------------------------------
+GeneratorResult generateData(const GeneratorOptions& options);
@@ -0,0 +1,162 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataLock.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the DataLock module of the Ferry
+ *              Reservation System. Blocking whole-file fcntl record locks
+ *              on POSIX, LockFileEx on Windows.
+ */
+//================================================================
+#include "dataLock.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+  #include <io.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <windows.h>
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+#endif
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const char LOCKFILENAME[] = "ferry.lock";
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static int writerFd = -1; // Lock file of this program, opened once
+static int openScopes = 0; // Nesting depth of DataWriteLock scopes
+
+//================================================================
+// Helper function openLockFile opens the lock file in directory; the
+// writer opens it read-write, creating it, and a reader opens it read-only
+// Returns -1 if a reader finds no lock file
+// Throws an exception if it cannot be opened
+//----------------------------------------------------------------
+static int openLockFile(const std::string& directory, bool writer)
+{
+    std::string name = directory.empty() ? LOCKFILENAME : directory + "/" + LOCKFILENAME;
+#ifdef _WIN32
+    int fd = writer ? _open(name.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE)
+                    : _open(name.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    int fd = writer ? ::open(name.c_str(), O_RDWR | O_CREAT, 0644) : ::open(name.c_str(), O_RDONLY);
+#endif
+    if (fd < 0 && !writer && errno == ENOENT)
+    {
+        return -1;
+    }
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + name + " (" + std::strerror(errno) + ")");
+    }
+    return fd;
+}
+
+// Helper function lockFile waits for a shared or exclusive lock on the
+// whole file, or releases it if unlock is set
+// Throws an exception if the lock cannot be taken
+//----------------------------------------------------------------
+static void lockFile(int fd, bool exclusive, bool unlock)
+{
+#ifdef _WIN32
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED whole = {};
+    BOOL ok = unlock ? UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &whole)
+                     : LockFileEx(handle, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD, &whole);
+    if (!ok && !unlock)
+    {
+        throw std::runtime_error("Cannot lock the data files.");
+    }
+#else
+    struct flock whole = {};
+    whole.l_type = unlock ? F_UNLCK : (exclusive ? F_WRLCK : F_RDLCK);
+    whole.l_whence = SEEK_SET;
+    while (::fcntl(fd, F_SETLKW, &whole) != 0)
+    {
+        if (errno != EINTR)
+        {
+            if (unlock)
+            {
+                return;
+            }
+            throw std::runtime_error(std::string("Cannot lock the data files (") + std::strerror(errno) + ")");
+        }
+    }
+#endif
+}
+
+//================================================================
+// Constructor takes the exclusive lock if this is the outermost scope
+//----------------------------------------------------------------
+DataWriteLock::DataWriteLock()
+{
+    if (openScopes == 0)
+    {
+        if (writerFd < 0)
+        {
+            writerFd = openLockFile("", true);
+        }
+        lockFile(writerFd, true, false);
+    }
+    openScopes++;
+}
+
+// Destructor releases the lock when the outermost scope ends
+//----------------------------------------------------------------
+DataWriteLock::~DataWriteLock()
+{
+    if (--openScopes == 0)
+    {
+        lockFile(writerFd, true, true);
+    }
+}
+
+// Constructor waits for the running request, if any, to finish
+//----------------------------------------------------------------
+DataReadLock::DataReadLock(const std::string& directory) : fd(openLockFile(directory, false))
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    try
+    {
+        lockFile(fd, false, false);
+    }
+    catch (...)
+    {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        throw;
+    }
+}
+
+// Destructor releases the shared lock
+//----------------------------------------------------------------
+DataReadLock::~DataReadLock()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    lockFile(fd, false, true);
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
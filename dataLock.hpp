@@ -0,0 +1,59 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: dataLock.hpp
+ *
+ * Description: Header file of the DataLock module of the Ferry
+ *              Reservation System. Separates whole requests of the running
+ *              system from readers in other processes, such as
+ *              ferryReport, that copy the data files: a request holds an
+ *              exclusive lock on ferry.lock, and a reader holds a shared
+ *              lock only while it copies the files.
+ *
+ * Design Issues: Locks are advisory (fcntl, or LockFileEx on Windows) and
+ *                only order programs that use this module
+ *                Write scopes nest; only the outermost takes the lock, so
+ *                a request that calls other requests holds it once
+ *                The lock file stays open for the life of the program,
+ *                because closing any descriptor of a file drops the
+ *                process's fcntl locks on it
+ *                A reader opens the lock file read-only and never creates
+ *                it; with no lock file no request has run in the
+ *                directory, so a reader has nothing to wait for
+ */
+//================================================================
+#pragma once
+#include <string>
+
+//================================================================
+// Class: DataWriteLock
+// Purpose: Marks one request of the running system; readers wait until
+// it ends
+//----------------------------------------------------------------
+class DataWriteLock
+{
+public:
+    // Throws an exception if the lock file cannot be opened or locked
+    DataWriteLock();
+    ~DataWriteLock();
+    DataWriteLock(const DataWriteLock&) = delete;
+    DataWriteLock& operator=(const DataWriteLock&) = delete;
+};
+
+// Class: DataReadLock
+// Purpose: Holds off requests on the data files in directory while a
+// reader copies them
+//----------------------------------------------------------------
+class DataReadLock
+{
+public:
+    // Throws an exception if the lock file cannot be opened or locked
+    explicit DataReadLock(const std::string& directory);
+    ~DataReadLock();
+    DataReadLock(const DataReadLock&) = delete;
+    DataReadLock& operator=(const DataReadLock&) = delete;
+
+private:
+    int fd; // Open lock file, -1 if there is none
+};
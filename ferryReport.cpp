@@ -0,0 +1,292 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: ferryReport.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Tool: Read-only reporting
+* Prints the sailing report or sailing manifests from the data files of
+* a running Ferry Reservation System without interfering with it. The
+* four files are mapped and copied under a shared DataReadLock, which
+* only waits for the request in progress, so the copy is a consistent
+* snapshot; the reports are then built from the copy on every core
+* while bookings continue.
+*
+* Usage: ferryReport [options] report
+*        ferryReport [options] manifest ttt-dd-hh|all
+*   --data DIR       directory of the data files (default .)
+*   --threads N      worker threads (default: all cores)
+*/
+//============================================================
+
+#include "dataLock.hpp"
+#include "mappedFile.hpp"
+#include "reservation.hpp"
+#include "sailing.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//============================================================
+// Struct: StoreCopy
+// Purpose: Private copy of the four data files at one point in time
+//------------------------------------------------------------
+struct StoreCopy
+{
+    std::vector<unsigned char> vessels;
+    std::vector<unsigned char> sailings;
+    std::vector<unsigned char> vehicles;
+    std::vector<unsigned char> reservations;
+};
+
+//============================================================
+// Function copyFile maps one data file and copies its whole records;
+// a missing file is empty
+//------------------------------------------------------------
+static std::vector<unsigned char> copyFile(const std::string& directory, const char name[], std::size_t recordSize)
+{
+    std::filesystem::path path = std::filesystem::path(directory) / name;
+    if (!std::filesystem::exists(path))
+    {
+        return std::vector<unsigned char>();
+    }
+    MappedFile file(path.string());
+    std::size_t bytes = file.size() / recordSize * recordSize;
+    return std::vector<unsigned char>(file.data(), file.data() + bytes);
+}
+
+// Function records views a copied file as records
+//------------------------------------------------------------
+template <typename T>
+static RecordView<T> records(const std::vector<unsigned char>& file)
+{
+    return RecordView<T>(reinterpret_cast<const T*>(file.data()), file.size() / sizeof(T));
+}
+
+// Function inParallel runs work(first, last, worker) on threads equal
+// slices of [0, count) and waits for them
+//------------------------------------------------------------
+template <typename Work>
+static void inParallel(std::size_t count, int threads, Work work)
+{
+    std::vector<std::thread> workers;
+    std::size_t slice = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; ++t)
+    {
+        std::size_t first = std::min(count, slice * t);
+        std::size_t last = std::min(count, first + slice);
+        workers.emplace_back(work, first, last, t);
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Function fieldText returns a fixed-length text field as a string
+//------------------------------------------------------------
+static std::string fieldText(const char field[], std::size_t size)
+{
+    return std::string(field, strnlen(field, size));
+}
+
+//============================================================
+// Function printReport prints the sailing report of printSailingReport,
+// counting each slice of the reservations on its own thread
+//------------------------------------------------------------
+static void printReport(const StoreCopy& store, int threads)
+{
+    RecordView<Sailing> sailings = records<Sailing>(store.sailings);
+    RecordView<Reservation> reservations = records<Reservation>(store.reservations);
+    std::unordered_map<std::string, std::size_t> position;
+    for (std::size_t i = 0; i < sailings.size(); ++i)
+    {
+        position[fieldText(sailings[i].sailingID, sizeof(sailings[i].sailingID))] = i;
+    }
+    std::unordered_map<std::string, float> vesselLength;
+    for (const Vessel& v : records<Vessel>(store.vessels))
+    {
+        vesselLength.emplace(fieldText(v.name, sizeof(v.name)), static_cast<float>(static_cast<int>(v.HCLL + v.LCLL)));
+    }
+
+    std::vector<std::vector<int> > counts(threads, std::vector<int>(sailings.size()));
+    inParallel(reservations.size(), threads, [&](std::size_t first, std::size_t last, int worker)
+    {
+        std::vector<int>& mine = counts[worker];
+        for (std::size_t i = first; i < last; ++i)
+        {
+            std::unordered_map<std::string, std::size_t>::const_iterator found =
+                position.find(fieldText(reservations[i].sailingID, sizeof(reservations[i].sailingID)));
+            if (found != position.end())
+            {
+                mine[found->second]++;
+            }
+        }
+    });
+
+    std::vector<std::string> lines(threads);
+    inParallel(sailings.size(), threads, [&](std::size_t first, std::size_t last, int worker)
+    {
+        char line[128];
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const Sailing& s = sailings[i];
+            int vehicles = 0;
+            for (const std::vector<int>& c : counts)
+            {
+                vehicles += c[i];
+            }
+            std::unordered_map<std::string, float>::const_iterator length =
+                vesselLength.find(fieldText(s.vesselName, sizeof(s.vesselName)));
+            float total = length == vesselLength.end() ? 0.0f : length->second;
+            float percentLenFull = ((s.lowRemainingLength + s.highRemainingLength) / total) * 100;
+            std::snprintf(line, sizeof(line), "%-12s%-28s%-10.1f%-10.1f%-12d%-12.1f\n",
+                          fieldText(s.sailingID, sizeof(s.sailingID)).c_str(),
+                          fieldText(s.vesselName, sizeof(s.vesselName)).c_str(),
+                          s.lowRemainingLength, s.highRemainingLength, vehicles, percentLenFull);
+            lines[worker] += line;
+        }
+    });
+
+    char date[9];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%y/%m/%d", std::localtime(&now));
+    std::printf("Date of Sailing Report Request: %s\n%-12s%-28s%-10s%-10s%-12s%-12s\n", date,
+                "Sailing ID", "Vessel Name", "LRL(m)", "HRL(m)", "#Vehicles", "LenFull(%)");
+    for (const std::string& text : lines)
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+    }
+}
+
+// Function printManifest prints the reservations of one sailing, or of
+// all if sailingID is "all", as exportManifest CSV rows, formatting each
+// slice of the reservations on its own thread
+//------------------------------------------------------------
+static void printManifest(const StoreCopy& store, const std::string& sailingID, int threads)
+{
+    RecordView<Reservation> reservations = records<Reservation>(store.reservations);
+    RecordView<Vehicle> vehicles = records<Vehicle>(store.vehicles);
+    std::unordered_map<std::string, const Vehicle*> registry;
+    registry.reserve(vehicles.size());
+    for (const Vehicle& v : vehicles)
+    {
+        registry.emplace(fieldText(v.vehicleLicence, sizeof(v.vehicleLicence)), &v);
+    }
+    bool all = sailingID == "all";
+
+    std::vector<std::string> rows(threads);
+    inParallel(reservations.size(), threads, [&](std::size_t first, std::size_t last, int worker)
+    {
+        char row[160];
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const Reservation& r = reservations[i];
+            std::string id = fieldText(r.sailingID, sizeof(r.sailingID));
+            if (!all && id != sailingID)
+            {
+                continue;
+            }
+            std::string licence = fieldText(r.vehicleLicence, sizeof(r.vehicleLicence));
+            std::unordered_map<std::string, const Vehicle*>::const_iterator v = registry.find(licence);
+            char length[16] = "null";
+            char height[16] = "null";
+            std::string phone;
+            if (v != registry.end())
+            {
+                std::snprintf(length, sizeof(length), "%.1f", v->second->vehicleLength);
+                std::snprintf(height, sizeof(height), "%.1f", v->second->vehicleHeight);
+                phone = fieldText(v->second->phone, sizeof(v->second->phone));
+            }
+            std::snprintf(row, sizeof(row), "%s,%s,%s,%s,%s,%s,%s\n", id.c_str(), licence.c_str(), phone.c_str(),
+                          length, height, r.isLRL ? "low" : "high", r.onBoard ? "true" : "false");
+            rows[worker] += row;
+        }
+    });
+
+    std::printf("sailingID,vehicleLicence,phone,vehicleLength,vehicleHeight,lane,onBoard\n");
+    for (const std::string& text : rows)
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+    }
+}
+
+//============================================================
+// Function main parses the options, copies the store and runs the report
+//------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string directory = ".";
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::string> command;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--data") == 0 && i + 1 < argc)
+        {
+            directory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            command.push_back(argv[i]);
+        }
+    }
+    bool report = command.size() == 1 && command[0] == "report";
+    bool manifest = command.size() == 2 && command[0] == "manifest";
+    if (!report && !manifest)
+    {
+        std::cerr << "Usage: ferryReport [--data DIR] [--threads N] report\n"
+                  << "       ferryReport [--data DIR] [--threads N] manifest ttt-dd-hh|all\n";
+        return 1;
+    }
+
+    try
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        StoreCopy store;
+        {
+            DataReadLock snapshot(directory);
+            store.vessels = copyFile(directory, "vessels.dat", sizeof(Vessel));
+            store.sailings = copyFile(directory, "sailings.dat", sizeof(Sailing));
+            store.vehicles = copyFile(directory, "vehicles.dat", sizeof(Vehicle));
+            store.reservations = copyFile(directory, "reservations.dat", sizeof(Reservation));
+        }
+        std::chrono::steady_clock::time_point copied = std::chrono::steady_clock::now();
+        if (report)
+        {
+            printReport(store, threads);
+        }
+        else
+        {
+            printManifest(store, command[1], threads);
+        }
+        std::fflush(stdout);
+        std::chrono::steady_clock::time_point done = std::chrono::steady_clock::now();
+        std::cerr << "Snapshot copied in " << std::chrono::duration<double, std::milli>(copied - start).count()
+                  << " ms; report built on " << threads << " threads in "
+                  << std::chrono::duration<double, std::milli>(done - copied).count() << " ms" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Problem reading the data files: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: ferryStandby.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Tool: Standby replica
+* Keeps a copy of the data files of a Ferry Reservation System started
+* with --standby DIR (or the replicate script command) up to date by
+* applying the change log the primary ships to DIR. Whole requests are
+* applied under the DataWriteLock, so ferry and ferryReport can be run
+* in DIR at any time; ferry takes over from the primary after a failure
+* once ferryStandby has stopped.
+*
+* Usage: ferryStandby DIR [options]
+*   --interval MS    milliseconds between polls of the log (default 100)
+*   --once           apply what has been shipped and exit
+*/
+//============================================================
+
+#include "replication.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+//============================================================
+// Function main parses the options and applies the log until stopped
+//------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string directory;
+    int interval = 100;
+    bool once = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+        {
+            interval = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--once") == 0)
+        {
+            once = true;
+        }
+        else if (directory.empty())
+        {
+            directory = argv[i];
+        }
+    }
+    if (directory.empty())
+    {
+        std::cerr << "Usage: ferryStandby DIR [--interval MS] [--once]\n";
+        return 1;
+    }
+
+    try
+    {
+        std::filesystem::create_directories(directory);
+        std::filesystem::current_path(directory);
+        standbyOpen();
+        std::chrono::steady_clock::time_point lastReport = std::chrono::steady_clock::now();
+        while (true)
+        {
+            int applied = standbyPoll();
+            if (once && applied == 0)
+            {
+                break;
+            }
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(1))
+            {
+                StandbyStatus status = standbyStatus();
+                std::cout << "Applied through " << status.appliedSequence << ", " << status.appliedRecords
+                          << " records; lag " << std::fixed << std::setprecision(3) << status.lastLagSeconds
+                          << " s, " << status.pendingBytes << " bytes pending" << std::endl;
+                lastReport = now;
+            }
+            if (applied == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+            }
+        }
+        StandbyStatus status = standbyStatus();
+        std::cout << "Applied through " << status.appliedSequence << ", " << status.appliedRecords
+                  << " records" << std::endl;
+        standbyClose();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Problem applying the log: " << e.what() << std::endl;
+        standbyClose();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: generateData.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Tool: Synthetic data generator
+* Writes vessels.dat, sailings.dat, vehicles.dat and reservations.dat
+* in the current directory using the DataGenerator module.
+*
+* Usage: generateData reservations [options]
+*   --seed N         random seed (default 2018)
+*   --vehicles N     registered vehicles (default reservations / 4)
+*   --terminals N    minimum number of terminals (default 2)
+*   --days N         days in the season, 1 to 31 (default 28)
+*   --departures N   sailings per terminal per day (default 12)
+*   --vessels N      vessels in the fleet (default 12)
+*   --zipf S         repeat customer skew, 0 for none (default 1.0)
+*   --load F         average share of lane length booked (default 0.6)
+* Nothing is written unless every value is a number in its range
+*/
+//============================================================
+
+#include "dataGenerator.hpp"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+//============================================================
+// Helper function printUsage writes the usage to standard error
+//------------------------------------------------------------
+static void printUsage()
+{
+    std::cerr << "Usage: generateData reservations [--seed N] [--vehicles N] [--terminals N]\n"
+              << "       [--days N] [--departures N] [--vessels N] [--zipf S] [--load F]\n";
+}
+
+// Helper function parseWhole reads text as a whole number from min to max
+// Returns false if text is not such a number
+//------------------------------------------------------------
+static bool parseWhole(const char text[], long min, long max, long& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min || parsed > max)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Helper function parseReal reads text as a finite number from min to max
+// Returns false if text is not such a number
+//------------------------------------------------------------
+static bool parseReal(const char text[], double min, double max, double& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    double parsed = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(parsed) || parsed < min || parsed > max)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+//============================================================
+// Function main parses the options and generates the store
+//------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    long reservations = 0;
+    if (argc < 2 || argc % 2 != 0 || !parseWhole(argv[1], 0, LONG_MAX, reservations))
+    {
+        printUsage();
+        return 1;
+    }
+    GeneratorOptions options = defaultGeneratorOptions(reservations);
+    for (int i = 2; i < argc; i += 2)
+    {
+        const char* value = argv[i + 1];
+        long whole = 0;
+        bool ok = true;
+        if (std::strcmp(argv[i], "--seed") == 0)
+        {
+            char* end = nullptr;
+            errno = 0;
+            options.seed = std::strtoull(value, &end, 10);
+            ok = end != value && *end == '\0' && errno != ERANGE && std::strchr(value, '-') == nullptr;
+        }
+        else if (std::strcmp(argv[i], "--vehicles") == 0)
+        {
+            ok = parseWhole(value, 0, LONG_MAX, options.vehicles);
+        }
+        else if (std::strcmp(argv[i], "--terminals") == 0)
+        {
+            ok = parseWhole(value, 1, 17576, whole);
+            options.terminals = static_cast<int>(whole);
+        }
+        else if (std::strcmp(argv[i], "--days") == 0)
+        {
+            ok = parseWhole(value, 1, 31, whole);
+            options.days = static_cast<int>(whole);
+        }
+        else if (std::strcmp(argv[i], "--departures") == 0)
+        {
+            ok = parseWhole(value, 1, 24, whole);
+            options.departuresPerDay = static_cast<int>(whole);
+        }
+        else if (std::strcmp(argv[i], "--vessels") == 0)
+        {
+            ok = parseWhole(value, 1, INT_MAX, whole);
+            options.vessels = static_cast<int>(whole);
+        }
+        else if (std::strcmp(argv[i], "--zipf") == 0)
+        {
+            ok = parseReal(value, 0, HUGE_VAL, options.zipfExponent);
+        }
+        else if (std::strcmp(argv[i], "--load") == 0)
+        {
+            ok = parseReal(value, 0, 1, options.loadFactor) && options.loadFactor > 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            printUsage();
+            return 1;
+        }
+        if (!ok)
+        {
+            std::cerr << "Bad value '" << value << "' for " << argv[i] << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        GeneratorResult result = generateData(options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Vessels:      " << result.vessels << "\n"
+                  << "Sailings:     " << result.sailings << "\n"
+                  << "Vehicles:     " << result.vehicles << "\n"
+                  << "Reservations: " << result.reservations << "\n"
+                  << "Generated in " << seconds << " s" << std::endl;
+        if (result.reservations < options.reservations)
+        {
+            std::cout << options.reservations - result.reservations
+                      << " reservations did not fit in the last sailings of the season." << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Problem generating data: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -6,6 +6,16 @@
  * Filename: main.cpp
  * 
  * Revision History: 
+ * Rev. 3 - 26/10/18 Modified by L. Xu
+ *        - Added the --script option to run a command script headless
+ *        - Added the --stats option; shutdown writes the latency and I/O
+ *          statistics to that file and reports a failure to write it
+ *        - Added the --trace option to write a Chrome trace of the run
+ *        - Added the --metrics and --metrics-interval options to write
+ *          Prometheus metrics while running
+ *        - Added the --standby option to ship changes to a standby
+ *          directory
+ *        - --metrics-interval must be a whole number of seconds
  * Rev. 2 - 25/07/21 Modified by A. Kong
  *        - implemented init, startAccepting, and shutdown
  *        - removed stopAccepting
@@ -20,6 +30,8 @@
 //================================================================
 
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 #include "ui.hpp"
 #include "sailingManager.hpp"
 #include "reservationManager.hpp"
@@ -27,6 +39,10 @@
 #include "vessel.hpp"
 #include "sailing.hpp"
 #include "vehicle.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "replication.hpp"
 using std::endl; 
 using std::cout;
 
@@ -53,29 +69,129 @@ void startAccepting()
     displayCurrentMenu();
 }
 
-// Function shutdown shuts down all modules, excluding the UI module
+// Function shutdown shuts down all modules, excluding the UI module,
+// and writes the statistics to statsName if it is given
 //----------------------------------------------------------------
-void shutdown()
+void shutdown(const char statsName[])
 {
     std::cout << "Shutting down program" << std::endl;
     vehicleClose();
     vesselClose();
     reservationClose();
     sailingClose();
+    replicationStop();
+    if (statsName != nullptr)
+    {
+        // a missing stats file should not lose the rest of the shutdown
+        try
+        {
+            writeStatsFile(statsName);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    metricsStop();
+    traceStop();
     return;
 }
 
 //----------------------------------------------------------------
 
-int main()
+int main(int argc, char* argv[])
 {
+    // options: --script FILE runs a command script instead of the menus,
+    // --trace FILE writes a Chrome trace of the whole run, --metrics FILE
+    // writes Prometheus metrics every --metrics-interval seconds (15),
+    // --standby DIR ships every change to a standby directory, --stats FILE
+    // writes the latency and I/O statistics at exit
+    const char* scriptName = nullptr;
+    const char* traceName = nullptr;
+    const char* metricsName = nullptr;
+    int metricsInterval = 15;
+    const char* standbyName = nullptr;
+    const char* statsName = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--script") == 0)
+        {
+            scriptName = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0)
+        {
+            traceName = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--metrics") == 0)
+        {
+            metricsName = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--metrics-interval") == 0)
+        {
+            char* end = nullptr;
+            long seconds = std::strtol(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end != '\0' || seconds < 1 || seconds > 86400)
+            {
+                std::cout << "--metrics-interval must be a whole number of seconds from 1 to 86400"
+                          << std::endl;
+                return 1;
+            }
+            metricsInterval = static_cast<int>(seconds);
+        }
+        else if (std::strcmp(argv[i], "--standby") == 0)
+        {
+            standbyName = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0)
+        {
+            statsName = argv[i + 1];
+        }
+    }
+    if (traceName != nullptr)
+    {
+        traceStart(traceName);
+    }
+
     // initialize necessary modules
     init();
-    // initialize UI module
-    startAccepting();
+    if (metricsName != nullptr)
+    {
+        metricsStart(metricsName, metricsInterval);
+    }
+    if (standbyName != nullptr)
+    {
+        // run without a standby rather than not at all
+        try
+        {
+            replicationStart(standbyName);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    int failed = 0;
+    if (scriptName != nullptr)
+    {
+        // run a command script instead of the menus
+        try
+        {
+            failed = runScript(scriptName);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << e.what() << std::endl;
+            failed = 1;
+        }
+    }
+    else
+    {
+        // initialize UI module
+        startAccepting();
+    }
     // shutdown all modules
-    shutdown();
-    return 0;
+    shutdown(statsName);
+    return failed == 0 ? 0 : 1;
 }      
 
 /*
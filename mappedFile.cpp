@@ -0,0 +1,163 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: mappedFile.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the MappedFile module of the Ferry
+ *              Reservation System. Uses mmap, or CreateFileMapping and
+ *              MapViewOfFile on Windows, and falls back to reading the
+ *              file when the system refuses the mapping.
+ */
+//================================================================
+#include "mappedFile.hpp"
+#include <fstream>
+#include <stdexcept>
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+//================================================================
+// Helper function readWhole reads the whole file into contents
+// Throws an exception if the file cannot be read
+//----------------------------------------------------------------
+static void readWhole(const std::string& fileName, std::vector<unsigned char>& contents)
+{
+    std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+    {
+        throw std::runtime_error("Cannot open " + fileName + " for reading.");
+    }
+    std::streamoff size = in.tellg();
+    contents.resize(static_cast<std::size_t>(size));
+    in.seekg(0, std::ios::beg);
+    if (size > 0 && !in.read(reinterpret_cast<char*>(contents.data()), size))
+    {
+        throw std::runtime_error("Error reading from file " + fileName + ".");
+    }
+}
+
+//================================================================
+// Constructor makes an empty file
+//----------------------------------------------------------------
+MappedFile::MappedFile() : bytes(nullptr), length(0), mapped(false)
+{
+}
+
+// Constructor maps the named file, or reads it if it cannot be mapped
+//----------------------------------------------------------------
+MappedFile::MappedFile(const std::string& fileName) : bytes(nullptr), length(0), mapped(false)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Cannot open " + fileName + " for reading.");
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(handle, &size) && size.QuadPart > 0)
+    {
+        // The view keeps the mapping alive once both handles are closed
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (view != nullptr)
+            {
+                bytes = static_cast<const unsigned char*>(view);
+                length = static_cast<std::size_t>(size.QuadPart);
+                mapped = true;
+            }
+        }
+    }
+    CloseHandle(handle);
+#else
+    int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + fileName + " for reading.");
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        void* view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            bytes = static_cast<const unsigned char*>(view);
+            length = static_cast<std::size_t>(status.st_size);
+            mapped = true;
+        }
+    }
+    close(fd);
+#endif
+    if (!mapped)
+    {
+        // Empty files have nothing to map; anything else is read instead
+        readWhole(fileName, copy);
+        bytes = copy.data();
+        length = copy.size();
+    }
+}
+
+// Destructor unmaps the file
+//----------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+// Move constructor takes over the mapping
+//----------------------------------------------------------------
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : bytes(other.bytes), length(other.length), mapped(other.mapped), copy(std::move(other.copy))
+{
+    other.bytes = nullptr;
+    other.length = 0;
+    other.mapped = false;
+}
+
+// Move assignment releases this mapping and takes over the other
+//----------------------------------------------------------------
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        bytes = other.bytes;
+        length = other.length;
+        mapped = other.mapped;
+        copy = std::move(other.copy);
+        other.bytes = nullptr;
+        other.length = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+// Function release unmaps the file and empties the contents
+//----------------------------------------------------------------
+void MappedFile::release()
+{
+    if (mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+    }
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    copy.clear();
+}
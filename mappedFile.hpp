@@ -0,0 +1,105 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: mappedFile.hpp
+ *
+ * Description: Header file of the MappedFile module of the Ferry
+ *              Reservation System. Maps a data file read-only into memory
+ *              and hands out views of its fixed-length records, so scans
+ *              compare fields in place instead of copying every record
+ *              into a struct first.
+ *
+ * Design Issues: A RecordView points into its RecordSnapshot and must not
+ *                outlive it
+ *                The mapping is shared, so a snapshot sees records written
+ *                in place after it was taken (updateSailingRecord,
+ *                markReservationsOnBoard, the delete that moves the last
+ *                record into the gap). Only later appends are not seen,
+ *                and files replaced by rename keep the old contents mapped.
+ *                A file truncated in place (deleteReservation,
+ *                deleteSailingReservations) must not be mapped across the
+ *                truncate, so snapshots are kept to the scope of one scan
+ *                If the file cannot be mapped it is read into memory
+ *                instead, with the same interface; that copy does not see
+ *                in-place writes either
+ */
+//================================================================
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+//================================================================
+// Class: MappedFile
+// Purpose: Read-only contents of a whole file, mapped or copied
+//----------------------------------------------------------------
+class MappedFile
+{
+public:
+    MappedFile();
+    // Maps fileName; throws an exception if it cannot be opened or read
+    explicit MappedFile(const std::string& fileName);
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+    // Returns false if the contents were copied instead of mapped
+    bool isMapped() const { return mapped; }
+
+private:
+    void release();
+
+    const unsigned char* bytes; // Start of the contents
+    std::size_t length; // Size of the contents in bytes
+    bool mapped; // Contents are a mapping, not the copy below
+    std::vector<unsigned char> copy; // Contents when mapping failed
+};
+
+//================================================================
+// Class: RecordView
+// Purpose: Non-owning view of consecutive records, like std::span
+//----------------------------------------------------------------
+template <typename T>
+class RecordView
+{
+public:
+    RecordView() : first(nullptr), count(0) {}
+    RecordView(const T* records, std::size_t recordCount) : first(records), count(recordCount) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    const T* data() const { return first; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](std::size_t i) const { return first[i]; }
+
+private:
+    const T* first; // First record
+    std::size_t count; // Number of records
+};
+
+//================================================================
+// Class: RecordSnapshot
+// Purpose: Owns a mapped record file; its views stay valid while it lives
+//----------------------------------------------------------------
+template <typename T>
+class RecordSnapshot
+{
+public:
+    explicit RecordSnapshot(MappedFile mappedFile) : file(std::move(mappedFile)) {}
+
+    // Function records returns every whole record in the file
+    RecordView<T> records() const
+    {
+        return RecordView<T>(reinterpret_cast<const T*>(file.data()), file.size() / sizeof(T));
+    }
+
+private:
+    MappedFile file; // Mapped file the views point into
+};
@@ -0,0 +1,268 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: metrics.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Exported Bloom filter queries, misses and false positives
+ *        - Exported the bytes shipped to the standby and its lag
+ *        - writeMetricsFile is public so one-off exports also replace the
+ *          file by rename
+ *
+ * Description: Implementation file of the Metrics module of the Ferry
+ *              Reservation System. Writes the Prometheus text exposition
+ *              format (version 0.0.4): counters, gauges per data file, the
+ *              storage I/O counters and one histogram per timed function.
+ */
+//================================================================
+#include "metrics.hpp"
+#include "stats.hpp"
+#include "bloomFilter.hpp"
+#include "replication.hpp"
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static long long counters[METRICCOUNTERS];
+static std::string metricsFileName;
+static std::chrono::steady_clock::duration metricsInterval;
+static std::chrono::steady_clock::time_point lastWrite;
+
+// Name and help text of each counter
+static const char* COUNTERNAMES[METRICCOUNTERS][2] =
+{
+    {"ferry_bookings_total", "Reservations made."},
+    {"ferry_cancellations_total", "Reservations cancelled."},
+    {"ferry_check_ins_total", "Vehicles checked in."},
+    {"ferry_capacity_rejections_total", "Bookings refused for lack of lane space."},
+    {"ferry_sailings_created_total", "Sailings created."}
+};
+
+// Data files and their record sizes
+static const struct
+{
+    const char* fileName;
+    std::size_t recordSize;
+} DATAFILES[] =
+{
+    {"vessels.dat", sizeof(Vessel)},
+    {"sailings.dat", sizeof(Sailing)},
+    {"vehicles.dat", sizeof(Vehicle)},
+    {"reservations.dat", sizeof(Reservation)}
+};
+
+// Upper bounds of the latency histogram buckets, in seconds
+static const double LATENCYBOUNDS[] = {1e-5, 1e-4, 1e-3, 1e-2, 0.1, 1.0, 10.0};
+
+//================================================================
+// Helper function label escapes a label value
+//----------------------------------------------------------------
+static std::string label(const char text[])
+{
+    std::string escaped;
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            escaped += '\\';
+        }
+        if (*c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += *c;
+    }
+    return escaped;
+}
+
+// Helper function header writes the HELP and TYPE lines of a metric
+//----------------------------------------------------------------
+static void header(std::ostream& out, const char name[], const char help[], const char type[])
+{
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+// Helper function exportMetrics writes the periodic metrics file
+//----------------------------------------------------------------
+static void exportMetrics()
+{
+    writeMetricsFile(metricsFileName.c_str());
+    lastWrite = std::chrono::steady_clock::now();
+}
+
+//================================================================
+// Function writeMetricsFile writes the metrics to a temporary file and
+// renames it over fileName, so a scraper never reads half a file
+//----------------------------------------------------------------
+void writeMetricsFile(const char fileName[])
+{
+    std::string temporary = std::string(fileName) + ".tmp";
+    {
+        std::ofstream out(temporary);
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write metrics file " + temporary);
+        }
+        writeMetrics(out);
+        if (!out)
+        {
+            throw std::runtime_error("Error writing metrics file " + temporary);
+        }
+    }
+#ifdef _WIN32
+    std::remove(fileName);
+#endif
+    if (std::rename(temporary.c_str(), fileName) != 0)
+    {
+        throw std::runtime_error(std::string("Cannot replace metrics file ") + fileName);
+    }
+}
+
+// Function countMetric adds count events to a counter
+//----------------------------------------------------------------
+void countMetric(MetricCounter counter, long long count)
+{
+    counters[counter] += count;
+}
+
+// Function metricValue returns the value of a counter
+//----------------------------------------------------------------
+long long metricValue(MetricCounter counter)
+{
+    return counters[counter];
+}
+
+// Function metricsStart writes the metrics every intervalSeconds
+//----------------------------------------------------------------
+void metricsStart(const char fileName[], int intervalSeconds)
+{
+    metricsFileName = fileName;
+    metricsInterval = std::chrono::seconds(intervalSeconds);
+    exportMetrics();
+}
+
+// Function metricsTick writes the metrics file if the interval has passed
+//----------------------------------------------------------------
+void metricsTick()
+{
+    if (!metricsFileName.empty() && std::chrono::steady_clock::now() - lastWrite >= metricsInterval)
+    {
+        exportMetrics();
+    }
+}
+
+// Function metricsStop writes the metrics file a last time and stops
+//----------------------------------------------------------------
+void metricsStop()
+{
+    if (!metricsFileName.empty())
+    {
+        exportMetrics();
+        metricsFileName.clear();
+    }
+}
+
+// Function writeMetrics writes every metric in Prometheus text format
+//----------------------------------------------------------------
+void writeMetrics(std::ostream& out)
+{
+    for (int c = 0; c < METRICCOUNTERS; ++c)
+    {
+        header(out, COUNTERNAMES[c][0], COUNTERNAMES[c][1], "counter");
+        out << COUNTERNAMES[c][0] << " " << counters[c] << "\n";
+    }
+
+    // Sizes of the data files; every file holds fixed-length records
+    std::uintmax_t sizes[4];
+    for (int f = 0; f < 4; ++f)
+    {
+        std::error_code error;
+        sizes[f] = std::filesystem::file_size(DATAFILES[f].fileName, error);
+        if (error)
+        {
+            sizes[f] = 0;
+        }
+    }
+    header(out, "ferry_records", "Records stored in each data file.", "gauge");
+    for (int f = 0; f < 4; ++f)
+    {
+        out << "ferry_records{file=\"" << DATAFILES[f].fileName << "\"} "
+            << sizes[f] / DATAFILES[f].recordSize << "\n";
+    }
+    header(out, "ferry_file_size_bytes", "Size of each data file.", "gauge");
+    for (int f = 0; f < 4; ++f)
+    {
+        out << "ferry_file_size_bytes{file=\"" << DATAFILES[f].fileName << "\"} " << sizes[f] << "\n";
+    }
+
+    static const char* EVENTNAMES[IOEVENTS] = {"read", "written", "seek", "flush", "truncate", "reopen"};
+    header(out, "ferry_storage_io_total", "Storage module I/O events.", "counter");
+    for (int m = 0; m < STORAGEMODULES; ++m)
+    {
+        for (int e = 0; e < IOEVENTS; ++e)
+        {
+            out << "ferry_storage_io_total{module=\"" << storageModuleName(static_cast<StorageModule>(m))
+                << "\",event=\"" << EVENTNAMES[e] << "\"} "
+                << ioCount(static_cast<StorageModule>(m), static_cast<IoEvent>(e)) << "\n";
+        }
+    }
+
+    header(out, "ferry_bloom_queries_total", "Lookups asked of each Bloom filter.", "counter");
+    for (const BloomFilter* f : bloomFilters())
+    {
+        out << "ferry_bloom_queries_total{filter=\"" << f->name() << "\"} " << f->queries() << "\n";
+    }
+    header(out, "ferry_bloom_definite_misses_total", "Lookups a Bloom filter answered without reading the file.", "counter");
+    for (const BloomFilter* f : bloomFilters())
+    {
+        out << "ferry_bloom_definite_misses_total{filter=\"" << f->name() << "\"} " << f->definiteMisses() << "\n";
+    }
+    header(out, "ferry_bloom_false_positives_total", "Lookups a Bloom filter let through for absent keys.", "counter");
+    for (const BloomFilter* f : bloomFilters())
+    {
+        out << "ferry_bloom_false_positives_total{filter=\"" << f->name() << "\"} " << f->falsePositiveCount() << "\n";
+    }
+    header(out, "ferry_bloom_expected_false_positive_rate", "False-positive rate predicted from keys and bits.", "gauge");
+    for (const BloomFilter* f : bloomFilters())
+    {
+        out << "ferry_bloom_expected_false_positive_rate{filter=\"" << f->name() << "\"} " << f->expectedFalsePositiveRate() << "\n";
+    }
+
+    ReplicationStatus replication = replicationStatus();
+    header(out, "ferry_replication_shipped_bytes_total", "Log bytes shipped to the standby.", "counter");
+    out << "ferry_replication_shipped_bytes_total " << replication.shippedBytes << "\n";
+    if (replication.appliedSequence >= 0)
+    {
+        header(out, "ferry_replication_lag_records", "Log records shipped but not yet applied by the standby.", "gauge");
+        out << "ferry_replication_lag_records " << replication.committedSequence - replication.appliedSequence << "\n";
+    }
+    header(out, "ferry_replication_lag_seconds", "Age of the oldest change the standby has not applied.", "gauge");
+    out << "ferry_replication_lag_seconds " << replication.lagSeconds << "\n";
+
+    header(out, "ferry_operation_duration_seconds", "Latency of storage and manager functions.", "histogram");
+    for (const LatencyHistogram* h : latencyHistograms())
+    {
+        std::string name = label(h->name);
+        for (double bound : LATENCYBOUNDS)
+        {
+            out << "ferry_operation_duration_seconds_bucket{operation=\"" << name << "\",le=\"" << bound << "\"} "
+                << latencyCountAtMost(*h, static_cast<long long>(bound * 1e9)) << "\n";
+        }
+        out << "ferry_operation_duration_seconds_bucket{operation=\"" << name << "\",le=\"+Inf\"} " << h->calls << "\n"
+            << "ferry_operation_duration_seconds_sum{operation=\"" << name << "\"} " << h->totalNs / 1e9 << "\n"
+            << "ferry_operation_duration_seconds_count{operation=\"" << name << "\"} " << h->calls << "\n";
+    }
+}
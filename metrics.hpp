@@ -0,0 +1,65 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: metrics.hpp
+ *
+ * Description: Header file of the Metrics module of the Ferry Reservation
+ *              System. Keeps business counters (bookings, cancellations,
+ *              check ins, bookings rejected for lack of lane space,
+ *              sailings created) updated by the managers, and writes them
+ *              with record count and file size gauges and the latency
+ *              histograms of the Stats module in Prometheus text format.
+ *
+ * Design Issues: Nothing is rescanned: gauges come from the file sizes and
+ *                latencies from the Stats histograms
+ *                The system is single threaded, so the file is written
+ *                from metricsTick() between operations rather than from a
+ *                timer thread
+ *                The file is written to a temporary name and renamed, so a
+ *                scraper never reads half a file
+ */
+//================================================================
+#pragma once
+#include <iostream>
+
+//================================================================
+// Enum: MetricCounter
+// Purpose: Business events counted by the managers
+//----------------------------------------------------------------
+enum MetricCounter {bookingsTotal, cancellationsTotal, checkInsTotal, capacityRejectionsTotal,
+                    sailingsCreatedTotal, METRICCOUNTERS};
+
+//================================================================
+// Function countMetric adds count events to a counter
+//----------------------------------------------------------------
+void countMetric(MetricCounter counter, long long count = 1);
+
+// Function metricValue returns the value of a counter
+//----------------------------------------------------------------
+long long metricValue(MetricCounter counter);
+
+// Function metricsStart writes the metrics to fileName every
+// intervalSeconds from now on (see metricsTick), and once right away
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+void metricsStart(const char fileName[], int intervalSeconds);
+
+// Function metricsTick writes the metrics file if the interval has passed
+// since the last write. Does nothing unless metricsStart was called.
+//----------------------------------------------------------------
+void metricsTick();
+
+// Function metricsStop writes the metrics file a last time and stops
+//----------------------------------------------------------------
+void metricsStop();
+
+// Function writeMetrics writes every metric in Prometheus text format
+//----------------------------------------------------------------
+void writeMetrics(std::ostream& out);
+
+// Function writeMetricsFile writes every metric to a temporary file and
+// renames it over fileName
+// Throws an exception if the file cannot be written or replaced
+//----------------------------------------------------------------
+void writeMetricsFile(const char fileName[]);
@@ -0,0 +1,552 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: replication.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the Replication module of the
+ *              Ferry Reservation System. The primary writes records
+ *              through a 1MB stdio buffer flushed at each commit. The
+ *              standby reads the log from its last position, collects
+ *              records until a commit and then applies the group under a
+ *              DataWriteLock, so ferryReport can read the standby.
+ *
+ * Design Issues: A record at the end of the log that is short or fails
+ *                its checksum is still being written and is read again
+ *                on the next poll
+ *                standby.pos holds the sequence, ship time and log
+ *                position of the last commit applied and the log
+ *                generation, so a restarted standby resumes where it was
+ */
+//================================================================
+#include "replication.hpp"
+#include "atomicFile.hpp"
+#include "dataLock.hpp"
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include "vehicle.hpp"
+#include "vessel.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const char LOGMAGIC[4] = {'F', 'L', 'R', '1'}; // Start of every record
+static const char LOGFILENAME[] = "shipping.log"; // Log in the standby directory
+static const char POSITIONFILENAME[] = "standby.pos"; // Last commit the standby applied
+static const std::size_t LOGBUFFERBYTES = 1 << 20; // stdio buffer of the log
+static const std::size_t MAXUNAPPLIED = 100000; // Commits remembered for the lag
+
+//============================================================
+// Module scope static variables: primary side
+//------------------------------------------------------------
+static std::FILE* logFile = nullptr; // Log being shipped, nullptr if not shipping
+static std::string standbyDirectory; // Where the log goes
+static std::uint64_t nextSequence = 1; // Sequence of the next record
+static std::uint64_t shippedGeneration = 0; // Generation of the log being shipped
+static int requestDepth = 0; // Open shipRequestBegin scopes
+static bool uncommitted = false; // Records shipped since the last commit
+static long long shippedRecords = 0;
+static long long shippedBytes = 0;
+static long long committedSequence = 0;
+static std::deque<std::pair<long long, std::int64_t> > unapplied; // commit sequence, ship time
+
+//============================================================
+// Module scope static variables: standby side
+//------------------------------------------------------------
+static std::FILE* standbyLog = nullptr; // Log being applied
+static long long logPosition = 0; // Offset after the last commit applied
+static std::uint64_t logGeneration = 0; // Generation of the log being applied
+static std::fstream standbyFiles[STORAGEMODULES]; // Standby copies of the data files
+static StandbyStatus progress = {};
+
+//================================================================
+// Helper function nowNs returns the wall clock time in nanoseconds
+//----------------------------------------------------------------
+static std::int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Helper function dataFileName returns the file name of a storage module
+//----------------------------------------------------------------
+static std::string dataFileName(int file)
+{
+    return std::string(storageModuleName(static_cast<StorageModule>(file))) + ".dat";
+}
+
+// Function logChecksum is FNV-1a over the header, checksum zeroed, and payload
+//----------------------------------------------------------------
+std::uint32_t logChecksum(const LogRecordHeader& header, const unsigned char payload[])
+{
+    LogRecordHeader copy = header;
+    copy.checksum = 0;
+    std::uint32_t hash = 2166136261u;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&copy);
+    for (std::size_t i = 0; i < sizeof(copy); ++i)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (std::uint64_t i = 0; i < header.payloadBytes; ++i)
+    {
+        hash = (hash ^ payload[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//================================================================
+// Helper function stopShipping closes the log after a failed write; the
+// primary carries on without a standby
+//----------------------------------------------------------------
+static void stopShipping(const char reason[])
+{
+    std::cerr << "Replication to " << standbyDirectory << " stopped: " << reason << std::endl;
+    std::fclose(logFile);
+    logFile = nullptr;
+}
+
+// Helper function putRecord writes one record to the log buffer
+// Returns false if the write failed
+//----------------------------------------------------------------
+static bool putRecord(std::FILE* log, LogRecordKind kind, int file, long long offset, const void* data, std::size_t bytes)
+{
+    LogRecordHeader header = {};
+    std::memcpy(header.magic, LOGMAGIC, sizeof(header.magic));
+    header.sequence = nextSequence++;
+    header.shippedNs = nowNs();
+    header.offset = offset;
+    header.payloadBytes = bytes;
+    header.file = static_cast<std::uint8_t>(file);
+    header.kind = static_cast<std::uint8_t>(kind);
+    header.checksum = logChecksum(header, static_cast<const unsigned char*>(data));
+    if (std::fwrite(&header, sizeof(header), 1, log) != 1 ||
+        (bytes > 0 && std::fwrite(data, 1, bytes, log) != bytes))
+    {
+        return false;
+    }
+    shippedRecords++;
+    shippedBytes += static_cast<long long>(sizeof(header) + bytes);
+    if (kind == logCommit)
+    {
+        committedSequence = static_cast<long long>(header.sequence);
+        if (unapplied.size() == MAXUNAPPLIED)
+        {
+            unapplied.pop_front();
+        }
+        unapplied.push_back(std::make_pair(committedSequence, header.shippedNs));
+    }
+    return true;
+}
+
+// Helper function commit ends the records shipped since the last commit
+// and hands them to the operating system in one write
+//----------------------------------------------------------------
+static void commit()
+{
+    if (logFile == nullptr || !uncommitted)
+    {
+        return;
+    }
+    uncommitted = false;
+    if (!putRecord(logFile, logCommit, 0, 0, nullptr, 0) || std::fflush(logFile) != 0)
+    {
+        stopShipping("cannot write the log");
+    }
+}
+
+// Helper function ship writes a change record, committing it at once if
+// no request is open
+//----------------------------------------------------------------
+static void ship(LogRecordKind kind, StorageModule file, long long offset, const void* data, std::size_t bytes)
+{
+    if (logFile == nullptr)
+    {
+        return;
+    }
+    if (!putRecord(logFile, kind, file, offset, data, bytes))
+    {
+        stopShipping("cannot write the log");
+        return;
+    }
+    uncommitted = true;
+    if (requestDepth == 0)
+    {
+        commit();
+    }
+}
+
+//================================================================
+// Function replicationStart writes a new log holding a start record and
+// the four files, renames it into place and keeps it open for appends
+//----------------------------------------------------------------
+void replicationStart(const char standbyDir[])
+{
+    TIME_FUNCTION("replicationStart");
+    replicationStop();
+    std::filesystem::create_directories(standbyDir);
+    std::string logName = (std::filesystem::path(standbyDir) / LOGFILENAME).string();
+    std::string temporary = logName + ".tmp";
+    std::FILE* log = std::fopen(temporary.c_str(), "wb");
+    if (log == nullptr)
+    {
+        throw std::runtime_error("Cannot create " + temporary);
+    }
+    nextSequence = 1;
+    shippedRecords = 0;
+    shippedBytes = 0;
+    unapplied.clear();
+    std::uint64_t generation = static_cast<std::uint64_t>(nowNs());
+    shippedGeneration = generation;
+    bool ok = putRecord(log, logStart, 0, 0, &generation, sizeof(generation));
+    {
+        RecordSnapshot<Vessel> vessels = vesselSnapshot();
+        RecordSnapshot<Sailing> sailings = sailingSnapshot();
+        RecordSnapshot<Vehicle> vehicles = vehicleSnapshot();
+        RecordSnapshot<Reservation> reservations = reservationSnapshot();
+        ok = ok && putRecord(log, logReplace, vesselStorage, 0, vessels.records().data(),
+                             vessels.records().size() * sizeof(Vessel));
+        ok = ok && putRecord(log, logReplace, sailingStorage, 0, sailings.records().data(),
+                             sailings.records().size() * sizeof(Sailing));
+        ok = ok && putRecord(log, logReplace, vehicleStorage, 0, vehicles.records().data(),
+                             vehicles.records().size() * sizeof(Vehicle));
+        ok = ok && putRecord(log, logReplace, reservationStorage, 0, reservations.records().data(),
+                             reservations.records().size() * sizeof(Reservation));
+    }
+    ok = ok && putRecord(log, logCommit, 0, 0, nullptr, 0);
+    ok = std::fclose(log) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), logName.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot write " + logName);
+    }
+    logFile = std::fopen(logName.c_str(), "ab");
+    if (logFile == nullptr)
+    {
+        throw std::runtime_error("Cannot open " + logName);
+    }
+    std::setvbuf(logFile, nullptr, _IOFBF, LOGBUFFERBYTES);
+    standbyDirectory = standbyDir;
+    uncommitted = false;
+    std::cout << "Shipping changes to " << standbyDirectory << std::endl;
+}
+
+// Function replicationStop commits what is pending and closes the log
+//----------------------------------------------------------------
+void replicationStop()
+{
+    if (logFile != nullptr)
+    {
+        commit();
+    }
+    if (logFile != nullptr)
+    {
+        std::fclose(logFile);
+        logFile = nullptr;
+    }
+}
+
+// Function replicationStatus reads standby.pos for the applied commit of
+// the current log; the lag is the age of the oldest commit after it
+//----------------------------------------------------------------
+ReplicationStatus replicationStatus()
+{
+    ReplicationStatus status = {};
+    status.shipping = logFile != nullptr;
+    status.shippedRecords = shippedRecords;
+    status.shippedBytes = shippedBytes;
+    status.committedSequence = committedSequence;
+    status.appliedSequence = -1;
+    if (standbyDirectory.empty())
+    {
+        return status;
+    }
+    std::ifstream position((std::filesystem::path(standbyDirectory) / POSITIONFILENAME).string());
+    long long applied;
+    long long shippedNs;
+    long long offset;
+    std::uint64_t generation;
+    if (position >> applied >> shippedNs >> offset >> generation && generation == shippedGeneration)
+    {
+        status.appliedSequence = applied;
+        while (!unapplied.empty() && unapplied.front().first <= applied)
+        {
+            unapplied.pop_front();
+        }
+    }
+    if (!unapplied.empty())
+    {
+        status.lagSeconds = (nowNs() - unapplied.front().second) / 1e9;
+    }
+    return status;
+}
+
+// Function shipWrite logs bytes written at offset
+//----------------------------------------------------------------
+void shipWrite(StorageModule file, long long offset, const void* data, std::size_t bytes)
+{
+    ship(logWrite, file, offset, data, bytes);
+}
+
+// Function shipTruncate logs the new size of a file
+//----------------------------------------------------------------
+void shipTruncate(StorageModule file, long long size)
+{
+    ship(logTruncate, file, size, nullptr, 0);
+}
+
+// Function shipReplace logs the whole contents of a rewritten file
+//----------------------------------------------------------------
+void shipReplace(StorageModule file, const void* data, std::size_t bytes)
+{
+    ship(logReplace, file, 0, data, bytes);
+}
+
+// Function shipRequestBegin opens a request scope
+//----------------------------------------------------------------
+void shipRequestBegin()
+{
+    requestDepth++;
+}
+
+// Function shipRequestEnd commits the request when the outermost scope ends
+//----------------------------------------------------------------
+void shipRequestEnd()
+{
+    if (--requestDepth == 0)
+    {
+        commit();
+    }
+}
+
+//================================================================
+// Helper function openStandbyFile opens a standby data file, creating it
+// Throws an exception if it cannot be opened
+//----------------------------------------------------------------
+static void openStandbyFile(int file)
+{
+    std::string name = dataFileName(file);
+    if (!std::filesystem::exists(name))
+    {
+        std::ofstream create(name, std::ios::binary);
+    }
+    standbyFiles[file].open(name, std::ios::in | std::ios::out | std::ios::binary);
+    if (!standbyFiles[file].is_open())
+    {
+        throw std::runtime_error("Cannot open " + name);
+    }
+}
+
+// Helper function readGeneration returns the generation of the log at
+// its start record, or 0 if it cannot be read
+//----------------------------------------------------------------
+static std::uint64_t readGeneration(std::FILE* log)
+{
+    LogRecordHeader header;
+    std::uint64_t generation = 0;
+    std::rewind(log);
+    if (std::fread(&header, sizeof(header), 1, log) == 1 && header.kind == logStart &&
+        std::fread(&generation, sizeof(generation), 1, log) == 1)
+    {
+        return generation;
+    }
+    return 0;
+}
+
+// Helper function savePosition records the last commit applied
+//----------------------------------------------------------------
+static void savePosition(std::int64_t shippedNs)
+{
+    std::string temporary = std::string(POSITIONFILENAME) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << progress.appliedSequence << " " << shippedNs << " " << logPosition << " " << logGeneration << "\n";
+    }
+    std::rename(temporary.c_str(), POSITIONFILENAME);
+}
+
+// Helper function applyRecord applies one change to the standby files
+// Throws an exception if a file cannot be written
+//----------------------------------------------------------------
+static void applyRecord(const LogRecordHeader& header, const std::vector<unsigned char>& payload)
+{
+    if (header.kind == logStart || header.kind == logCommit)
+    {
+        return;
+    }
+    if (header.file >= STORAGEMODULES)
+    {
+        throw std::runtime_error(std::string(LOGFILENAME) + " is corrupt.");
+    }
+    std::fstream& file = standbyFiles[header.file];
+    std::string name = dataFileName(header.file);
+    if (header.kind == logWrite)
+    {
+        file.clear();
+        file.seekp(header.offset, std::ios::beg);
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file)
+        {
+            throw std::runtime_error("Cannot write " + name);
+        }
+        return;
+    }
+    // Truncates and rewrites go around the stream
+    file.close();
+    if (header.kind == logTruncate)
+    {
+        std::filesystem::resize_file(name, static_cast<std::uintmax_t>(header.offset));
+    }
+    else
+    {
+        rewriteAtomically(name, payload.data(), payload.size());
+    }
+    openStandbyFile(header.file);
+}
+
+// Function standbyOpen opens the standby files and resumes from
+// standby.pos if it belongs to the current log
+//----------------------------------------------------------------
+void standbyOpen()
+{
+    for (int file = 0; file < STORAGEMODULES; ++file)
+    {
+        openStandbyFile(file);
+    }
+    std::ifstream position(POSITIONFILENAME);
+    long long sequence = 0;
+    long long shippedNs = 0;
+    if (position >> sequence >> shippedNs >> logPosition >> logGeneration)
+    {
+        progress.appliedSequence = sequence;
+    }
+    else
+    {
+        logPosition = 0;
+        logGeneration = 0;
+    }
+}
+
+// Function standbyPoll follows the log from the last commit applied,
+// switching to a new log when the primary restarts shipping
+//----------------------------------------------------------------
+int standbyPoll()
+{
+    if (standbyLog == nullptr)
+    {
+        standbyLog = std::fopen(LOGFILENAME, "rb");
+        if (standbyLog == nullptr)
+        {
+            return 0;
+        }
+    }
+    std::uint64_t generation = readGeneration(standbyLog);
+    if (generation != logGeneration)
+    {
+        if (generation == 0)
+        {
+            return 0; // a new log is still being written
+        }
+        logGeneration = generation;
+        logPosition = 0;
+    }
+
+    int applied = 0;
+    std::vector<std::pair<LogRecordHeader, std::vector<unsigned char> > > group;
+    long long groupEnd = logPosition;
+    std::fseek(standbyLog, static_cast<long>(logPosition), SEEK_SET);
+    while (true)
+    {
+        LogRecordHeader header;
+        if (std::fread(&header, sizeof(header), 1, standbyLog) != 1)
+        {
+            break;
+        }
+        if (std::memcmp(header.magic, LOGMAGIC, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error(std::string(LOGFILENAME) + " is corrupt.");
+        }
+        std::vector<unsigned char> payload(static_cast<std::size_t>(header.payloadBytes));
+        if ((!payload.empty() && std::fread(payload.data(), 1, payload.size(), standbyLog) != payload.size()) ||
+            logChecksum(header, payload.data()) != header.checksum)
+        {
+            break; // still being written
+        }
+        groupEnd += static_cast<long long>(sizeof(header) + payload.size());
+        bool isCommit = header.kind == logCommit;
+        group.emplace_back(header, std::move(payload));
+        if (!isCommit)
+        {
+            continue;
+        }
+
+        // Apply the whole request while ferryReport is held off
+        {
+            DataWriteLock applying;
+            for (const std::pair<LogRecordHeader, std::vector<unsigned char> >& record : group)
+            {
+                applyRecord(record.first, record.second);
+            }
+            for (std::fstream& file : standbyFiles)
+            {
+                file.flush();
+            }
+        }
+        applied += static_cast<int>(group.size());
+        progress.appliedRecords += static_cast<long long>(group.size());
+        progress.appliedSequence = static_cast<long long>(header.sequence);
+        progress.lastLagSeconds = (nowNs() - header.shippedNs) / 1e9;
+        logPosition = groupEnd;
+        savePosition(header.shippedNs);
+        group.clear();
+    }
+    std::clearerr(standbyLog);
+    std::fseek(standbyLog, 0, SEEK_END);
+    progress.pendingBytes = std::ftell(standbyLog) - logPosition;
+
+    // At the end of the log, follow a log the primary has started anew
+    if (applied == 0)
+    {
+        std::fclose(standbyLog);
+        standbyLog = nullptr;
+    }
+    return applied;
+}
+
+// Function standbyStatus returns the progress counters
+//----------------------------------------------------------------
+StandbyStatus standbyStatus()
+{
+    return progress;
+}
+
+// Function standbyClose flushes and closes the standby files and the log
+//----------------------------------------------------------------
+void standbyClose()
+{
+    for (std::fstream& file : standbyFiles)
+    {
+        if (file.is_open())
+        {
+            file.close();
+        }
+    }
+    if (standbyLog != nullptr)
+    {
+        std::fclose(standbyLog);
+        standbyLog = nullptr;
+    }
+}
@@ -0,0 +1,152 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: replication.hpp
+ *
+ * Description: Header file of the Replication module of the Ferry
+ *              Reservation System. The primary side ships every change
+ *              the storage modules make to the data files (record writes,
+ *              truncates and whole-file rewrites) as a log in a standby
+ *              directory; the standby side, run by ferryStandby, applies
+ *              the log to its own copy of the data files.
+ *
+ * Design Issues: The log is physical: it repeats the bytes written at each
+ *                offset, so the standby files stay byte for byte equal to
+ *                the primary's whatever manager wrote them
+ *                Records of one request (a ShippedRequest scope, which the
+ *                UI opens with its DataWriteLock) end with a commit
+ *                record and reach the log in one write; the standby
+ *                only applies whole requests, so readers of the standby
+ *                never see half a booking. Changes made outside a request
+ *                are committed one by one.
+ *                Shipping starts with a copy of the four files; each start
+ *                writes a new log with a new generation, which the standby
+ *                notices and follows from its beginning
+ *                The standby writes the last commit it applied to
+ *                standby.pos, from which the primary reports the lag
+ *                A failure to write the log stops shipping with a warning
+ *                but never fails the change on the primary
+ */
+//================================================================
+#pragma once
+#include "stats.hpp"
+#include <cstddef>
+#include <cstdint>
+
+//================================================================
+// Enum: LogRecordKind
+// Purpose: What a shipped log record does
+//----------------------------------------------------------------
+enum LogRecordKind {logStart, logWrite, logTruncate, logReplace, logCommit};
+
+// Struct: LogRecordHeader
+// Purpose: Fixed header before the payload of every log record
+//----------------------------------------------------------------
+struct LogRecordHeader
+{
+    char magic[4]; // "FLR1"
+    std::uint32_t checksum; // logChecksum of the header and payload
+    std::uint64_t sequence; // Position of the record in the log, from 1
+    std::int64_t shippedNs; // Wall clock time it was shipped
+    std::int64_t offset; // Write offset, or new size for a truncate
+    std::uint64_t payloadBytes; // Bytes following the header
+    std::uint8_t file; // StorageModule of the data file
+    std::uint8_t kind; // LogRecordKind
+    std::uint8_t reserved[6]; // Zero
+};
+
+// Struct: ReplicationStatus
+// Purpose: How far the standby is behind the primary
+//----------------------------------------------------------------
+struct ReplicationStatus
+{
+    bool shipping; // A standby directory is receiving the log
+    long long shippedRecords; // Records shipped since shipping started
+    long long shippedBytes; // Bytes shipped since shipping started
+    long long committedSequence; // Sequence of the last commit shipped
+    long long appliedSequence; // Sequence of the last commit applied, -1 if unknown
+    double lagSeconds; // Age of the oldest change not yet applied
+};
+
+// Struct: StandbyStatus
+// Purpose: Progress of the standby side
+//----------------------------------------------------------------
+struct StandbyStatus
+{
+    long long appliedSequence; // Sequence of the last commit applied
+    long long appliedRecords; // Records applied since the standby started
+    long long pendingBytes; // Log bytes not yet applied
+    double lastLagSeconds; // Shipping to applying delay of the last commit
+};
+
+//================================================================
+// Function logChecksum returns the checksum of a record, computed with
+// the checksum field as zero
+//----------------------------------------------------------------
+std::uint32_t logChecksum(const LogRecordHeader& header, const unsigned char payload[]);
+
+// Function replicationStart ships a copy of the data files and then every
+// change to standbyDir, creating it if needed
+// Throws an exception if the log cannot be written
+//----------------------------------------------------------------
+void replicationStart(const char standbyDir[]);
+
+// Function replicationStop stops shipping
+//----------------------------------------------------------------
+void replicationStop();
+
+// Function replicationStatus returns what was shipped and applied
+//----------------------------------------------------------------
+ReplicationStatus replicationStatus();
+
+// Function shipWrite ships bytes written to a data file at offset
+//----------------------------------------------------------------
+void shipWrite(StorageModule file, long long offset, const void* data, std::size_t bytes);
+
+// Function shipTruncate ships a data file cut to size bytes
+//----------------------------------------------------------------
+void shipTruncate(StorageModule file, long long size);
+
+// Function shipReplace ships the whole new contents of a rewritten file
+//----------------------------------------------------------------
+void shipReplace(StorageModule file, const void* data, std::size_t bytes);
+
+// Functions shipRequestBegin and shipRequestEnd mark a request, whose
+// changes are committed together when it ends
+//----------------------------------------------------------------
+void shipRequestBegin();
+void shipRequestEnd();
+
+// Class: ShippedRequest
+// Purpose: Scope of one request whose changes are committed together
+//----------------------------------------------------------------
+class ShippedRequest
+{
+public:
+    ShippedRequest() { shipRequestBegin(); }
+    ~ShippedRequest() { shipRequestEnd(); }
+    ShippedRequest(const ShippedRequest&) = delete;
+    ShippedRequest& operator=(const ShippedRequest&) = delete;
+};
+
+//================================================================
+// Function standbyOpen starts the standby side in the working directory,
+// which must be the standby directory
+// Throws an exception if the data files cannot be opened
+//----------------------------------------------------------------
+void standbyOpen();
+
+// Function standbyPoll applies every whole request in the log
+// Returns the number of records applied
+// Throws an exception if the log is corrupt or a file cannot be written
+//----------------------------------------------------------------
+int standbyPoll();
+
+// Function standbyStatus returns the progress of the standby
+//----------------------------------------------------------------
+StandbyStatus standbyStatus();
+
+// Function standbyClose flushes and closes the standby data files
+//----------------------------------------------------------------
+void standbyClose();
@@ -0,0 +1,54 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: requestArena.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the RequestArena module of the
+ *              Ferry Reservation System. A std::pmr::monotonic_buffer_resource
+ *              over a static buffer, with the heap as its upstream.
+ */
+//================================================================
+#include "requestArena.hpp"
+#include <cstddef>
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const std::size_t ARENABYTES = 64 * 1024; // Fixed buffer per request
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+alignas(std::max_align_t) static unsigned char arenaBuffer[ARENABYTES];
+static std::pmr::monotonic_buffer_resource arena(arenaBuffer, ARENABYTES, std::pmr::new_delete_resource());
+static int openScopes = 0; // Nesting depth of RequestArena scopes
+
+//================================================================
+// Constructor opens a request scope
+//----------------------------------------------------------------
+RequestArena::RequestArena()
+{
+    openScopes++;
+}
+
+// Destructor closes the scope, releasing the arena if it was the outermost
+//----------------------------------------------------------------
+RequestArena::~RequestArena()
+{
+    if (--openScopes == 0)
+    {
+        arena.release();
+    }
+}
+
+// Function resource returns the arena
+//----------------------------------------------------------------
+std::pmr::memory_resource* RequestArena::resource() const
+{
+    return &arena;
+}
+
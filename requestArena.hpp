@@ -0,0 +1,41 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: requestArena.hpp
+ *
+ * Description: Header file of the RequestArena module of the Ferry
+ *              Reservation System. Gives each request one monotonic
+ *              memory resource for its scratch containers. Allocation is
+ *              a pointer bump into a fixed buffer, and everything is
+ *              released at once when the request ends.
+ *
+ * Design Issues: Scopes nest: a manager function opens one, and so does
+ *                the command that calls it, and only the outermost scope
+ *                releases the arena, so memory handed to a caller stays
+ *                valid until the whole request is done
+ *                Containers from the arena must not outlive the scope
+ *                that created them
+ *                Requests larger than the buffer spill to the heap in
+ *                growing chunks, which are freed on release
+ */
+//================================================================
+#pragma once
+#include <memory_resource>
+
+//================================================================
+// Class: RequestArena
+// Purpose: Marks the lifetime of one request's scratch memory
+//----------------------------------------------------------------
+class RequestArena
+{
+public:
+    RequestArena();
+    ~RequestArena();
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    // Function resource returns the memory resource for the request
+    std::pmr::memory_resource* resource() const;
+};
+
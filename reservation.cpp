@@ -5,6 +5,22 @@
 * Filename: reservation.cpp
 *
 * Revision History:
+* Rev. 3 - 26/10/18 Modified by L. Xu
+*        - Added writeReservations for appending a block of records at once
+*        - Timed public functions and counted I/O in the Stats module
+*        - Traced per-record reads
+*        - Added deleteSailingReservations, which compacts the file in
+*          place in one pass; truncation moved to truncateReservations
+*        - Added rewriteReservations for atomic whole-file rewrites
+*        - Added async appends, block reads and readahead through the
+*          AsyncIo module; synchronous functions settle them first
+*        - Added reservationSnapshot for zero-copy scans
+*        - Kept a Bloom filter of stored (sailingID, licence) pairs, rebuilt
+*          at open and after compaction and updated on every write, for
+*          reservationMayExist
+*        - Shipped every change to the Replication module
+*        - Added markReservationsOnBoard for checking in a batch of
+*          reservations with one write per run of adjacent records
 * Rev. 2 - 25/08/04 Modified by L. Xu
 *        - Fixed deleteReservation to properly overwrite
 * Rev. 1 - 25/07/23 Original by A. Chung
@@ -26,6 +42,11 @@
 //================================================================
 
 #include "reservation.hpp"
+#include "stats.hpp"
+#include "atomicFile.hpp"
+#include "asyncIo.hpp"
+#include "bloomFilter.hpp"
+#include "replication.hpp"
 #include "sailing.hpp"
 #include "vehicle.hpp"
 #include <fstream>
@@ -33,6 +54,8 @@
 #include <cstring>
 #include <cctype>
 #include <cstdio>
+#include <algorithm>
+#include <vector>
 #ifdef _WIN32
   #include <io.h>      
 #else
@@ -45,13 +68,116 @@
 //------------------------------------------------------------v
 static std::fstream reservationFile;
 static const std::string RESERVATIONFILENAME = "reservations.dat";
+static const int COMPACTBLOCKRECORDS = 4096; // Records moved per block when compacting
+static AsyncRecordFile reservationAsync = {"reservations.dat", -1, 0, 0}; // async state of the file
+static BloomFilter reservationFilter("reservations"); // (sailingID, licence) pairs stored
 //================================================================
 
+// Helper function filterKey writes the filter key of a booking, the
+// sailing ID and licence with a separator, into key
+// Returns the length of the key
+//----------------------------------------------------------------
+static std::size_t filterKey(const char sailingID[], const char vehicleLicence[], char key[])
+{
+    std::size_t idLength = strnlen(sailingID, sizeof(Reservation::sailingID));
+    std::size_t licenceLength = strnlen(vehicleLicence, sizeof(Reservation::vehicleLicence));
+    std::memcpy(key, sailingID, idLength);
+    key[idLength] = '|';
+    std::memcpy(key + idLength + 1, vehicleLicence, licenceLength);
+    return idLength + 1 + licenceLength;
+}
+
+// Helper function addToFilter adds the bookings of count records
+//----------------------------------------------------------------
+static void addToFilter(const Reservation records[], int count)
+{
+    char key[sizeof(Reservation::sailingID) + 1 + sizeof(Reservation::vehicleLicence)];
+    for (int i = 0; i < count; ++i)
+    {
+        reservationFilter.add(key, filterKey(records[i].sailingID, records[i].vehicleLicence, key));
+    }
+}
+
+// Helper function rebuildFilter refills the filter from count records,
+// sized with room for the file to double
+//----------------------------------------------------------------
+static void rebuildFilter(const Reservation records[], int count)
+{
+    reservationFilter.reset(static_cast<std::size_t>(count) * 2);
+    addToFilter(records, count);
+}
+
+// Helper function rebuildFilterFromFile refills the filter from the file
+//----------------------------------------------------------------
+static void rebuildFilterFromFile()
+{
+    reservationFile.flush();
+    RecordSnapshot<Reservation> snapshot{MappedFile(RESERVATIONFILENAME)};
+    RecordView<Reservation> records = snapshot.records();
+    rebuildFilter(records.data(), static_cast<int>(records.size()));
+}
+
+// Helper function truncateReservations cuts the reservation file down to
+// recordCount records (platform-specific) and reopens it
+// Throws an exception if the file cannot be truncated or reopened
+//----------------------------------------------------------------
+static void truncateReservations(int recordCount)
+{
+#ifdef _WIN32
+    {
+        reservationFile.flush();
+        countIo(reservationStorage, fileFlush);
+        reservationFile.close();
+        FILE* f = std::fopen(RESERVATIONFILENAME.c_str(), "r+b");
+        if (!f) 
+        {
+            throw std::runtime_error("truncateReservations: file open failed");
+        }
+        int fd = _fileno(f);
+        long newSize = static_cast<long>(recordCount * sizeof(Reservation));
+        if (_chsize_s(fd, newSize) != 0) 
+        {
+            std::fclose(f);
+            throw std::runtime_error("truncateReservations: truncate failed");
+        }
+        countIo(reservationStorage, fileTruncate);
+        std::fclose(f);
+    }
+#else
+    {
+        reservationFile.close();
+        int fd = ::open(RESERVATIONFILENAME.c_str(), O_RDWR);
+        if (fd < 0) 
+        {
+            throw std::runtime_error("truncateReservations: open failed");
+        }
+        off_t newSize = static_cast<off_t>(recordCount) * sizeof(Reservation);
+        if (ftruncate(fd, newSize) != 0) 
+        {
+            ::close(fd);
+            throw std::runtime_error("truncateReservations: truncate failed");
+        }
+        countIo(reservationStorage, fileTruncate);
+        ::close(fd);
+    }
+#endif
+
+    // Reopen file
+    reservationFile.open(RESERVATIONFILENAME,
+                       std::ios::in | std::ios::out | std::ios::binary);
+    if (!reservationFile.is_open()) {
+        throw std::runtime_error("truncateReservations: re-open failed");
+    }
+    countIo(reservationStorage, fileOpen);
+    shipTruncate(reservationStorage, static_cast<long long>(recordCount) * sizeof(Reservation));
+}
+
 // Function creates and opens reservation file.
 // Throw an exception if it cannot be opened.
 //----------------------------------------------------------------
 void reservationOpen()
 {
+    TIME_FUNCTION("reservationOpen");
 
      // Try to open the reservation file without overwriting the contents
     reservationFile.open(RESERVATIONFILENAME, std::ios::in | std::ios::out | std::ios::binary);
@@ -76,6 +202,8 @@ void reservationOpen()
             throw std::runtime_error("Cannot open " + RESERVATIONFILENAME + ".");
         } 
     }
+    countIo(reservationStorage, fileOpen);
+    rebuildFilterFromFile();
 }
 
 // Function resets to the beginning of the list.
@@ -83,6 +211,8 @@ void reservationOpen()
 //----------------------------------------------------------------
 void reservationReset()
 {
+    TIME_FUNCTION("reservationReset");
+    asyncSettle(reservationAsync);
     if (!reservationFile.is_open())
     {
         // Throw an exception if the file could not be opened
@@ -90,6 +220,7 @@ void reservationReset()
     }
     reservationFile.clear();
     reservationFile.seekg(0, std::ios::beg); // Set get position to the start of the file
+    countIo(reservationStorage, fileSeek);
 }
 
 // Function getNextReservation returns a line from the data
@@ -98,6 +229,7 @@ void reservationReset()
 //----------------------------------------------------------------
 bool getNextReservation(Reservation& r)
 {
+    TRACE_SPAN("getNextReservation");
     if (!reservationFile.is_open())
     {
         // Throw an exception if the file is not open
@@ -115,12 +247,14 @@ bool getNextReservation(Reservation& r)
     }
 
     reservationFile.flush();
+    countIo(reservationStorage, fileFlush);
 
     if (!reservationFile)
     {
         // Throw an exception if the file could not be read from
         throw std::runtime_error("Error reading from file " + RESERVATIONFILENAME + ".");
     }
+    countIo(reservationStorage, recordRead);
 
     return true;
 
@@ -131,6 +265,8 @@ bool getNextReservation(Reservation& r)
 //----------------------------------------------------------------
 void writeReservation(const Reservation& r, bool overWrite)
 {
+    TIME_FUNCTION("writeReservation");
+    asyncSettle(reservationAsync);
     //throw exception if file not opened
    if (!reservationFile.is_open())
     {
@@ -145,7 +281,9 @@ void writeReservation(const Reservation& r, bool overWrite)
     {
         
         reservationFile.seekp(0, std::ios::end); // Move to the end of the file
+        countIo(reservationStorage, fileSeek);
     }
+    long long offset = static_cast<long long>(reservationFile.tellp());
     reservationFile.write(reinterpret_cast<const char *>(&r), sizeof(Reservation));
     
     if (!reservationFile)
@@ -154,12 +292,266 @@ void writeReservation(const Reservation& r, bool overWrite)
         throw std::runtime_error("Error writing to file " + RESERVATIONFILENAME + ".");
     }
     reservationFile.flush();
+    countIo(reservationStorage, fileFlush);
+    countIo(reservationStorage, recordWritten);
+    shipWrite(reservationStorage, offset, &r, sizeof(Reservation));
+    addToFilter(&r, 1);
+    if (reservationFilter.full())
+    {
+        rebuildFilterFromFile();
+    }
+}
+
+// Function writeReservations appends count reservations to the
+// reservation file using one write and one flush
+// Throws an exception if it fails
+//----------------------------------------------------------------
+void writeReservations(const Reservation reservations[], int count)
+{
+    TIME_FUNCTION("writeReservations");
+    asyncSettle(reservationAsync);
+    if (!reservationFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + RESERVATIONFILENAME + " is not open.");
+    }
+    if (count <= 0)
+    {
+        return;
+    }
+
+    // Write the whole block at the end
+    reservationFile.clear();
+    reservationFile.seekp(0, std::ios::end);
+    countIo(reservationStorage, fileSeek);
+    long long offset = static_cast<long long>(reservationFile.tellp());
+    reservationFile.write(reinterpret_cast<const char *>(reservations),
+                          static_cast<std::streamsize>(count) * sizeof(Reservation));
+    reservationFile.flush();
+    countIo(reservationStorage, fileFlush);
+
+    if (!reservationFile)
+    {
+        // Throw an exception if the file could not be written to
+        throw std::runtime_error("Error writing to file " + RESERVATIONFILENAME + ".");
+    }
+    countIo(reservationStorage, recordWritten, count);
+    shipWrite(reservationStorage, offset, reservations, static_cast<std::size_t>(count) * sizeof(Reservation));
+    addToFilter(reservations, count);
+    if (reservationFilter.full())
+    {
+        rebuildFilterFromFile();
+    }
+}
+
+// Function rewriteReservations replaces the whole reservation file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//----------------------------------------------------------------
+void rewriteReservations(const Reservation records[], int count)
+{
+    TIME_FUNCTION("rewriteReservations");
+    asyncRecordFileClose(reservationAsync);
+    if (!reservationFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + RESERVATIONFILENAME + " is not open.");
+    }
+    reservationFile.close();
+    std::string error;
+    try
+    {
+        rewriteAtomically(RESERVATIONFILENAME, records, static_cast<std::size_t>(count) * sizeof(Reservation));
+        countIo(reservationStorage, recordWritten, count);
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+
+    // Reopen the new file, or the untouched old one if the rewrite failed
+    reservationFile.open(RESERVATIONFILENAME, std::ios::in | std::ios::out | std::ios::binary);
+    if (!reservationFile.is_open())
+    {
+        throw std::runtime_error("Cannot open " + RESERVATIONFILENAME + ".");
+    }
+    countIo(reservationStorage, fileOpen);
+    if (!error.empty())
+    {
+        throw std::runtime_error(error);
+    }
+    shipReplace(reservationStorage, records, static_cast<std::size_t>(count) * sizeof(Reservation));
+    rebuildFilter(records, count);
+}
+
+// Function markReservationsOnBoard patches each run of consecutive record
+// numbers in memory and writes it back over itself, flushing once
+//----------------------------------------------------------------
+void markReservationsOnBoard(const int recordNumbers[], int count)
+{
+    TIME_FUNCTION("markReservationsOnBoard");
+    asyncSettle(reservationAsync);
+    if (!reservationFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + RESERVATIONFILENAME + " is not open.");
+    }
+    if (count <= 0)
+    {
+        return;
+    }
+    std::vector<int> sorted(recordNumbers, recordNumbers + count);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    reservationFile.clear();
+    reservationFile.seekg(0, std::ios::end);
+    countIo(reservationStorage, fileSeek);
+    int total = static_cast<int>(reservationFile.tellg() / static_cast<std::streamoff>(sizeof(Reservation)));
+    if (sorted.front() < 0 || sorted.back() >= total)
+    {
+        throw std::runtime_error("markReservationsOnBoard: record number out of range");
+    }
+
+    // Read each run, set the flags and write it back over itself; the
+    // runs are shipped once the flush has succeeded
+    std::vector<std::vector<Reservation> > runs;
+    std::vector<std::streamoff> offsets;
+    for (std::size_t first = 0; first < sorted.size(); )
+    {
+        std::size_t last = first;
+        while (last + 1 < sorted.size() && sorted[last + 1] == sorted[last] + 1)
+        {
+            last++;
+        }
+        std::vector<Reservation> run(last - first + 1);
+        std::streamoff offset = static_cast<std::streamoff>(sorted[first]) * sizeof(Reservation);
+        std::streamsize bytes = static_cast<std::streamsize>(run.size() * sizeof(Reservation));
+        reservationFile.seekg(offset, std::ios::beg);
+        countIo(reservationStorage, fileSeek);
+        reservationFile.read(reinterpret_cast<char*>(run.data()), bytes);
+        if (!reservationFile)
+        {
+            throw std::runtime_error("markReservationsOnBoard: Failed reading " + RESERVATIONFILENAME);
+        }
+        countIo(reservationStorage, recordRead, static_cast<int>(run.size()));
+        for (Reservation& r : run)
+        {
+            r.onBoard = true;
+        }
+        reservationFile.seekp(offset, std::ios::beg);
+        countIo(reservationStorage, fileSeek);
+        reservationFile.write(reinterpret_cast<const char*>(run.data()), bytes);
+        if (!reservationFile)
+        {
+            throw std::runtime_error("markReservationsOnBoard: Failed writing " + RESERVATIONFILENAME);
+        }
+        countIo(reservationStorage, recordWritten, static_cast<int>(run.size()));
+        runs.push_back(std::move(run));
+        offsets.push_back(offset);
+        first = last + 1;
+    }
+    reservationFile.flush();
+    countIo(reservationStorage, fileFlush);
+    if (!reservationFile)
+    {
+        throw std::runtime_error("markReservationsOnBoard: Failed writing " + RESERVATIONFILENAME);
+    }
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        shipWrite(reservationStorage, static_cast<long long>(offsets[i]), runs[i].data(),
+                  runs[i].size() * sizeof(Reservation));
+    }
+}
+
+// Function appendReservationsAsync queues count reservation records to be appended
+// through the AsyncIo backend; done gets the records written or -1
+//----------------------------------------------------------------
+void appendReservationsAsync(const Reservation records[], int count, bool sync, RecordCallback done)
+{
+    TIME_FUNCTION("appendReservationsAsync");
+    // Added when queued; a failed append only leaves a false positive
+    addToFilter(records, count);
+    long long offset = asyncAppendOffset(reservationAsync);
+    std::vector<Reservation> appended(records, records + count);
+    asyncAppend(reservationAsync, records, static_cast<std::size_t>(count) * sizeof(Reservation), sync, [count, offset, appended, done](long result)
+    {
+        bool ok = result == static_cast<long>(count * sizeof(Reservation));
+        if (ok)
+        {
+            countIo(reservationStorage, recordWritten, count);
+            shipWrite(reservationStorage, offset, appended.data(), appended.size() * sizeof(Reservation));
+        }
+        if (done)
+        {
+            done(ok ? count : -1);
+        }
+    });
+}
+
+// Function readReservationsAsync queues a read of count reservation records from
+// firstRecord into records; done gets the records read or -1
+//----------------------------------------------------------------
+void readReservationsAsync(Reservation records[], int firstRecord, int count, RecordCallback done)
+{
+    TIME_FUNCTION("readReservationsAsync");
+    asyncReadAt(reservationAsync, records, static_cast<std::size_t>(count) * sizeof(Reservation),
+                static_cast<long long>(firstRecord) * sizeof(Reservation), [done](long result)
+    {
+        int read = result < 0 ? -1 : static_cast<int>(result / static_cast<long>(sizeof(Reservation)));
+        if (read > 0)
+        {
+            countIo(reservationStorage, recordRead, read);
+        }
+        if (done)
+        {
+            done(read);
+        }
+    });
+}
+
+// Function reservationReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void reservationReadahead()
+{
+    asyncReadahead(reservationAsync);
+}
+
+// Function reservationSnapshot flushes pending writes and maps the file
+//----------------------------------------------------------------
+RecordSnapshot<Reservation> reservationSnapshot()
+{
+    TIME_FUNCTION("reservationSnapshot");
+    asyncSettle(reservationAsync);
+    if (!reservationFile.is_open())
+    {
+        throw std::runtime_error("File " + RESERVATIONFILENAME + " is not open.");
+    }
+    reservationFile.flush();
+    return RecordSnapshot<Reservation>(MappedFile(RESERVATIONFILENAME));
+}
+
+// Function reservationMayExist checks the booking against the filter
+//----------------------------------------------------------------
+bool reservationMayExist(const char sailingID[], const char vehicleLicence[])
+{
+    char key[sizeof(Reservation::sailingID) + 1 + sizeof(Reservation::vehicleLicence)];
+    return reservationFilter.mayContain(key, filterKey(sailingID, vehicleLicence, key));
+}
+
+// Function reservationFilterFalsePositive counts a wrong "maybe" of the filter
+//----------------------------------------------------------------
+void reservationFilterFalsePositive()
+{
+    reservationFilter.noteFalsePositive();
 }
 
 // Function closes reservation file
 //----------------------------------------------------------------
 void reservationClose()
 {
+    TIME_FUNCTION("reservationClose");
+    asyncRecordFileClose(reservationAsync);
 
      if (reservationFile.is_open())
     {
@@ -177,6 +569,8 @@ void reservationClose()
 //----------------------------------------------------------------
 void deleteReservation(char sailingID[], char vehicleLicence[])
 {
+    TIME_FUNCTION("deleteReservation");
+    asyncSettle(reservationAsync);
 
     // Throw an exception if the file is not open
     if (!reservationFile.is_open()) 
@@ -187,6 +581,7 @@ void deleteReservation(char sailingID[], char vehicleLicence[])
     // Get total records
     reservationFile.clear();
     reservationFile.seekg(0, std::ios::end);
+    countIo(reservationStorage, fileSeek);
     std::streampos size = reservationFile.tellg();
     int total = static_cast<int>(size / sizeof(Reservation));
     // Throw an exception if the file is empty
@@ -198,6 +593,7 @@ void deleteReservation(char sailingID[], char vehicleLicence[])
 
     // Find target index (checking BOTH sailingID AND vehicleLicence)
     reservationFile.seekg(0, std::ios::beg);
+    countIo(reservationStorage, fileSeek);
     int target = -1;
     Reservation temp;
     Reservation lastRecord;
@@ -225,6 +621,7 @@ void deleteReservation(char sailingID[], char vehicleLicence[])
 
     // Get last record
     reservationFile.seekg((total - 1) * sizeof(Reservation), std::ios::beg);
+    countIo(reservationStorage, fileSeek);
     getNextReservation(lastRecord);
     if (reservationFile.fail()) 
     {
@@ -234,6 +631,7 @@ void deleteReservation(char sailingID[], char vehicleLicence[])
     
     // Overwrite target slot with last record
     reservationFile.seekp(target * sizeof(Reservation), std::ios::beg);
+    countIo(reservationStorage, fileSeek);
     writeReservation(lastRecord, true);
     // Throw an exception if the overwriting failed
     if (reservationFile.fail()) 
@@ -288,47 +686,75 @@ void deleteReservation(char sailingID[], char vehicleLicence[])
     
 
 
-    // Truncate file (platform-specific)
-#ifdef _WIN32
+    truncateReservations(total - 1);
+}
+
+// Function deleteSailingReservations removes every reservation on the
+// sailing by compacting the file in place: blocks are read at one offset
+// and the records kept are written back at a second, lower offset
+//----------------------------------------------------------------
+int deleteSailingReservations(const char sailingID[])
+{
+    TIME_FUNCTION("deleteSailingReservations");
+    asyncSettle(reservationAsync);
+    if (!reservationFile.is_open())
     {
-        reservationFile.flush();
-        reservationFile.close();
-        FILE* f = std::fopen(RESERVATIONFILENAME.c_str(), "r+b");
-        if (!f) 
-        {
-            throw std::runtime_error("deleteReservation: file open failed");
-        }
-        int fd = _fileno(f);
-        long newSize = static_cast<long>((total - 1) * sizeof(Reservation));
-        if (_chsize_s(fd, newSize) != 0) 
-        {
-            std::fclose(f);
-            throw std::runtime_error("deleteReservation: truncate failed");
-        }
-        std::fclose(f);
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + RESERVATIONFILENAME + " is not open.");
     }
-#else
+    reservationFile.clear();
+    reservationFile.seekg(0, std::ios::end);
+    countIo(reservationStorage, fileSeek);
+    int total = static_cast<int>(reservationFile.tellg() / static_cast<std::streamoff>(sizeof(Reservation)));
+
+    std::vector<Reservation> block(COMPACTBLOCKRECORDS);
+    int readRecord = 0;
+    int writeRecord = 0;
+    while (readRecord < total)
     {
-        reservationFile.close();
-        int fd = ::open(RESERVATIONFILENAME.c_str(), O_RDWR);
-        if (fd < 0) 
+        int count = std::min(COMPACTBLOCKRECORDS, total - readRecord);
+        reservationFile.seekg(static_cast<std::streamoff>(readRecord) * sizeof(Reservation), std::ios::beg);
+        countIo(reservationStorage, fileSeek);
+        reservationFile.read(reinterpret_cast<char*>(block.data()), static_cast<std::streamsize>(count) * sizeof(Reservation));
+        if (!reservationFile)
         {
-            throw std::runtime_error("deleteReservation: open failed");
+            throw std::runtime_error("deleteSailingReservations: Failed reading " + RESERVATIONFILENAME);
         }
-        off_t newSize = static_cast<off_t>((total - 1) * sizeof(Reservation));
-        if (ftruncate(fd, newSize) != 0) 
+        countIo(reservationStorage, recordRead, count);
+        readRecord += count;
+
+        // Keep the records of other sailings at the front of the block
+        int kept = 0;
+        for (int i = 0; i < count; ++i)
         {
-            ::close(fd);
-            throw std::runtime_error("deleteReservation: truncate failed");
+            if (std::strncmp(block[i].sailingID, sailingID, sizeof(block[i].sailingID)) != 0)
+            {
+                block[kept++] = block[i];
+            }
         }
-        ::close(fd);
+
+        // Nothing moves until the first removed record
+        if (kept > 0 && writeRecord + kept != readRecord)
+        {
+            reservationFile.seekp(static_cast<std::streamoff>(writeRecord) * sizeof(Reservation), std::ios::beg);
+            countIo(reservationStorage, fileSeek);
+            reservationFile.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(kept) * sizeof(Reservation));
+            if (!reservationFile)
+            {
+                throw std::runtime_error("deleteSailingReservations: Failed writing " + RESERVATIONFILENAME);
+            }
+            countIo(reservationStorage, recordWritten, kept);
+            shipWrite(reservationStorage, static_cast<long long>(writeRecord) * sizeof(Reservation), block.data(),
+                      static_cast<std::size_t>(kept) * sizeof(Reservation));
+        }
+        writeRecord += kept;
     }
-#endif
 
-    // Reopen file
-    reservationFile.open(RESERVATIONFILENAME,
-                       std::ios::in | std::ios::out | std::ios::binary);
-    if (!reservationFile.is_open()) {
-        throw std::runtime_error("deleteReservation: re-open failed");
+    int removed = total - writeRecord;
+    if (removed > 0)
+    {
+        truncateReservations(writeRecord);
+        rebuildFilterFromFile();
     }
-}
\ No newline at end of file
+    return removed;
+}
@@ -19,6 +19,8 @@
 //================================================================
 
 #pragma once
+#include "asyncIo.hpp"
+#include "mappedFile.hpp"
 #include <iostream>
 #include <string>
 using std::endl; 
@@ -60,6 +62,60 @@ bool getNextReservation(Reservation& r);
 //----------------------------------------------------------------
 void writeReservation(const Reservation& r, bool overWrite);
 
+// Function writeReservations appends count reservations to the
+// reservation file using one write and one flush
+// Throws an exception if it fails
+//----------------------------------------------------------------
+void writeReservations(const Reservation reservations[], int count);
+
+// Function rewriteReservations replaces the whole reservation file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//----------------------------------------------------------------
+void rewriteReservations(const Reservation records[], int count);
+
+// Function markReservationsOnBoard sets onBoard on the count records at
+// recordNumbers, reading and writing back each run of consecutive record
+// numbers with one read and one write, then flushing once
+// Throws an exception if a record number is out of range or the file
+// cannot be read or written
+//----------------------------------------------------------------
+void markReservationsOnBoard(const int recordNumbers[], int count);
+// Function appendReservationsAsync queues count reservation records to be
+// appended through the AsyncIo backend, linked to a data sync if sync is
+// set. done runs from asyncPoll or asyncWait with the records written,
+// or -1 if the write failed.
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void appendReservationsAsync(const Reservation records[], int count, bool sync, RecordCallback done);
+// Function readReservationsAsync queues a read of count reservation records
+// starting at record firstRecord into records, which must stay valid
+// until done runs with the records read, or -1 if the read failed
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void readReservationsAsync(Reservation records[], int firstRecord, int count, RecordCallback done);
+// Function reservationReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void reservationReadahead();
+
+// Function reservationSnapshot maps the reservation file read-only for scans that
+// compare records in place; views of it stay valid while it lives
+// Throws an exception if the file is not open or cannot be read
+//----------------------------------------------------------------
+RecordSnapshot<Reservation> reservationSnapshot();
+
+// Function reservationMayExist returns false if the vehicle is certainly
+// not booked on the sailing, without reading the file; true means the
+// file must be checked
+//----------------------------------------------------------------
+bool reservationMayExist(const char sailingID[], const char vehicleLicence[]);
+
+// Function reservationFilterFalsePositive records that a booking reported
+// by reservationMayExist was not found, for the false-positive rate
+//----------------------------------------------------------------
+void reservationFilterFalsePositive();
+
 
 // Function closes reservation file
 //----------------------------------------------------------------
@@ -68,4 +124,12 @@ void reservationClose();
 // Function deleteReservation deletes a reservation with the provided
 // sailingID and vehicleLicence. Throws an exception if the record is not found.
 //----------------------------------------------------------------
-void deleteReservation(char sailingID[], char vehicleLicence[]);
\ No newline at end of file
+void deleteReservation(char sailingID[], char vehicleLicence[]);
+
+// Function deleteSailingReservations deletes every reservation on the
+// provided sailing in one sequential pass over the file, in constant
+// memory, with one truncate. Lane space is not given back to the sailing.
+// Returns the number of reservations deleted
+// Throws an exception if the file cannot be read, written or truncated
+//----------------------------------------------------------------
+int deleteSailingReservations(const char sailingID[]);
\ No newline at end of file
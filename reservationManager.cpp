@@ -5,6 +5,44 @@
 * Filename: reservationManager.cpp
 *
 * Revision History:
+* Rev. 4 - 26/10/18 Modified by L. Xu
+*        - Split createReservation into prompting and a non-interactive
+*          overload sharing bookVehicle, which updates the sailing in place
+*        - Added a checkIn overload that can run without prompts
+*        - deleteReservations(sailingID) no longer leaves the file closed
+*          when the sailing has no bookings
+*        - Timed public functions in the Stats module
+*        - Traced the file rewrites of createResAtCheckin and
+*          deleteReservations(sailingID)
+*        - Counted bookings, cancellations, check ins and capacity
+*          rejections in the Metrics module
+*        - Added createReservations for booking a batch of vehicles
+*          grouped by sailing
+*        - deleteReservations(sailingID) compacts the reservation file in
+*          place instead of rewriting it record by record
+*        - createResAtCheckin rewrites sailings.dat atomically in one write
+*        - createReservations and createResAtCheckin keep their scratch
+*          containers in the RequestArena
+*        - vehicleCheck, findVehicle, viewReservations and checkIn scan
+*          mapped snapshots instead of copying every record
+*        - Licence and booking lookups ask the Bloom filters first and
+*          skip the scan on a definite miss
+*        - viewReservations and checkIn query the ReservationScan module
+*          instead of comparing fields in their own loops
+*        - checkIn writes the onBoard flag to the reservation file
+*        - Added checkInReservations for checking in a wave of vehicles
+*        - bookVehicle and createReservations refuse vehicle sizes outside
+*          the prompted ranges
+*        - checkIn refuses a reservation that is already checked in
+*        - Bookings and check ins made after prompts hold the DataWriteLock
+*          and a ShippedRequest around their writes only
+*        - checkIn is split into checkInFare and commitCheckIn so onBoard is
+*          written only after the fare is paid; walk-up reservations are
+*          created not yet on board
+*        - vehicleSizeError is public so the AsyncManager module can use it
+*        - bookVehicle and createReservations share takeLaneSpace
+*        - createResAtCheckin matches a registered vehicle by licence and
+*          books it through bookVehicle; no write past the record fields
 * Rev. 3 - 25/08/04 Modified bt A. Kong
 *        - Fixed the Checkin function
 *        - Implemented a helper function createResAtCheckin
@@ -28,23 +66,64 @@
 #include "sailingManager.hpp"
 #include "vessel.hpp"
 #include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include "stats.hpp"
+#include "metrics.hpp"
+#include "requestArena.hpp"
+#include "reservationScan.hpp"
+#include "dataLock.hpp"
+#include "replication.hpp"
 #include <stdexcept>
 #include <cstring>
 #include <cctype>
 #include <cstdio>
 #include <vector>
+#include <map>
+#include <string>
+#include <unordered_map>
 #ifdef _WIN32
   #include <io.h>      
 #else
   #include <unistd.h>  
   #include <fcntl.h>
 #endif
+//================================================================
+// Constants
+//----------------------------------------------------------------
+static const float LOWLANEFARE = 14; // Fare of a vehicle in the low lane
+
+//================================================================
+// Helper function highLaneFare returns the fare of a high lane vehicle
+//----------------------------------------------------------------
+static float highLaneFare(float length, float height)
+{
+    return (length * 2) + (height * 3);
+}
+
+// Function vehicleSizeError checks a vehicle against the ranges the
+// booking prompts accept
+//----------------------------------------------------------------
+std::string vehicleSizeError(const Vehicle& v)
+{
+    // Written so that NaN fails too
+    if (!(v.vehicleLength >= 0.1f && v.vehicleLength <= 99.9f))
+    {
+        return std::string("Vehicle length of ") + v.vehicleLicence + " must be 0.1-99.9 m";
+    }
+    if (!(v.vehicleHeight >= 0.1f && v.vehicleHeight <= 9.9f))
+    {
+        return std::string("Vehicle height of ") + v.vehicleLicence + " must be 0.1-9.9 m";
+    }
+    return std::string();
+}
+
 //================================================================
 // Function accessSailingManagerUpdate accesses the Sailing Manager module
 // to update a sailing
 //----------------------------------------------------------------
 void accessSailingManagerUpdate(char sailingID[])
 {
+    TIME_FUNCTION("accessSailingManagerUpdate");
     try
     {
         // First verify the sailing exists
@@ -71,6 +150,7 @@ void accessSailingManagerUpdate(char sailingID[])
 //----------------------------------------------------------------
 void accessSailingManagerQuery(char sailingID[])
 {
+    TIME_FUNCTION("accessSailingManagerQuery");
     try
     {
         // Verify sailing exists
@@ -100,16 +180,21 @@ void accessSailingManagerQuery(char sailingID[])
 //----------------------------------------------------------------
 void vehicleCheck(char vehicleLicence[])
 {
+    TIME_FUNCTION("vehicleCheck");
     //check if vehicle exists
     bool vehicleExists = false;
-    Vehicle v;
-    //resets vehicle to start of list
-    vehicleReset();
-    //find the vehicle
-    while (getNextVehicle(v)) {
-        if (strcmp(v.vehicleLicence, vehicleLicence) == 0) {
-            vehicleExists = true;
-            break;
+    //find the vehicle, comparing licences in the mapped file, unless the
+    //filter already rules it out
+    if (vehicleMayExist(vehicleLicence)) {
+        RecordSnapshot<Vehicle> vehicles = vehicleSnapshot();
+        for (const Vehicle& v : vehicles.records()) {
+            if (strncmp(v.vehicleLicence, vehicleLicence, sizeof(v.vehicleLicence)) == 0) {
+                vehicleExists = true;
+                break;
+            }
+        }
+        if (!vehicleExists) {
+            vehicleFilterFalsePositive();
         }
     }
     if (!vehicleExists) {
@@ -171,49 +256,114 @@ void vehicleCheck(char vehicleLicence[])
     }
 
 }
+// helper function findVehicle looks up a registered vehicle by licence
+// Returns true and fills in v if the vehicle is registered
+static bool findVehicle(const char vehicleLicence[], Vehicle& v)
+{
+    if (!vehicleMayExist(vehicleLicence))
+    {
+        return false;
+    }
+    // Only the matching record is copied out of the mapped file
+    RecordSnapshot<Vehicle> vehicles = vehicleSnapshot();
+    for (const Vehicle& candidate : vehicles.records())
+    {
+        if (std::strncmp(candidate.vehicleLicence, vehicleLicence, sizeof(candidate.vehicleLicence)) == 0)
+        {
+            v = candidate;
+            return true;
+        }
+    }
+    vehicleFilterFalsePositive();
+    return false;
+}
+
+// helper function takeLaneSpace takes the vehicle's length from the proper
+// lane of the sailing and records the lane used in the reservation
+// Returns false, counting a capacity rejection, if neither lane has space
+//----------------------------------------------------------------
+static bool takeLaneSpace(Sailing& s, const Vehicle& vehicle, Reservation& newRes)
+{
+    bool lowVehicle = (vehicle.vehicleHeight <= 2 && vehicle.vehicleLength <= 7);
+    if (lowVehicle && vehicle.vehicleLength <= s.lowRemainingLength)
+    {
+        s.lowRemainingLength -= vehicle.vehicleLength;
+        newRes.isLRL = true;
+    }
+    // Special vehicles, or low vehicles when the low-roof lane is full
+    else if (vehicle.vehicleLength <= s.highRemainingLength)
+    {
+        s.highRemainingLength -= vehicle.vehicleLength;
+        newRes.isLRL = false;
+    }
+    else
+    {
+        countMetric(capacityRejectionsTotal);
+        return false;
+    }
+    return true;
+}
+
+// helper function bookVehicle takes lane space for the vehicle on the sailing,
+// writes the reservation and registers the vehicle if it is new
+// Throws an exception if the vehicle size is out of range, or the sailing
+// does not exist or is full
+static void bookVehicle(char sailingID[], const Vehicle& vehicle, bool isNewVehicle)
+{
+    std::string sizeError = vehicleSizeError(vehicle);
+    if (!sizeError.empty())
+    {
+        throw std::runtime_error(sizeError);
+    }
+    DataWriteLock request; // Held for the writes only, never over a prompt
+    ShippedRequest shipped;
+    const SailingIndexEntry* entry = sailingIndexFind(sailingID);
+    if (entry == nullptr)
+    {
+        throw std::runtime_error("Sailing ID not found");
+    }
+    Sailing s = entry->sailing;
+
+    // Create new reservation
+    Reservation newRes = {};
+    std::memcpy(newRes.sailingID, sailingID, strnlen(sailingID, sizeof(newRes.sailingID) - 1));
+    std::memcpy(newRes.vehicleLicence, vehicle.vehicleLicence,
+                strnlen(vehicle.vehicleLicence, sizeof(newRes.vehicleLicence) - 1));
+    newRes.onBoard = false;
+
+    if (!takeLaneSpace(s, vehicle, newRes))
+    {
+        throw std::runtime_error("Insufficient space in both low and high roof lanes");
+    }
+
+    updateSailingRecord(s);
+    writeReservation(newRes, false);
+    if (isNewVehicle)
+    {
+        writeVehicle(vehicle);
+    }
+    countMetric(bookingsTotal);
+}
+
 // Function createReservation creates a reservation for the vehicle
 // with the corresponding licence plate on the specified sailing
 //----------------------------------------------------------------
 void createReservation(char sailingID[], char vehicleLicence[]){
+    TIME_FUNCTION("createReservation (prompt)");
     char phoneNumber[15];
     float vehicleLength = 0.0f, vehicleHeight = 0.0f;
     Vehicle v;
-    vehicleReset();
-    bool vehExists = false;
     // Check if the vehicle data already exists
-    while (getNextVehicle(v))
-    {
-        if (std::strncmp(v.vehicleLicence, vehicleLicence, sizeof(v.vehicleLicence)) == 0){
-            //new reservation
-            Reservation newRes;
-            vehicleLength = v.vehicleLength;
-            vehicleHeight = v.vehicleHeight;
-            strncpy(phoneNumber, v.phone, sizeof(phoneNumber) - 1);
-            phoneNumber[sizeof(phoneNumber) - 1] = '\0';
-            strncpy(newRes.sailingID, sailingID, sizeof(newRes.sailingID) - 1);
-            newRes.sailingID[sizeof(newRes.sailingID) - 1] = '\0'; 
-            strncpy(newRes.vehicleLicence, vehicleLicence, sizeof(newRes.vehicleLicence) - 1);
-            newRes.vehicleLicence[sizeof(newRes.vehicleLicence) - 1] = '\0';  
-            newRes.onBoard = false;
-            newRes.isLRL = (v.vehicleHeight <= 2 || v.vehicleLength <= 7);
-            // Add to file
-            writeReservation(newRes, false);
-            cout << "Vehicle verified\n";
-            cout << "Previous Vehicle found\n";
-            cout << "Reservation Complete\n";
-            char input;
-            cout << "Enter Y to add another vehicle, enter N to return to the main menu\n";
-            std::cin >> input;
-            createReservationRepeat(input);
-            vehExists = true;  
-        }
+    bool vehExists = findVehicle(vehicleLicence, v);
+    cout << "Vehicle verified\n";
+    if (vehExists)
+    {
+        cout << "Previous Vehicle found\n";
     }
     // Create a vehicle if not existing
-    if (!vehExists)
+    else
     {
-        cout << "Vehicle verified\n";
-
-        Vehicle temp;
+        Vehicle temp = {};
         strncpy(temp.vehicleLicence, vehicleLicence, sizeof(temp.vehicleLicence) - 1);
         temp.vehicleLicence[sizeof(temp.vehicleLicence) - 1] = '\0';
         while(true)
@@ -230,8 +380,7 @@ void createReservation(char sailingID[], char vehicleLicence[]){
                 break;
             }
         }
-        strncpy(temp.phone, phoneNumber, sizeof(temp.phone) - 1);
-        temp.phone[sizeof(temp.phone) - 1] = '\0';
+        std::memcpy(temp.phone, phoneNumber, strnlen(phoneNumber, sizeof(temp.phone) - 1));
         cout << "Customer verified\n";
         // Get vehicle data
         while(true)
@@ -266,99 +415,149 @@ void createReservation(char sailingID[], char vehicleLicence[]){
         }
         temp.vehicleHeight = vehicleHeight;
         cout << "Valid height\n";  
-        
-        writeVehicle(temp);
+        v = temp;
     }
-    sailingReset(); // Start from beginning of sailing file
-    Sailing s;
-    bool sailingFound = false;
-    std::vector<Sailing> sailings;
-
-    // Create new reservation 
-    Reservation newRes;
-    std::strncpy(newRes.sailingID, sailingID, sizeof(newRes.sailingID) - 1);
-    newRes.sailingID[sizeof(newRes.sailingID) - 1] = '\0'; 
-    std::strncpy(newRes.vehicleLicence, vehicleLicence, sizeof(newRes.vehicleLicence) - 1);
-    newRes.vehicleLicence[sizeof(newRes.vehicleLicence) - 1] = '\0';  
-    newRes.onBoard = false;
-    newRes.isLRL = (vehicleHeight <= 2 && vehicleLength <= 7);
-    
-    // Read all sailings into memory
-    while (getNextSailing(s)) {
-        if (strncmp(s.sailingID, sailingID, sizeof(s.sailingID)) == 0) {
-            sailingFound = true;
-            // Insert reservation into proper lane
-            if (newRes.isLRL)
+
+    bookVehicle(sailingID, v, !vehExists);
+    cout << "Reservation Complete\n";
+    char input;
+    cout << "Enter Y to add another vehicle, enter N to return to the main menu\n";
+    std::cin >> input;
+    createReservationRepeat(input);
+
+}
+// Function createReservation with a Vehicle creates a reservation without
+// prompting. A registered vehicle keeps its registered details, otherwise
+// the given vehicle is registered.
+//----------------------------------------------------------------
+void createReservation(char sailingID[], const Vehicle& vehicle)
+{
+    TIME_FUNCTION("createReservation");
+    Vehicle registered;
+    if (findVehicle(vehicle.vehicleLicence, registered))
+    {
+        bookVehicle(sailingID, registered, false);
+    }
+    else
+    {
+        bookVehicle(sailingID, vehicle, true);
+    }
+}
+// Function createReservations books a batch of vehicles grouped by sailing,
+// each group all or nothing, with one write per file
+//----------------------------------------------------------------
+int createReservations(ReservationRequest requests[], int count)
+{
+    TIME_FUNCTION("createReservations");
+    RequestArena scratch;
+
+    // Group the requests by sailing, keeping request order in each group
+    std::pmr::map<std::pmr::string, std::pmr::vector<int> > groups(scratch.resource());
+    std::pmr::unordered_map<std::pmr::string, Vehicle> vehicles(scratch.resource());
+    for (int i = 0; i < count; ++i)
+    {
+        requests[i].booked = false;
+        requests[i].error.clear();
+        groups[std::pmr::string(requests[i].sailingID, strnlen(requests[i].sailingID, sizeof(requests[i].sailingID)),
+                                scratch.resource())].push_back(i);
+        const Vehicle& v = requests[i].vehicle;
+        vehicles.emplace(std::pmr::string(v.vehicleLicence, strnlen(v.vehicleLicence, sizeof(v.vehicleLicence)),
+                                          scratch.resource()), v);
+    }
+
+    // One pass over the registry; vehicles left in unregistered are new
+    std::pmr::unordered_map<std::pmr::string, Vehicle> unregistered(vehicles, scratch.resource());
+    Vehicle v;
+    vehicleReset();
+    while (!unregistered.empty() && getNextVehicle(v))
+    {
+        std::pmr::string licence(v.vehicleLicence, strnlen(v.vehicleLicence, sizeof(v.vehicleLicence)), scratch.resource());
+        std::pmr::unordered_map<std::pmr::string, Vehicle>::iterator found = vehicles.find(licence);
+        if (found != vehicles.end() && unregistered.erase(licence) > 0)
+        {
+            found->second = v;
+        }
+    }
+
+    std::pmr::vector<Reservation> reservations(scratch.resource());
+    std::pmr::vector<Sailing> sailings(scratch.resource());
+    std::pmr::vector<Vehicle> newVehicles(scratch.resource());
+    for (const std::pair<const std::pmr::string, std::pmr::vector<int> >& group : groups)
+    {
+        const SailingIndexEntry* entry = sailingIndexFind(group.first.c_str());
+        std::string error;
+        std::size_t groupStart = reservations.size();
+        if (entry == nullptr)
+        {
+            error = "Sailing ID not found";
+        }
+        else
+        {
+            // Take lane space on a copy of the sailing, as bookVehicle does
+            Sailing s = entry->sailing;
+            for (int i : group.second)
             {
-                // Check if vehicle fits in low-roof lane
-                if (vehicleLength <= s.lowRemainingLength) 
-                {
-                    s.lowRemainingLength -= vehicleLength;
-                } 
-                // Check if vehicle fits in high-roof lane in case low-lane has no space
-                else if (vehicleLength <= s.highRemainingLength) 
+                const char* licence = requests[i].vehicle.vehicleLicence;
+                const Vehicle& vehicle = vehicles[std::pmr::string(licence, strnlen(licence, sizeof(Vehicle::vehicleLicence)),
+                                                                   scratch.resource())];
+                error = vehicleSizeError(vehicle);
+                if (!error.empty())
                 {
-                    s.highRemainingLength -= vehicleLength;
+                    break;
                 }
-                else 
+                Reservation newRes = {};
+                std::memcpy(newRes.sailingID, s.sailingID, strnlen(s.sailingID, sizeof(newRes.sailingID) - 1));
+                std::memcpy(newRes.vehicleLicence, vehicle.vehicleLicence,
+                            strnlen(vehicle.vehicleLicence, sizeof(newRes.vehicleLicence) - 1));
+                newRes.onBoard = false;
+                if (!takeLaneSpace(s, vehicle, newRes))
                 {
-                    throw std::runtime_error("Insufficient space in both low and high roof lanes");
+                    error = std::string("Insufficient space in both low and high roof lanes for ") + vehicle.vehicleLicence;
+                    break;
                 }
+                reservations.push_back(newRes);
             }
-            // Check for availability for special vehicles
-            else
+            if (error.empty())
             {
-                if (vehicleLength <= s.highRemainingLength)
-                {
-                    s.highRemainingLength -= vehicleLength;
-                }
-                else 
-                {
-                    throw std::runtime_error("Insufficient space in both low and high roof lanes");
-                }
+                sailings.push_back(s);
             }
         }
-        sailings.push_back(s);
-    }
-
-    if (!sailingFound) {
-        throw std::runtime_error("Sailing ID not found");
-    }
+        if (!error.empty())
+        {
+            // Refuse the whole group
+            reservations.resize(groupStart);
+            for (int i : group.second)
+            {
+                requests[i].error = error;
+            }
+            continue;
+        }
 
-    // Rewrite all sailings with updated values
-    sailingClose();
-    std::remove("sailings.dat");
-    sailingOpen();
-    
-    for (auto& updatedSailing : sailings) {
-        writeSailing(updatedSailing);
-    }
-    if (vehExists)
-    {
-        return;
+        // New vehicles are registered with their first booking
+        for (int i : group.second)
+        {
+            requests[i].booked = true;
+            const char* licence = requests[i].vehicle.vehicleLicence;
+            std::pmr::unordered_map<std::pmr::string, Vehicle>::iterator fresh = unregistered.find(
+                std::pmr::string(licence, strnlen(licence, sizeof(Vehicle::vehicleLicence)), scratch.resource()));
+            if (fresh != unregistered.end())
+            {
+                newVehicles.push_back(fresh->second);
+                unregistered.erase(fresh);
+            }
+        }
     }
-    
-    //Create new vehicle
-    Vehicle newVeh;
-    strncpy(newVeh.vehicleLicence, vehicleLicence, sizeof(newVeh.vehicleLicence) - 1);
-    newVeh.vehicleLicence[sizeof(newVeh.vehicleLicence) - 1] = '\0';
-    strncpy(newVeh.phone, phoneNumber, sizeof(newVeh.phone) - 1);
-    newVeh.phone[sizeof(newVeh.phone) - 1] = '\0';
-    newVeh.vehicleLength = vehicleLength;
-    newVeh.vehicleHeight = vehicleHeight;
-    //write vehicle
-    writeReservation(newRes, false);
-    writeVehicle(v);
-    cout << "Reservation Complete\n";
-    char input;
-    cout << "Enter Y to add another vehicle, enter N to return to the main menu\n";
-    std::cin >> input;
-    createReservationRepeat(input);
 
+    writeVehicles(newVehicles.data(), static_cast<int>(newVehicles.size()));
+    writeReservations(reservations.data(), static_cast<int>(reservations.size()));
+    updateSailingRecords(sailings.data(), static_cast<int>(sailings.size()));
+    countMetric(bookingsTotal, static_cast<long long>(reservations.size()));
+    return static_cast<int>(reservations.size());
 }
 //helper function for repeating createReservation
 void createReservationRepeat(char input)
 {
+    TIME_FUNCTION("createReservationRepeat");
     char sailingID[10];
     char vehicleLicence[11];
 
@@ -461,25 +660,20 @@ void createReservationRepeat(char input)
 // assuming that the vehicle doesn't yet have a reservation at the time of checkin
 void createResAtCheckin(char sailingID[], char vehicleLicence[])
 {
+    TIME_FUNCTION("createResAtCheckin");
     char phoneNumber[14];
     float vehicleLength = 0.0f, vehicleHeight = 0.0f;
     Vehicle v;
     vehicleReset();
 
-    while(getNextVehicle(v))
+    // No scan is needed when the filter rules the vehicle out
+    bool mayBeRegistered = vehicleMayExist(vehicleLicence);
+    while(mayBeRegistered && getNextVehicle(v))
     {
-        if(v.vehicleLicence == vehicleLicence)
+        if(strncmp(v.vehicleLicence, vehicleLicence, sizeof(v.vehicleLicence)) == 0)
         {
-            //new reservation
-            Reservation newRes;
-            strncpy(newRes.sailingID, sailingID, sizeof(newRes.sailingID) - 1);
-            newRes.sailingID[sizeof(newRes.sailingID) - 1] = '\0'; 
-            strncpy(newRes.vehicleLicence, vehicleLicence, sizeof(newRes.vehicleLicence) - 1);
-            newRes.vehicleLicence[sizeof(newRes.vehicleLicence) - 1] = '\0';  
-            newRes.onBoard = false;
-            newRes.isLRL = (vehicleHeight <= 2 && vehicleLength <= 7);
-            // Add to file
-            writeReservation(newRes, false);
+            // Book with the registered size, taking lane space
+            bookVehicle(sailingID, v, false);
             cout << "Vehicle verified\n";
             cout << "Previous Vehicle found\n";
             cout << "Reservation Complete\n";
@@ -533,10 +727,15 @@ void createResAtCheckin(char sailingID[], char vehicleLicence[])
     }
     cout << "Valid height\n";  
 
+    // Prompts are done; the rest is one request
+    DataWriteLock request;
+    ShippedRequest shipped;
     sailingReset(); // Start from beginning of sailing file
     Sailing s;
     bool sailingFound = false;
-    std::vector<Sailing> sailings;
+    RequestArena scratch;
+    std::pmr::vector<Sailing> sailings(scratch.resource());
+    sailings.reserve(sailingIndexSize());
 
     // Read all sailings into memory
     while (getNextSailing(s)) 
@@ -557,6 +756,7 @@ void createResAtCheckin(char sailingID[], char vehicleLicence[])
             }
             else 
             {
+                countMetric(capacityRejectionsTotal);
                 throw std::runtime_error("Insufficient space in both low and high roof lanes");
             }
         }
@@ -564,24 +764,20 @@ void createResAtCheckin(char sailingID[], char vehicleLicence[])
     }
 
     // Rewrite all sailings with updated values
-    sailingClose();
-    std::remove("sailings.dat");
-    sailingOpen();
-    
-    for (auto& updatedSailing : sailings) 
     {
-        writeSailing(updatedSailing);
+        TRACE_SPAN("rewrite sailings.dat");
+        rewriteSailings(sailings.data(), static_cast<int>(sailings.size()));
     }
     Reservation newRes = {};  // Zero-initialize ALL fields
 
     // Safe string copying with explicit null termination
-    strncpy(newRes.sailingID, sailingID, 9);
-    newRes.sailingID[10] = '\0';  // Force null terminator
+    strncpy(newRes.sailingID, sailingID, sizeof(newRes.sailingID) - 1);
+    newRes.sailingID[sizeof(newRes.sailingID) - 1] = '\0';  // Force null terminator
 
-    strncpy(newRes.vehicleLicence, vehicleLicence, 10);
-    newRes.vehicleLicence[11] = '\0';
+    strncpy(newRes.vehicleLicence, vehicleLicence, sizeof(newRes.vehicleLicence) - 1);
+    newRes.vehicleLicence[sizeof(newRes.vehicleLicence) - 1] = '\0';
 
-    newRes.onBoard = true;
+    newRes.onBoard = false; // Set by commitCheckIn once the fare is paid
     newRes.isLRL = (vehicleHeight <= 2 && vehicleLength <= 7);
 
     // Create new vehicle
@@ -595,6 +791,7 @@ void createResAtCheckin(char sailingID[], char vehicleLicence[])
     //write vehicle
     writeReservation(newRes, false);
     writeVehicle(newVeh);
+    countMetric(bookingsTotal);
     cout << "Reservation Complete\n";
 }
 // Function deleteReservations with parameters sailingID, vehicleLicence
@@ -603,8 +800,10 @@ void createResAtCheckin(char sailingID[], char vehicleLicence[])
 //----------------------------------------------------------------
 void deleteReservations(char sailingID[], char vehicleLicence[])
 {
+    TIME_FUNCTION("deleteReservations");
     
     deleteReservation(sailingID, vehicleLicence);
+    countMetric(cancellationsTotal);
 
 }
 // Function deleteReservations with single parameter sailingID
@@ -612,102 +811,87 @@ void deleteReservations(char sailingID[], char vehicleLicence[])
 //----------------------------------------------------------------
 void deleteReservations(char sailingID[])
 {
-    
-    std::vector<Reservation> all;
-    reservationReset();
-    Reservation r;
-    
-    // Read all reservations
-    while (getNextReservation(r))
-    {
-        all.push_back(r);
-    }
-    reservationClose();
-
-    bool found = false;
-    std::vector<Reservation> remaining;  // Will store reservations to keep
-    
-    // Filter out reservations to delete
-    for (auto& rec : all)
-    {
-        if (std::strcmp(rec.sailingID, sailingID) == 0)
-        {
-            found = true;  // Mark that we found at least one matching reservation
-        } 
-        else
-        {
-            remaining.push_back(rec);  // Keep reservations that don't match
-        }
-    }
-
-    if (!found)
-    {
-        return;
-    }
-    
-    // Recreate the file with only non-matching reservations
-    std::remove("reservations.dat");
-    reservationOpen();
-    for (auto& rec : remaining)
-    {
-        writeReservation(rec, true);
-    }
-    
+    TIME_FUNCTION("deleteReservations(sailingID)");
+    int removed = deleteSailingReservations(sailingID);
+    countMetric(cancellationsTotal, removed);
 }
 // Function viewReservations with single parameter sailingID
 // Find the number of reservations with the sailing ID
 //----------------------------------------------------------------
-int viewReservations(char sailingID[]) 
+int viewReservations(const char sailingID[]) 
 {
-
-    reservationReset();
-    Reservation r;
-    int count = 0;
-    // Find all reservations with the sailing ID
-    while (getNextReservation(r)) 
-    {
-        if (strncmp(r.sailingID, sailingID, sizeof(r.sailingID)) == 0) 
-        {
-            count++;
-        }
-    }
-
-    return count;
+    TIME_FUNCTION("viewReservations");
+    return countReservations(sailingQuery(sailingID));
 }
 // Function checkIn() sets the status of specified reservation as checked in
 //----------------------------------------------------------------
 float checkIn(char sailingID[], char vehicleLicence[])
 {
+    return checkIn(sailingID, vehicleLicence, true);
+}
+// Function checkIn with promptForSize checks in the specified reservation.
+// If promptForSize is true, a missing reservation is created at check in and
+// special vehicles are measured by the user; otherwise the registered vehicle
+// size is used and a missing reservation is an error.
+//----------------------------------------------------------------
+float checkIn(char sailingID[], char vehicleLicence[], bool promptForSize)
+{
+    TIME_FUNCTION("checkIn");
+    int recordNumber = -1;
+    float fare = checkInFare(sailingID, vehicleLicence, promptForSize, recordNumber);
+    commitCheckIn(recordNumber);
+    return fare;
+}
+// Function checkInFare finds the reservation to check in and works out its
+// fare without setting onBoard, creating a walk-up reservation and
+// measuring special vehicles if promptForSize is true
+//----------------------------------------------------------------
+float checkInFare(char sailingID[], char vehicleLicence[], bool promptForSize, int& recordNumber)
+{
+    TIME_FUNCTION("checkInFare");
     float fare = 0;
-    //loops through the file, if it matches, return true, else it will automatically be false
-    Reservation r;
-    reservationReset();
-    while (getNextReservation(r))
+    Reservation r = {};
+    recordNumber = -1;
+    bool found = false;
+    if (reservationMayExist(sailingID, vehicleLicence))
     {
-        if (strcmp(r.sailingID, sailingID) == 0 && strcmp(r.vehicleLicence, vehicleLicence) == 0)
+        found = findReservation(bookingQuery(sailingID, vehicleLicence), r, &recordNumber);
+        if (!found)
         {
-            r.onBoard = true;
-            break;
+            reservationFilterFalsePositive();
         }
     }
     // create a reservation for customer if a reservation does not exist
-    if (!getNextReservation(r))
+    if (!found)
     {
+        if (!promptForSize)
+        {
+            throw std::runtime_error("Reservation not found for check in.");
+        }
         createResAtCheckin(sailingID,vehicleLicence);
-    }
-    reservationReset();
-    while (getNextReservation(r))
-    {
-        if (strcmp(r.sailingID, sailingID) == 0 && strcmp(r.vehicleLicence, vehicleLicence) == 0)
+        if (!findReservation(bookingQuery(sailingID, vehicleLicence), r, &recordNumber))
         {
-            r.onBoard = true;
-            break;
+            throw std::runtime_error("Reservation not found for check in.");
         }
-
-    } 
+    }
+    else if (r.onBoard)
+    {
+        throw std::runtime_error("Already checked in");
+    }
     if(r.isLRL == true)
     {
-        fare = 14;
+        fare = LOWLANEFARE;
+        return fare;
+    }
+    else if (!promptForSize)
+    {
+        // Use the registered vehicle size
+        Vehicle v;
+        if (!findVehicle(vehicleLicence, v))
+        {
+            throw std::runtime_error("Vehicle not found for check in.");
+        }
+        fare = highLaneFare(v.vehicleLength, v.vehicleHeight);
         return fare;
     }
     else
@@ -732,9 +916,119 @@ float checkIn(char sailingID[], char vehicleLicence[])
         }
         
         // Calculate fare
-        fare = (length * 2) + (height * 3);
+        fare = highLaneFare(length, height);
         return fare;
     }
-    throw std::runtime_error("Reservation not found for check in.");
-    return 0; //unreachable
+}
+// Function commitCheckIn sets onBoard on the reservation at recordNumber
+//----------------------------------------------------------------
+void commitCheckIn(int recordNumber)
+{
+    TIME_FUNCTION("commitCheckIn");
+    DataWriteLock request;
+    ShippedRequest shipped;
+    markReservationsOnBoard(&recordNumber, 1);
+    countMetric(checkInsTotal);
+}
+// Function checkInReservations checks in a boarding wave with one scan
+// of the reservations, one pass over the vehicle registry for the high
+// lane sizes and one write of the boarded flags
+//----------------------------------------------------------------
+int checkInReservations(const char sailingID[], CheckInRequest requests[], int count)
+{
+    TIME_FUNCTION("checkInReservations");
+    RequestArena scratch;
+
+    // The sailing's bookings by plate, with their record numbers
+    std::pmr::unordered_map<std::pmr::string, std::pair<int, Reservation> > bookings(scratch.resource());
+    {
+        RecordSnapshot<Reservation> reservations = reservationSnapshot();
+        RecordView<Reservation> records = reservations.records();
+        for (std::size_t position : ReservationScan(sailingQuery(sailingID)).collect(records))
+        {
+            const Reservation& r = records[position];
+            bookings.emplace(std::pmr::string(r.vehicleLicence, strnlen(r.vehicleLicence, sizeof(r.vehicleLicence)),
+                                              scratch.resource()),
+                             std::make_pair(static_cast<int>(position), r));
+        }
+    }
+
+    // Resolve each plate; high lane vehicles pay by their registered size
+    std::pmr::vector<std::pair<int, Reservation>*> resolved(static_cast<std::size_t>(count), nullptr, scratch.resource());
+    std::pmr::unordered_map<std::pmr::string, Vehicle> highLane(scratch.resource());
+    for (int i = 0; i < count; ++i)
+    {
+        requests[i].checkedIn = false;
+        requests[i].fare = 0;
+        requests[i].error.clear();
+        std::pmr::string plate(requests[i].vehicleLicence,
+                               strnlen(requests[i].vehicleLicence, sizeof(requests[i].vehicleLicence)), scratch.resource());
+        std::pmr::unordered_map<std::pmr::string, std::pair<int, Reservation> >::iterator found = bookings.find(plate);
+        if (found == bookings.end())
+        {
+            requests[i].error = "No reservation on this sailing";
+            continue;
+        }
+        resolved[i] = &found->second;
+        if (!found->second.second.isLRL)
+        {
+            highLane.emplace(plate, Vehicle());
+        }
+    }
+    std::size_t sizesWanted = highLane.size();
+    if (sizesWanted > 0)
+    {
+        RecordSnapshot<Vehicle> vehicles = vehicleSnapshot();
+        for (const Vehicle& v : vehicles.records())
+        {
+            std::pmr::unordered_map<std::pmr::string, Vehicle>::iterator wanted = highLane.find(
+                std::pmr::string(v.vehicleLicence, strnlen(v.vehicleLicence, sizeof(v.vehicleLicence)), scratch.resource()));
+            if (wanted != highLane.end() && wanted->second.vehicleLicence[0] == '\0')
+            {
+                wanted->second = v;
+                if (--sizesWanted == 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Fares in queue order; a plate read twice boards once
+    std::pmr::vector<int> boarded(scratch.resource());
+    for (int i = 0; i < count; ++i)
+    {
+        if (resolved[i] == nullptr)
+        {
+            continue;
+        }
+        Reservation& r = resolved[i]->second;
+        if (r.onBoard)
+        {
+            requests[i].error = "Already checked in";
+            continue;
+        }
+        if (r.isLRL)
+        {
+            requests[i].fare = LOWLANEFARE;
+        }
+        else
+        {
+            const Vehicle& v = highLane[std::pmr::string(r.vehicleLicence, strnlen(r.vehicleLicence, sizeof(r.vehicleLicence)),
+                                                         scratch.resource())];
+            if (v.vehicleLicence[0] == '\0')
+            {
+                requests[i].error = "Vehicle not registered";
+                continue;
+            }
+            requests[i].fare = highLaneFare(v.vehicleLength, v.vehicleHeight);
+        }
+        r.onBoard = true;
+        requests[i].checkedIn = true;
+        boarded.push_back(resolved[i]->first);
+    }
+
+    markReservationsOnBoard(boarded.data(), static_cast<int>(boarded.size()));
+    countMetric(checkInsTotal, static_cast<long long>(boarded.size()));
+    return static_cast<int>(boarded.size());
 }
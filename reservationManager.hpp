@@ -14,10 +14,33 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include "vehicle.hpp"
 using std::endl;
 using std::cout;
 using std::string;
 //================================================================
+// Struct: ReservationRequest
+// Purpose: One booking of a batch passed to createReservations
+//----------------------------------------------------------------
+struct ReservationRequest
+{
+    char sailingID[10]; // Sailing to book on
+    Vehicle vehicle; // Registered vehicles keep their registered details
+    bool booked; // Set by createReservations if the reservation was made
+    string error; // Set by createReservations if the group was refused
+};
+
+// Struct: CheckInRequest
+// Purpose: One vehicle of a boarding wave passed to checkInReservations
+//----------------------------------------------------------------
+struct CheckInRequest
+{
+    char vehicleLicence[11]; // Plate read at the lane
+    bool checkedIn; // Set by checkInReservations if the vehicle boarded
+    float fare; // Set by checkInReservations to the fare to collect
+    string error; // Set by checkInReservations if the vehicle was refused
+};
+//================================================================
 // Function accessSailingManagerUpdate accesses the Sailing Manager module
 // to update a sailing
 //----------------------------------------------------------------
@@ -30,10 +53,30 @@ void accessSailingManagerQuery(char sailingID[]);
 // If vehicle does not exist in the system, create a record for vehicle.
 //----------------------------------------------------------------
 void vehicleCheck(char vehicleLicence[]);
+// Function vehicleSizeError checks a vehicle against the ranges the
+// booking prompts accept
+// Returns the reason it is refused, or an empty string if it is valid
+//----------------------------------------------------------------
+string vehicleSizeError(const Vehicle& v);
 // Function createReservation creates a reservation for the vehicle
 // with the corresponding licence plate on the specified sailing
 //----------------------------------------------------------------
 void createReservation(char sailingID[], char vehicleLicence[]);
+// Function createReservation with a Vehicle creates a reservation without
+// prompting. A registered vehicle keeps its registered details, otherwise
+// the given vehicle is registered.
+// Throws an exception if the sailing does not exist or has no space
+//----------------------------------------------------------------
+void createReservation(char sailingID[], const Vehicle& vehicle);
+// Function createReservations books a batch of vehicles without prompting.
+// Requests are grouped by sailing and each group is all or nothing: if
+// the sailing does not exist or any vehicle of the group does not fit, no
+// vehicle of the group is booked and every request of the group gets the
+// error. New vehicles, reservations and sailing updates are written in one
+// batch per file.
+// Returns the number of reservations made
+//----------------------------------------------------------------
+int createReservations(ReservationRequest requests[], int count);
 // Function deleteReservations with parameters sailingID, vehicleLicence
 // deletes a reservation on the specified sailing
 // for the vehicle with the corresponding licence plate
@@ -45,7 +88,33 @@ void deleteReservations(char sailingID[], char vehicleLicence[]);
 //----------------------------------------------------------------
 void deleteReservations(char sailingID[]);
 // Function viewReservations returns the number of reservations for a sailing
-int viewReservations(char sailingID[]);
+int viewReservations(const char sailingID[]);
 // Function checkIn() sets the status of specified reservation as checked in
 //----------------------------------------------------------------
-float checkIn(char sailingID[], char vehicleLicence[]);
\ No newline at end of file
+float checkIn(char sailingID[], char vehicleLicence[]);
+// Function checkInReservations checks in a wave of vehicles on one sailing
+// without prompting. The sailing's reservations are loaded once and each
+// plate is found by hash; the fare uses the registered vehicle size. A
+// vehicle with no reservation, already on board or not registered is
+// refused with an error. The boarded flags are written in one write.
+// Returns the number of vehicles checked in
+//----------------------------------------------------------------
+int checkInReservations(const char sailingID[], CheckInRequest requests[], int count);
+// Function checkIn with promptForSize checks in the specified reservation.
+// If promptForSize is false, the registered vehicle size is used for the
+// fare and an exception is thrown if the reservation does not exist.
+// Throws an exception if the reservation is already checked in.
+//----------------------------------------------------------------
+float checkIn(char sailingID[], char vehicleLicence[], bool promptForSize);
+// Function checkInFare finds the reservation to check in and returns its
+// fare like checkIn, with its record number in recordNumber, but does not
+// set onBoard. If promptForSize is true, a missing reservation is created
+// (not on board) and special vehicles are measured by the user.
+// Throws an exception if the reservation is missing or already checked in.
+//----------------------------------------------------------------
+float checkInFare(char sailingID[], char vehicleLicence[], bool promptForSize, int& recordNumber);
+// Function commitCheckIn sets onBoard on the reservation at recordNumber,
+// found by checkInFare, once the fare has been paid
+// Throws an exception if the reservation file cannot be written
+//----------------------------------------------------------------
+void commitCheckIn(int recordNumber);
\ No newline at end of file
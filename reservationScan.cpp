@@ -0,0 +1,279 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: reservationScan.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the ReservationScan module of the
+ *              Ferry Reservation System. The mask and expected bytes are
+ *              loaded into registers once per scan by RecordTest, whose
+ *              test is the whole inner loop.
+ *
+ * Design Issues: The SSE2 path is chosen at compile time (__SSE2__, or
+ *                _M_X64 and _M_IX86_FP on MSVC); the portable path gives
+ *                the same answers
+ */
+//================================================================
+#include "reservationScan.hpp"
+#include "stats.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define RESERVATIONSCAN_SSE2 1
+#endif
+
+static_assert(sizeof(Reservation) == 23, "ReservationScan compares 23 byte records");
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const std::size_t HIGHHALF = sizeof(Reservation) - 16; // Start of the second 16 byte compare
+
+//================================================================
+// Class: RecordTest
+// Purpose: The compiled mask held in registers for one scan
+//----------------------------------------------------------------
+#ifdef RESERVATIONSCAN_SSE2
+class RecordTest
+{
+public:
+    RecordTest(const unsigned char mask[], const unsigned char wanted[])
+        : maskLow(load(mask)), wantedLow(load(wanted)),
+          maskHigh(load(mask + HIGHHALF)), wantedHigh(load(wanted + HIGHHALF)) {}
+
+    // Function test returns true if the masked bytes of record are wanted
+    bool test(const unsigned char* record) const
+    {
+        __m128i low = _mm_and_si128(load(record), maskLow);
+        __m128i high = _mm_and_si128(load(record + HIGHHALF), maskHigh);
+        __m128i same = _mm_and_si128(_mm_cmpeq_epi8(low, wantedLow), _mm_cmpeq_epi8(high, wantedHigh));
+        return _mm_movemask_epi8(same) == 0xFFFF;
+    }
+
+private:
+    static __m128i load(const unsigned char* bytes)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    }
+
+    __m128i maskLow, wantedLow; // Bytes 0 to 15
+    __m128i maskHigh, wantedHigh; // Bytes 7 to 22
+};
+#else
+class RecordTest
+{
+public:
+    RecordTest(const unsigned char mask[], const unsigned char wanted[])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            masks[i] = load(mask + OFFSETS[i]);
+            wants[i] = load(wanted + OFFSETS[i]);
+        }
+    }
+
+    // Function test returns true if the masked bytes of record are wanted
+    bool test(const unsigned char* record) const
+    {
+        return ((load(record) & masks[0]) ^ wants[0]) == 0 &&
+               ((load(record + OFFSETS[1]) & masks[1]) ^ wants[1]) == 0 &&
+               ((load(record + OFFSETS[2]) & masks[2]) ^ wants[2]) == 0;
+    }
+
+private:
+    static std::uint64_t load(const unsigned char* bytes)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    static constexpr std::size_t OFFSETS[3] = {0, 8, sizeof(Reservation) - 8};
+    std::uint64_t masks[3];
+    std::uint64_t wants[3];
+};
+constexpr std::size_t RecordTest::OFFSETS[3];
+#endif
+
+//================================================================
+// Helper function compileText adds the condition that the field at
+// offset holds text, including its terminator if the text is shorter
+// Throws an exception if the text does not fit the field
+//----------------------------------------------------------------
+static void compileText(unsigned char mask[], unsigned char wanted[], std::size_t offset,
+                        std::size_t fieldSize, const char text[], const char fieldName[])
+{
+    if (text == nullptr || text[0] == '\0')
+    {
+        return;
+    }
+    std::size_t length = std::strlen(text);
+    if (length > fieldSize)
+    {
+        throw std::runtime_error(std::string("ReservationScan: ") + fieldName + " '" + text + "' is too long");
+    }
+    std::size_t compared = length < fieldSize ? length + 1 : fieldSize;
+    std::memset(mask + offset, 0xFF, compared);
+    std::memcpy(wanted + offset, text, length);
+}
+
+// Helper function compileFlag adds the condition on the bool at offset
+//----------------------------------------------------------------
+static void compileFlag(unsigned char mask[], unsigned char wanted[], std::size_t offset, FlagMatch match)
+{
+    if (match != anyFlag)
+    {
+        mask[offset] = 0xFF;
+        wanted[offset] = match == flagSet ? 1 : 0;
+    }
+}
+
+//================================================================
+// Function bookingQuery returns the query of one vehicle's booking
+//----------------------------------------------------------------
+ReservationQuery bookingQuery(const char sailingID[], const char vehicleLicence[])
+{
+    ReservationQuery query = {sailingID, vehicleLicence, anyFlag, anyFlag};
+    return query;
+}
+
+// Function sailingQuery returns the query of every booking on a sailing
+//----------------------------------------------------------------
+ReservationQuery sailingQuery(const char sailingID[])
+{
+    ReservationQuery query = {sailingID, nullptr, anyFlag, anyFlag};
+    return query;
+}
+
+//================================================================
+// Constructor compiles the query into the mask and wanted bytes
+//----------------------------------------------------------------
+ReservationScan::ReservationScan(const ReservationQuery& query)
+{
+    std::memset(mask, 0, sizeof(mask));
+    std::memset(wanted, 0, sizeof(wanted));
+    compileText(mask, wanted, offsetof(Reservation, sailingID), sizeof(Reservation::sailingID),
+                query.sailingID, "sailing ID");
+    compileText(mask, wanted, offsetof(Reservation, vehicleLicence), sizeof(Reservation::vehicleLicence),
+                query.vehicleLicence, "licence");
+    compileFlag(mask, wanted, offsetof(Reservation, onBoard), query.onBoard);
+    compileFlag(mask, wanted, offsetof(Reservation, isLRL), query.isLRL);
+}
+
+// Function matches tests one record
+//----------------------------------------------------------------
+bool ReservationScan::matches(const Reservation& r) const
+{
+    return RecordTest(mask, wanted).test(reinterpret_cast<const unsigned char*>(&r));
+}
+
+// Function count adds up the matches without branching on them
+//----------------------------------------------------------------
+std::size_t ReservationScan::count(RecordView<Reservation> records) const
+{
+    RecordTest test(mask, wanted);
+    const unsigned char* record = reinterpret_cast<const unsigned char*>(records.data());
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < records.size(); ++i, record += sizeof(Reservation))
+    {
+        matched += test.test(record) ? 1 : 0;
+    }
+    return matched;
+}
+
+// Function find stops at the first match at or after first
+//----------------------------------------------------------------
+std::size_t ReservationScan::find(RecordView<Reservation> records, std::size_t first) const
+{
+    RecordTest test(mask, wanted);
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(records.data());
+    for (std::size_t i = first; i < records.size(); ++i)
+    {
+        if (test.test(base + i * sizeof(Reservation)))
+        {
+            return i;
+        }
+    }
+    return records.size();
+}
+
+// Function collect gathers the positions of the matches
+//----------------------------------------------------------------
+std::vector<std::size_t> ReservationScan::collect(RecordView<Reservation> records) const
+{
+    RecordTest test(mask, wanted);
+    const unsigned char* record = reinterpret_cast<const unsigned char*>(records.data());
+    std::vector<std::size_t> positions;
+    for (std::size_t i = 0; i < records.size(); ++i, record += sizeof(Reservation))
+    {
+        if (test.test(record))
+        {
+            positions.push_back(i);
+        }
+    }
+    return positions;
+}
+
+//================================================================
+// Function countReservations scans a snapshot of the reservation file
+//----------------------------------------------------------------
+int countReservations(const ReservationQuery& query)
+{
+    TIME_FUNCTION("countReservations");
+    ReservationScan scan(query);
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    return static_cast<int>(scan.count(reservations.records()));
+}
+
+// Function reservationExists stops the scan at the first match
+//----------------------------------------------------------------
+bool reservationExists(const ReservationQuery& query)
+{
+    TIME_FUNCTION("reservationExists");
+    ReservationScan scan(query);
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    return scan.find(reservations.records()) < reservations.records().size();
+}
+
+// Function findReservation copies the first match out of the snapshot
+//----------------------------------------------------------------
+bool findReservation(const ReservationQuery& query, Reservation& r, int* recordNumber)
+{
+    TIME_FUNCTION("findReservation");
+    ReservationScan scan(query);
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    RecordView<Reservation> records = reservations.records();
+    std::size_t position = scan.find(records);
+    if (position == records.size())
+    {
+        return false;
+    }
+    r = records[position];
+    if (recordNumber != nullptr)
+    {
+        *recordNumber = static_cast<int>(position);
+    }
+    return true;
+}
+
+// Function collectReservations copies every match out of the snapshot
+//----------------------------------------------------------------
+std::vector<Reservation> collectReservations(const ReservationQuery& query)
+{
+    TIME_FUNCTION("collectReservations");
+    ReservationScan scan(query);
+    RecordSnapshot<Reservation> reservations = reservationSnapshot();
+    RecordView<Reservation> records = reservations.records();
+    std::vector<Reservation> matches;
+    for (std::size_t position : scan.collect(records))
+    {
+        matches.push_back(records[position]);
+    }
+    return matches;
+}
@@ -0,0 +1,104 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: reservationScan.hpp
+ *
+ * Description: Header file of the ReservationScan module of the Ferry
+ *              Reservation System. A ReservationQuery names the sailing,
+ *              licence, onBoard and isLRL values a reservation must have;
+ *              a ReservationScan compiles it once into a byte mask and
+ *              the masked bytes expected, and then answers count, exists,
+ *              find and collect queries with one masked compare per
+ *              record.
+ *
+ * Design Issues: A Reservation is 23 bytes with no padding, so every
+ *                condition is a compare of some of those bytes; a text
+ *                condition covers the characters of the wanted value and
+ *                its terminator, which matches strncmp on the field
+ *                On SSE2 a record is tested with two overlapping 16 byte
+ *                compares, elsewhere with three 8 byte compares; neither
+ *                reads past the end of the record
+ *                Scans read a mapped reservationSnapshot, which must not
+ *                be held across a truncate of the file
+ */
+//================================================================
+#pragma once
+#include "reservation.hpp"
+#include "mappedFile.hpp"
+#include <cstddef>
+#include <vector>
+
+//================================================================
+// Enum: FlagMatch
+// Purpose: Which values of a bool field a query accepts
+//----------------------------------------------------------------
+enum FlagMatch {anyFlag, flagSet, flagClear};
+
+// Struct: ReservationQuery
+// Purpose: Conditions a reservation must meet; empty text and anyFlag
+// accept every value
+//----------------------------------------------------------------
+struct ReservationQuery
+{
+    const char* sailingID; // Sailing to match, nullptr or "" for any
+    const char* vehicleLicence; // Licence to match, nullptr or "" for any
+    FlagMatch onBoard; // Checked in or not
+    FlagMatch isLRL; // Low or high lane
+};
+
+//================================================================
+// Function bookingQuery returns the query of one vehicle's booking on a sailing
+//----------------------------------------------------------------
+ReservationQuery bookingQuery(const char sailingID[], const char vehicleLicence[]);
+
+// Function sailingQuery returns the query of every booking on a sailing
+//----------------------------------------------------------------
+ReservationQuery sailingQuery(const char sailingID[]);
+
+//================================================================
+// Class: ReservationScan
+// Purpose: A query compiled to a masked compare over reservation records
+//----------------------------------------------------------------
+class ReservationScan
+{
+public:
+    // Throws an exception if a text condition is longer than its field
+    explicit ReservationScan(const ReservationQuery& query);
+
+    // Function matches returns true if the record meets every condition
+    bool matches(const Reservation& r) const;
+    // Function count returns the number of matching records
+    std::size_t count(RecordView<Reservation> records) const;
+    // Function find returns the position of the first matching record at
+    // or after first, or records.size() if there is none
+    std::size_t find(RecordView<Reservation> records, std::size_t first = 0) const;
+    // Function collect returns the positions of every matching record
+    std::vector<std::size_t> collect(RecordView<Reservation> records) const;
+
+private:
+    unsigned char mask[sizeof(Reservation)]; // Bytes the conditions cover
+    unsigned char wanted[sizeof(Reservation)]; // Their values, zero elsewhere
+};
+
+//================================================================
+// Function countReservations returns the number of stored reservations
+// that meet the query
+//----------------------------------------------------------------
+int countReservations(const ReservationQuery& query);
+
+// Function reservationExists returns true if a stored reservation meets
+// the query
+//----------------------------------------------------------------
+bool reservationExists(const ReservationQuery& query);
+
+// Function findReservation copies the first stored reservation that meets
+// the query into r, and its record number into recordNumber if given
+// Returns false if there is none
+//----------------------------------------------------------------
+bool findReservation(const ReservationQuery& query, Reservation& r, int* recordNumber = nullptr);
+
+// Function collectReservations returns every stored reservation that
+// meets the query, in file order
+//----------------------------------------------------------------
+std::vector<Reservation> collectReservations(const ReservationQuery& query);
@@ -4,6 +4,22 @@
 /*
  * Filename: sailing.cpp
  * Revision History:
+ * Rev. 3 - 26/10/18 Modified by L. Xu
+ * 		  - Kept the SailingIndex module in sync on open, write and delete
+ * 		  - writeSailing always appends instead of writing at the read cursor
+ * 		  - Added writeSailings for appending a block of records at once
+ * 		  - Added updateSailingRecord for overwriting one record in place
+ * 		  - Timed public functions and counted I/O in the Stats module
+ * 		  - Traced per-record reads
+ * 		  - Added updateSailingRecords for overwriting many records with
+ * 		    one flush
+ * 		  - Added rewriteSailings for atomic whole-file rewrites
+ * 		  - Added async appends, block reads and readahead through the
+ * 		    AsyncIo module; synchronous functions settle them first
+ * 		  - rewriteSailings updates index entries in place instead of
+ * 		    rebuilding the index
+ * 		  - Added sailingSnapshot for zero-copy scans
+ * 		  - Shipped every change to the Replication module
  * Rev. 2 - 25/08/04 Modified by L. Xu
  * 		  - Fixed eof handling
  * Rev. 1 - 25/07/23 Original by C. Wen
@@ -24,6 +40,11 @@
 
 //================================================================
 #include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include "stats.hpp"
+#include "atomicFile.hpp"
+#include "asyncIo.hpp"
+#include "replication.hpp"
 #include <fstream>
 #include <stdexcept>
 #include <cstring>
@@ -31,6 +52,9 @@
 #include <iomanip>
 #include <string>
 #include <cstdio>
+#include <algorithm>
+#include <utility>
+#include <vector>
 #ifdef _WIN32
 	#include <io.h>      
 #else
@@ -43,14 +67,37 @@
 //------------------------------------------------------------
 static std::fstream sailingFile;
 static const std::string SAILINGFILENAME = "sailings.dat";
+static AsyncRecordFile sailingAsync = {"sailings.dat", -1, 0, 0}; // async state of the file
 
 //================================================================
+// Helper function rebuildIndex loads every record of the Sailing file
+// into the SailingIndex module and leaves the file at the beginning
+//----------------------------------------------------------------
+static void rebuildIndex()
+{
+	sailingIndexClear();
+	Sailing s;
+	int recordNumber = 0;
+	sailingFile.clear();
+	sailingFile.seekg(0, std::ios::beg);
+	countIo(sailingStorage, fileSeek);
+	while (sailingFile.read(reinterpret_cast<char*>(&s), sizeof(Sailing)))
+	{
+		sailingIndexPut(s, recordNumber);
+		recordNumber++;
+	}
+	countIo(sailingStorage, recordRead, recordNumber);
+	sailingFile.clear();
+	sailingFile.seekg(0, std::ios::beg);
+	countIo(sailingStorage, fileSeek);
+}
 
 // Function open creates and opens the Sailing file
 // Throws an exception if the file cannot be opened
 //----------------------------------------------------------------
 void sailingOpen()
 {
+	TIME_FUNCTION("sailingOpen");
 	// Try to open the sailing file without overwriting the contents
 	sailingFile.open(SAILINGFILENAME, std::ios::in | std::ios::out | std::ios::binary);
 	if (!sailingFile.is_open())
@@ -74,15 +121,20 @@ void sailingOpen()
 			throw std::runtime_error("Cannot open " + SAILINGFILENAME);
 		} 
 	}
+	countIo(sailingStorage, fileOpen);
+	rebuildIndex();
 }
 
 // Function close closes the Sailing file
 //----------------------------------------------------------------
 void sailingClose()
 {
+	TIME_FUNCTION("sailingClose");
+	asyncRecordFileClose(sailingAsync);
 	if (sailingFile.is_open())
     {
         sailingFile.close();
+        sailingIndexClear();
     }
     else
     {
@@ -96,12 +148,15 @@ void sailingClose()
 //----------------------------------------------------------------
 void sailingReset()
 {
+	TIME_FUNCTION("sailingReset");
+	asyncSettle(sailingAsync);
 	if (!sailingFile.is_open())
 	{
 		throw std::runtime_error("Reset: " + SAILINGFILENAME + " File not open.");
 	}
 	sailingFile.clear();
 	sailingFile.seekg(0, std::ios::beg); // Set get position to the start of the file
+	countIo(sailingStorage, fileSeek);
 }
 
 // Function getNextSailing obtains a line from the Sailing file
@@ -110,6 +165,7 @@ void sailingReset()
 //----------------------------------------------------------------
 bool getNextSailing(Sailing& s)
 {
+	TRACE_SPAN("getNextSailing");
 	if (!sailingFile.is_open())
 	{
 		throw std::runtime_error("getNextSailing: File not open.");
@@ -126,34 +182,296 @@ bool getNextSailing(Sailing& s)
 	}
 
     sailingFile.flush();
+    countIo(sailingStorage, fileFlush);
 
     if (!sailingFile)
     {
         // Throw an exception if the file could not be read from
         throw std::runtime_error("Error reading from file " + SAILINGFILENAME + ".");
     }
+	countIo(sailingStorage, recordRead);
 	return true;
 }
 
-// Function writeSailing writes a sailing record to the Sailing file
+// Function writeSailing appends a sailing record to the Sailing file
 // Throws an exception if the write operation fails
 //----------------------------------------------------------------
 void writeSailing(const Sailing& s)
 {
+	TIME_FUNCTION("writeSailing");
+	asyncSettle(sailingAsync);
 	if (!sailingFile.is_open())
 	{
         // Throw an exception if the file is not open
 		throw std::runtime_error("writeSailing: File not open.");
 	}
 
-    // Write information of the sailing object
+    // Write information of the sailing object at the end
     sailingFile.clear();
+	sailingFile.seekp(0, std::ios::end);
+	countIo(sailingStorage, fileSeek);
+	int recordNumber = static_cast<int>(sailingFile.tellp() / static_cast<std::streamoff>(sizeof(Sailing)));
 	sailingFile.write(reinterpret_cast<const char*>(&s), sizeof(Sailing));
 	if (sailingFile.fail() || sailingFile.bad())
 	{
 		throw std::runtime_error("writeSailing: Failed to write record");
 	}
 	sailingFile.flush();
+	countIo(sailingStorage, fileFlush);
+	countIo(sailingStorage, recordWritten);
+	sailingIndexPut(s, recordNumber);
+	shipWrite(sailingStorage, static_cast<long long>(recordNumber) * sizeof(Sailing), &s, sizeof(Sailing));
+}
+
+// Function writeSailings appends count sailing records to the Sailing file
+// using one write and one flush
+// Throws an exception if the write operation fails
+//----------------------------------------------------------------
+void writeSailings(const Sailing sailings[], int count)
+{
+	TIME_FUNCTION("writeSailings");
+	asyncSettle(sailingAsync);
+	if (!sailingFile.is_open())
+	{
+        // Throw an exception if the file is not open
+		throw std::runtime_error("writeSailings: File not open.");
+	}
+	if (count <= 0)
+	{
+		return;
+	}
+
+    // Write the whole block at the end
+    sailingFile.clear();
+	sailingFile.seekp(0, std::ios::end);
+	countIo(sailingStorage, fileSeek);
+	int firstRecord = static_cast<int>(sailingFile.tellp() / static_cast<std::streamoff>(sizeof(Sailing)));
+	sailingFile.write(reinterpret_cast<const char*>(sailings), static_cast<std::streamsize>(count) * sizeof(Sailing));
+	if (sailingFile.fail() || sailingFile.bad())
+	{
+		throw std::runtime_error("writeSailings: Failed to write records");
+	}
+	sailingFile.flush();
+	countIo(sailingStorage, fileFlush);
+	countIo(sailingStorage, recordWritten, count);
+	for (int i = 0; i < count; ++i)
+	{
+		sailingIndexPut(sailings[i], firstRecord + i);
+	}
+	shipWrite(sailingStorage, static_cast<long long>(firstRecord) * sizeof(Sailing), sailings,
+	          static_cast<std::size_t>(count) * sizeof(Sailing));
+}
+
+// Function rewriteSailings replaces the whole Sailing file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//----------------------------------------------------------------
+void rewriteSailings(const Sailing records[], int count)
+{
+	TIME_FUNCTION("rewriteSailings");
+	asyncRecordFileClose(sailingAsync);
+	if (!sailingFile.is_open())
+	{
+		// Throw an exception if the file is not open
+		throw std::runtime_error("File " + SAILINGFILENAME + " is not open.");
+	}
+	sailingFile.close();
+	std::string error;
+	try
+	{
+		rewriteAtomically(SAILINGFILENAME, records, static_cast<std::size_t>(count) * sizeof(Sailing));
+		countIo(sailingStorage, recordWritten, count);
+	}
+	catch (const std::exception& e)
+	{
+		error = e.what();
+	}
+
+	// Reopen the new file, or the untouched old one if the rewrite failed
+	sailingFile.open(SAILINGFILENAME, std::ios::in | std::ios::out | std::ios::binary);
+	if (!sailingFile.is_open())
+	{
+		throw std::runtime_error("Cannot open " + SAILINGFILENAME + ".");
+	}
+	countIo(sailingStorage, fileOpen);
+	if (!error.empty())
+	{
+		rebuildIndex();
+		throw std::runtime_error(error);
+	}
+
+	// The records written are the new index; entries are replaced in
+	// place, so sailings that kept their slot cost no allocation
+	for (int i = 0; i < count; ++i)
+	{
+		sailingIndexPut(records[i], i);
+	}
+	sailingIndexTruncate(count);
+	shipReplace(sailingStorage, records, static_cast<std::size_t>(count) * sizeof(Sailing));
+}
+
+// Function appendSailingsAsync queues count sailing records to be appended
+// through the AsyncIo backend; done gets the records written or -1
+//----------------------------------------------------------------
+void appendSailingsAsync(const Sailing records[], int count, bool sync, RecordCallback done)
+{
+	TIME_FUNCTION("appendSailingsAsync");
+	// Index the new records now, as writeSailings does, so lookups see them
+	int firstRecord = static_cast<int>(asyncAppendOffset(sailingAsync) / static_cast<long long>(sizeof(Sailing)));
+	for (int i = 0; i < count; ++i)
+	{
+		sailingIndexPut(records[i], firstRecord + i);
+	}
+	std::vector<Sailing> appended(records, records + count);
+	asyncAppend(sailingAsync, records, static_cast<std::size_t>(count) * sizeof(Sailing), sync, [count, firstRecord, appended, done](long result)
+	{
+		bool ok = result == static_cast<long>(count * sizeof(Sailing));
+		if (ok)
+		{
+			countIo(sailingStorage, recordWritten, count);
+			shipWrite(sailingStorage, static_cast<long long>(firstRecord) * sizeof(Sailing), appended.data(),
+			          appended.size() * sizeof(Sailing));
+		}
+		else
+		{
+			for (const Sailing& s : appended)
+			{
+				sailingIndexErase(s.sailingID);
+			}
+		}
+		if (done)
+		{
+			done(ok ? count : -1);
+		}
+	});
+}
+
+// Function readSailingsAsync queues a read of count sailing records from
+// firstRecord into records; done gets the records read or -1
+//----------------------------------------------------------------
+void readSailingsAsync(Sailing records[], int firstRecord, int count, RecordCallback done)
+{
+	TIME_FUNCTION("readSailingsAsync");
+	asyncReadAt(sailingAsync, records, static_cast<std::size_t>(count) * sizeof(Sailing),
+				static_cast<long long>(firstRecord) * sizeof(Sailing), [done](long result)
+	{
+		int read = result < 0 ? -1 : static_cast<int>(result / static_cast<long>(sizeof(Sailing)));
+		if (read > 0)
+		{
+			countIo(sailingStorage, recordRead, read);
+		}
+		if (done)
+		{
+			done(read);
+		}
+	});
+}
+
+// Function sailingReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void sailingReadahead()
+{
+	asyncReadahead(sailingAsync);
+}
+
+// Function sailingSnapshot flushes pending writes and maps the file
+//----------------------------------------------------------------
+RecordSnapshot<Sailing> sailingSnapshot()
+{
+	TIME_FUNCTION("sailingSnapshot");
+	asyncSettle(sailingAsync);
+	if (!sailingFile.is_open())
+	{
+		throw std::runtime_error("File " + SAILINGFILENAME + " is not open.");
+	}
+	sailingFile.flush();
+	return RecordSnapshot<Sailing>(MappedFile(SAILINGFILENAME));
+}
+
+// Function updateSailingRecord overwrites the stored record of the sailing
+// with the same sailingID in place
+// Throws an exception if the sailing does not exist or the write fails
+//----------------------------------------------------------------
+void updateSailingRecord(const Sailing& s)
+{
+	TIME_FUNCTION("updateSailingRecord");
+	asyncSettle(sailingAsync);
+	if (!sailingFile.is_open())
+	{
+        // Throw an exception if the file is not open
+		throw std::runtime_error("updateSailingRecord: File not open.");
+	}
+	const SailingIndexEntry* entry = sailingIndexFind(s.sailingID);
+	if (entry == nullptr)
+	{
+		throw std::runtime_error(std::string("updateSailingRecord: '") + s.sailingID + "' not found");
+	}
+	int recordNumber = entry->recordNumber;
+
+    // Overwrite the record slot
+    sailingFile.clear();
+	sailingFile.seekp(static_cast<std::streamoff>(recordNumber) * sizeof(Sailing), std::ios::beg);
+	countIo(sailingStorage, fileSeek);
+	sailingFile.write(reinterpret_cast<const char*>(&s), sizeof(Sailing));
+	if (sailingFile.fail() || sailingFile.bad())
+	{
+		throw std::runtime_error("updateSailingRecord: Failed to write record");
+	}
+	sailingFile.flush();
+	countIo(sailingStorage, fileFlush);
+	countIo(sailingStorage, recordWritten);
+	sailingIndexPut(s, recordNumber);
+	shipWrite(sailingStorage, static_cast<long long>(recordNumber) * sizeof(Sailing), &s, sizeof(Sailing));
+}
+
+// Function updateSailingRecords overwrites the stored records of count
+// sailings in place, in file order, with one flush
+// Throws an exception if a sailing does not exist or a write fails
+//----------------------------------------------------------------
+void updateSailingRecords(const Sailing sailings[], int count)
+{
+	TIME_FUNCTION("updateSailingRecords");
+	asyncSettle(sailingAsync);
+	if (!sailingFile.is_open())
+	{
+        // Throw an exception if the file is not open
+		throw std::runtime_error("updateSailingRecords: File not open.");
+	}
+
+    // Find every slot first so nothing is written if a sailing is missing
+	std::vector<std::pair<int, int> > slots; // record number, position in sailings
+	for (int i = 0; i < count; ++i)
+	{
+		const SailingIndexEntry* entry = sailingIndexFind(sailings[i].sailingID);
+		if (entry == nullptr)
+		{
+			throw std::runtime_error(std::string("updateSailingRecords: '") + sailings[i].sailingID + "' not found");
+		}
+		slots.push_back(std::make_pair(entry->recordNumber, i));
+	}
+	std::sort(slots.begin(), slots.end());
+
+    // Overwrite the record slots front to back
+	sailingFile.clear();
+	for (const std::pair<int, int>& slot : slots)
+	{
+		sailingFile.seekp(static_cast<std::streamoff>(slot.first) * sizeof(Sailing), std::ios::beg);
+		countIo(sailingStorage, fileSeek);
+		sailingFile.write(reinterpret_cast<const char*>(&sailings[slot.second]), sizeof(Sailing));
+		if (sailingFile.fail() || sailingFile.bad())
+		{
+			throw std::runtime_error("updateSailingRecords: Failed to write record");
+		}
+		sailingIndexPut(sailings[slot.second], slot.first);
+		shipWrite(sailingStorage, static_cast<long long>(slot.first) * sizeof(Sailing), &sailings[slot.second], sizeof(Sailing));
+	}
+	if (count > 0)
+	{
+		sailingFile.flush();
+		countIo(sailingStorage, fileFlush);
+		countIo(sailingStorage, recordWritten, count);
+	}
 }
 
 // Function checkSailingExists checks if a sailing with the provided
@@ -161,6 +479,7 @@ void writeSailing(const Sailing& s)
 //----------------------------------------------------------------
 int checkSailingExists(const char sailingID[])
 {
+	TIME_FUNCTION("checkSailingExists");
 	sailingReset();
 	Sailing temp;
 	int index = 0;
@@ -181,6 +500,8 @@ int checkSailingExists(const char sailingID[])
 //----------------------------------------------------------------
 void deleteSailing(const char sailingID[])
 {
+	TIME_FUNCTION("deleteSailing");
+	asyncSettle(sailingAsync);
 	if (!sailingFile.is_open())
 	{
         // Throw an exception if the file is not open
@@ -189,6 +510,7 @@ void deleteSailing(const char sailingID[])
 	//total record
 	sailingFile.clear();
 	sailingFile.seekg(0, std::ios::end);
+	countIo(sailingStorage, fileSeek);
 	std::streampos size = sailingFile.tellg();
 	int total = static_cast<int>(size / sizeof(Sailing));
 	if (total == 0)
@@ -199,6 +521,7 @@ void deleteSailing(const char sailingID[])
 
 	// Find target index
 	sailingFile.seekg(0, std::ios::beg);
+	countIo(sailingStorage, fileSeek);
 	int target = -1;
 	Sailing temp;
 	Sailing lastRecord;
@@ -206,6 +529,7 @@ void deleteSailing(const char sailingID[])
 	for (int i = 0; i < total; ++i)
 	{
 		sailingFile.read(reinterpret_cast<char*>(&temp), sizeof(Sailing));
+		countIo(sailingStorage, recordRead);
 		if (std::strncmp(temp.sailingID, sailingID, sizeof(temp.sailingID)) == 0)
 		{
 			target = i;
@@ -213,7 +537,9 @@ void deleteSailing(const char sailingID[])
 		}
 	}
 	sailingFile.seekg((total - 1) * sizeof(Sailing), std::ios::beg);
+	countIo(sailingStorage, fileSeek);
 	sailingFile.read(reinterpret_cast<char*>(&lastRecord), sizeof(Sailing));
+	countIo(sailingStorage, recordRead);
 
 	if (target < 0)
 	{
@@ -229,17 +555,29 @@ void deleteSailing(const char sailingID[])
 
 	// overwirte target slot
 	sailingFile.seekp(target * sizeof(Sailing), std::ios::beg);
+	countIo(sailingStorage, fileSeek);
 	sailingFile.write(reinterpret_cast<const char*>(&lastRecord), sizeof(Sailing));
 	if (sailingFile.fail())
 	{
 		throw std::runtime_error("deleteSailing: Overwrite failed");
 	}
+	countIo(sailingStorage, recordWritten);
+	shipWrite(sailingStorage, static_cast<long long>(target) * sizeof(Sailing), &lastRecord, sizeof(Sailing));
+
+	// Mirror the swap-delete in the index
+	sailingIndexErase(sailingID);
+	if (target != total - 1)
+	{
+		sailingIndexPut(lastRecord, target);
+	}
+	sailingIndexTruncate(total - 1);
 
 //Truncate 
 #ifdef _WIN32
     {
         // flush and close c++ stream
         sailingFile.flush();
+        countIo(sailingStorage, fileFlush);
         sailingFile.close();
 
         // open FILE*
@@ -257,6 +595,7 @@ void deleteSailing(const char sailingID[])
             std::fclose(f);
             throw std::runtime_error("deleteSailing: truncate failed");
         }
+        countIo(sailingStorage, fileTruncate);
         std::fclose(f);
 
         sailingFile.open(SAILINGFILENAME, std::ios::in | std::ios::out | std::ios::binary);
@@ -264,6 +603,7 @@ void deleteSailing(const char sailingID[])
 		{
             throw std::runtime_error("deleteSailing: re-open failed");
         }
+        countIo(sailingStorage, fileOpen);
     }
 #else
     {
@@ -284,6 +624,7 @@ void deleteSailing(const char sailingID[])
             close(fd);
             throw std::runtime_error("deleteSailing: truncate failed");
         }
+        countIo(sailingStorage, fileTruncate);
         close(fd);
 
         sailingFile.open(SAILINGFILENAME, std::ios::in | std::ios::out | std::ios::binary);
@@ -291,6 +632,8 @@ void deleteSailing(const char sailingID[])
 		{
             throw std::runtime_error("deleteSailing: re-open failed");
         }
+        countIo(sailingStorage, fileOpen);
     }
 #endif
+	shipTruncate(sailingStorage, static_cast<long long>(total - 1) * sizeof(Sailing));
 }
\ No newline at end of file
@@ -11,7 +11,9 @@
  *              init() should be called before any operations are performed.
  */
 //================================================================
-#pragma once 
+#pragma once
+#include "asyncIo.hpp"
+#include "mappedFile.hpp"
 #include <iostream>
 #include <string>
 using std::string;
@@ -43,10 +45,53 @@ void sailingReset();
 // Throws an exception if the read operation fails
 //----------------------------------------------------------------
 bool getNextSailing(Sailing& s);
-// Function writeSailing writes a sailing record to the Sailing file
+// Function writeSailing appends a sailing record to the Sailing file
 // Throws an exception if the write operation fails
 //----------------------------------------------------------------
 void writeSailing(const Sailing& s);
+// Function writeSailings appends count sailing records to the Sailing file
+// using one write and one flush
+// Throws an exception if the write operation fails
+//----------------------------------------------------------------
+void writeSailings(const Sailing sailings[], int count);
+// Function rewriteSailings replaces the whole Sailing file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//----------------------------------------------------------------
+void rewriteSailings(const Sailing records[], int count);
+// Function appendSailingsAsync queues count sailing records to be
+// appended through the AsyncIo backend, linked to a data sync if sync is
+// set. done runs from asyncPoll or asyncWait with the records written,
+// or -1 if the write failed.
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void appendSailingsAsync(const Sailing records[], int count, bool sync, RecordCallback done);
+// Function readSailingsAsync queues a read of count sailing records
+// starting at record firstRecord into records, which must stay valid
+// until done runs with the records read, or -1 if the read failed
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void readSailingsAsync(Sailing records[], int firstRecord, int count, RecordCallback done);
+// Function sailingReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void sailingReadahead();
+
+// Function sailingSnapshot maps the sailing file read-only for scans that
+// compare records in place; views of it stay valid while it lives
+// Throws an exception if the file is not open or cannot be read
+//----------------------------------------------------------------
+RecordSnapshot<Sailing> sailingSnapshot();
+// Function updateSailingRecord overwrites the stored record of the sailing
+// with the same sailingID in place
+// Throws an exception if the sailing does not exist or the write fails
+//----------------------------------------------------------------
+void updateSailingRecord(const Sailing& s);
+// Function updateSailingRecords overwrites the stored records of count
+// sailings in place using one flush
+// Throws an exception if a sailing does not exist or a write fails
+//----------------------------------------------------------------
+void updateSailingRecords(const Sailing sailings[], int count);
 // Function deleteSailing deletes a sailing record with the provided
 // sailingID. Throws an exception if the record is not found.
 //----------------------------------------------------------------
@@ -0,0 +1,286 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: sailingIndex.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the SailingIndex module of the Ferry
+ *              Reservation System. Holds an ordered map from sailing ID to
+ *              the cached record and its position in sailings.dat, plus a
+ *              table from record position back to ID so that overwrites
+ *              and swap-deletes in the Sailing module can be mirrored.
+ *
+ * Design Issues: Whole index is kept in memory, one entry per sailing
+ *                Rebuilt by sailingOpen() and updated on every write
+ *                Each (terminal, day) bucket keeps the largest remaining
+ *                lane lengths of its sailings, recomputed whenever one of
+ *                them is written; a day holds at most 100 sailings
+ */
+//================================================================
+#include "sailingIndex.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+//============================================================
+// Struct: CapacityBucket
+// Purpose: Largest remaining lane lengths over one terminal and day
+//------------------------------------------------------------
+struct CapacityBucket
+{
+    float maxHigh; // Largest high remaining length
+    float maxAny; // Largest of either remaining length
+};
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static SailingIndexMap sailingMap; // sailing ID -> cached record
+static std::vector<std::string> slotKeys; // record position -> sailing ID
+static std::map<std::string, CapacityBucket> buckets; // "ttt-dd" -> capacity
+
+//================================================================
+// Helper function idKey builds the map key for a sailing ID
+//----------------------------------------------------------------
+static std::string idKey(const char sailingID[])
+{
+    return std::string(sailingID, strnlen(sailingID, sizeof(Sailing::sailingID)));
+}
+
+// Helper function refreshBucket recomputes the capacity bucket holding
+// the given sailing ID from the entries of that terminal and day
+//----------------------------------------------------------------
+static void refreshBucket(const std::string& key)
+{
+    std::string day = key.substr(0, 6);
+    SailingIndexMap::const_iterator it = sailingMap.lower_bound(day + "-");
+    SailingIndexMap::const_iterator last = sailingMap.lower_bound(day + ".");
+    if (it == last)
+    {
+        buckets.erase(day);
+        return;
+    }
+    CapacityBucket bucket = {0.0f, 0.0f};
+    for (; it != last; ++it)
+    {
+        const Sailing& s = it->second.sailing;
+        bucket.maxHigh = std::max(bucket.maxHigh, s.highRemainingLength);
+        bucket.maxAny = std::max(bucket.maxAny, std::max(s.lowRemainingLength, s.highRemainingLength));
+    }
+    buckets[day] = bucket;
+}
+
+// Helper function terminalKey builds the 3 character terminal prefix
+//----------------------------------------------------------------
+static std::string terminalKey(const char terminal[])
+{
+    return std::string(terminal, strnlen(terminal, 3));
+}
+
+//================================================================
+// Function sailingIndexClear removes all entries from the index
+//----------------------------------------------------------------
+void sailingIndexClear()
+{
+    sailingMap.clear();
+    slotKeys.clear();
+    buckets.clear();
+}
+
+// Function sailingIndexPut adds or replaces the entry for a sailing
+// stored at the given record position of the Sailing file
+//----------------------------------------------------------------
+void sailingIndexPut(const Sailing& s, int recordNumber)
+{
+    std::string key = idKey(s.sailingID);
+    if (recordNumber >= static_cast<int>(slotKeys.size()))
+    {
+        slotKeys.resize(recordNumber + 1);
+    }
+
+    // Drop whatever sailing used to live in this slot
+    std::string& oldKey = slotKeys[recordNumber];
+    if (!oldKey.empty() && oldKey != key)
+    {
+        sailingMap.erase(oldKey);
+        refreshBucket(oldKey);
+    }
+
+    // Drop the old slot of this sailing if it moved
+    SailingIndexMap::iterator found = sailingMap.find(key);
+    if (found != sailingMap.end() && found->second.recordNumber != recordNumber)
+    {
+        slotKeys[found->second.recordNumber].clear();
+    }
+
+    SailingIndexEntry& entry = sailingMap[key];
+    entry.sailing = s;
+    entry.recordNumber = recordNumber;
+    oldKey = key;
+    refreshBucket(key);
+}
+
+// Function sailingIndexErase removes the entry with the provided sailingID
+//----------------------------------------------------------------
+void sailingIndexErase(const char sailingID[])
+{
+    SailingIndexMap::iterator found = sailingMap.find(idKey(sailingID));
+    if (found == sailingMap.end())
+    {
+        return;
+    }
+    std::string key = found->first;
+    slotKeys[found->second.recordNumber].clear();
+    sailingMap.erase(found);
+    refreshBucket(key);
+}
+
+// Function sailingIndexTruncate drops all entries stored at record
+// positions greater than or equal to recordCount
+//----------------------------------------------------------------
+void sailingIndexTruncate(int recordCount)
+{
+    for (int i = recordCount; i < static_cast<int>(slotKeys.size()); ++i)
+    {
+        if (!slotKeys[i].empty())
+        {
+            sailingMap.erase(slotKeys[i]);
+            refreshBucket(slotKeys[i]);
+        }
+    }
+    if (recordCount < static_cast<int>(slotKeys.size()))
+    {
+        slotKeys.resize(recordCount);
+    }
+}
+
+// Function sailingIndexFind looks up a sailing by ID
+// Returns a pointer to the entry, or nullptr if it is not indexed
+//----------------------------------------------------------------
+const SailingIndexEntry* sailingIndexFind(const char sailingID[])
+{
+    SailingIndexMap::const_iterator found = sailingMap.find(idKey(sailingID));
+    if (found == sailingMap.end())
+    {
+        return nullptr;
+    }
+    return &found->second;
+}
+
+// Function sailingIndexSize returns the number of indexed sailings
+//----------------------------------------------------------------
+int sailingIndexSize()
+{
+    return static_cast<int>(sailingMap.size());
+}
+
+// Function sailingIndexAll returns every sailing in departure order
+//----------------------------------------------------------------
+SailingRange sailingIndexAll()
+{
+    SailingRange range;
+    range.first = SailingIndexIterator(sailingMap.begin());
+    range.last = SailingIndexIterator(sailingMap.end());
+    return range;
+}
+
+// Function sailingIndexTerminal returns all sailings leaving the
+// given 3 letter terminal, in departure order
+//----------------------------------------------------------------
+SailingRange sailingIndexTerminal(const char terminal[])
+{
+    // '-' follows the terminal in every ID and '.' is the next character,
+    // so "ttt." bounds all of "ttt-dd-hh"
+    std::string prefix = terminalKey(terminal);
+    SailingRange range;
+    range.first = SailingIndexIterator(sailingMap.lower_bound(prefix + "-"));
+    range.last = SailingIndexIterator(sailingMap.lower_bound(prefix + "."));
+    return range;
+}
+
+// Function sailingIndexRange returns the sailings leaving the given
+// terminal on the given day between fromHour and toHour inclusive
+// Throws an exception if the day or hours are out of range
+//----------------------------------------------------------------
+SailingRange sailingIndexRange(const char terminal[], int day, int fromHour, int toHour)
+{
+    if (day < 0 || day > 99 || fromHour < 0 || fromHour > 99 || toHour < 0 || toHour > 99)
+    {
+        throw std::out_of_range("sailingIndexRange: day and hours must be 00-99.");
+    }
+    SailingRange range;
+    if (fromHour > toHour)
+    {
+        // Empty range
+        range.first = range.last = SailingIndexIterator(sailingMap.end());
+        return range;
+    }
+
+    char low[10];
+    char high[10];
+    std::string prefix = terminalKey(terminal);
+    std::snprintf(low, sizeof(low), "%s-%02d-%02d", prefix.c_str(), day, fromHour);
+    std::snprintf(high, sizeof(high), "%s-%02d-%02d", prefix.c_str(), day, toHour);
+    range.first = SailingIndexIterator(sailingMap.lower_bound(low));
+    range.last = SailingIndexIterator(sailingMap.upper_bound(high));
+    return range;
+}
+
+// Function sailingIndexFindAvailable returns up to k sailings leaving the
+// given terminal at or after day/hour that have room for a vehicle of the
+// given length
+//----------------------------------------------------------------
+std::vector<Sailing> sailingIndexFindAvailable(const char terminal[],
+                                               int day,
+                                               int hour,
+                                               float vehicleLength,
+                                               bool highLaneOnly,
+                                               int k)
+{
+    if (day < 0 || day > 99 || hour < 0 || hour > 99)
+    {
+        throw std::out_of_range("sailingIndexFindAvailable: day and hour must be 00-99.");
+    }
+    std::vector<Sailing> found;
+    if (k <= 0)
+    {
+        return found;
+    }
+
+    char start[10];
+    std::string prefix = terminalKey(terminal);
+    std::snprintf(start, sizeof(start), "%s-%02d-%02d", prefix.c_str(), day, hour);
+    std::string firstDay(start, 6);
+
+    // Walk the days of this terminal, skipping days that cannot fit the vehicle
+    std::map<std::string, CapacityBucket>::const_iterator bucket = buckets.lower_bound(firstDay);
+    std::map<std::string, CapacityBucket>::const_iterator lastBucket = buckets.lower_bound(prefix + ".");
+    for (; bucket != lastBucket && static_cast<int>(found.size()) < k; ++bucket)
+    {
+        float best = highLaneOnly ? bucket->second.maxHigh : bucket->second.maxAny;
+        if (best < vehicleLength)
+        {
+            continue;
+        }
+
+        // Only the first day starts part way through
+        SailingIndexMap::const_iterator it = sailingMap.lower_bound(
+            bucket->first == firstDay ? std::string(start) : bucket->first + "-");
+        SailingIndexMap::const_iterator last = sailingMap.lower_bound(bucket->first + ".");
+        for (; it != last && static_cast<int>(found.size()) < k; ++it)
+        {
+            const Sailing& s = it->second.sailing;
+            if (s.highRemainingLength >= vehicleLength ||
+                (!highLaneOnly && s.lowRemainingLength >= vehicleLength))
+            {
+                found.push_back(s);
+            }
+        }
+    }
+    return found;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: sailingIndex.hpp
+ *
+ * Description: Header file of the SailingIndex module of the Ferry
+ *              Reservation System. Keeps an in-memory ordered index over
+ *              the Sailing file keyed on (terminal, day, hour), so that
+ *              departure boards and sailing searches only read the
+ *              matching slice instead of scanning sailings.dat.
+ *              The index is maintained by the Sailing module; other
+ *              modules should only use the lookup and range functions.
+ *
+ * Design Issues: The sailing ID format ttt-dd-hh sorts in the same order
+ *                as the (terminal, day, hour) key, so the ID is the key
+ *                Remaining lane lengths are also bucketed per terminal and
+ *                day so capacity searches can skip full days
+ */
+//================================================================
+#pragma once
+#include "sailing.hpp"
+#include <map>
+#include <string>
+#include <vector>
+//================================================================
+// Struct: SailingIndexEntry
+// Purpose: Cached copy of a sailing record and its position in the
+// Sailing file
+//----------------------------------------------------------------
+struct SailingIndexEntry
+{
+    Sailing sailing; // Copy of the record as last written
+    int recordNumber; // Record position in the Sailing file
+};
+
+typedef std::map<std::string, SailingIndexEntry> SailingIndexMap;
+
+//================================================================
+// Class: SailingIndexIterator
+// Purpose: Forward iterator over index entries in departure order,
+// dereferences to the cached Sailing record
+//----------------------------------------------------------------
+class SailingIndexIterator
+{
+public:
+    SailingIndexIterator() {}
+    explicit SailingIndexIterator(SailingIndexMap::const_iterator pos) : it(pos) {}
+    const Sailing& operator*() const { return it->second.sailing; }
+    const Sailing* operator->() const { return &it->second.sailing; }
+    int recordNumber() const { return it->second.recordNumber; }
+    SailingIndexIterator& operator++() { ++it; return *this; }
+    bool operator==(const SailingIndexIterator& other) const { return it == other.it; }
+    bool operator!=(const SailingIndexIterator& other) const { return it != other.it; }
+private:
+    SailingIndexMap::const_iterator it;
+};
+
+//================================================================
+// Struct: SailingRange
+// Purpose: Half-open range of index entries, usable in range-for loops
+//----------------------------------------------------------------
+struct SailingRange
+{
+    SailingIndexIterator first;
+    SailingIndexIterator last;
+    SailingIndexIterator begin() const { return first; }
+    SailingIndexIterator end() const { return last; }
+    bool empty() const { return first == last; }
+};
+
+//================================================================
+// Function sailingIndexClear removes all entries from the index
+//----------------------------------------------------------------
+void sailingIndexClear();
+
+// Function sailingIndexPut adds or replaces the entry for a sailing
+// stored at the given record position of the Sailing file.
+// Any other sailing previously stored at that position is dropped.
+//----------------------------------------------------------------
+void sailingIndexPut(const Sailing& s, int recordNumber);
+
+// Function sailingIndexErase removes the entry with the provided sailingID
+// Does nothing if the sailing is not indexed
+//----------------------------------------------------------------
+void sailingIndexErase(const char sailingID[]);
+
+// Function sailingIndexTruncate drops all entries stored at record
+// positions greater than or equal to recordCount
+//----------------------------------------------------------------
+void sailingIndexTruncate(int recordCount);
+
+// Function sailingIndexFind looks up a sailing by ID
+// Returns a pointer to the entry, or nullptr if it is not indexed
+//----------------------------------------------------------------
+const SailingIndexEntry* sailingIndexFind(const char sailingID[]);
+
+// Function sailingIndexSize returns the number of indexed sailings
+//----------------------------------------------------------------
+int sailingIndexSize();
+
+// Function sailingIndexAll returns every sailing in departure order
+//----------------------------------------------------------------
+SailingRange sailingIndexAll();
+
+// Function sailingIndexTerminal returns all sailings leaving the
+// given 3 letter terminal, in departure order
+//----------------------------------------------------------------
+SailingRange sailingIndexTerminal(const char terminal[]);
+
+// Function sailingIndexRange returns the sailings leaving the given
+// terminal on the given day between fromHour and toHour inclusive
+// Throws an exception if the day or hours are out of range
+//----------------------------------------------------------------
+SailingRange sailingIndexRange(const char terminal[], int day, int fromHour, int toHour);
+
+// Function sailingIndexFindAvailable returns up to k sailings leaving the
+// given terminal at or after day/hour that have room for a vehicle of the
+// given length. If highLaneOnly is true only the high remaining length is
+// considered, otherwise the vehicle may use either lane.
+// Days whose largest remaining length is too small are skipped without
+// visiting their sailings.
+//----------------------------------------------------------------
+std::vector<Sailing> sailingIndexFindAvailable(const char terminal[],
+                                               int day,
+                                               int hour,
+                                               float vehicleLength,
+                                               bool highLaneOnly,
+                                               int k);
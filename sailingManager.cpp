@@ -5,6 +5,23 @@
  * Filename: sailingManager.cpp
  *
  * Revision History:
+ * Rev. 3 - 26/10/18 Modified by L. Xu
+ * - Added printDepartureBoard() using the sailing index
+ * - Added findAvailableSailings() using the sailing index capacity buckets
+ * - Added createSailingsFromTimetable() for building a season in one batch
+ * - createSailing checks uniqueness with the sailing index and stops if
+ *   the vessel does not exist
+ * - Added a createSailing overload that takes the ID instead of prompting
+ * - Timed public functions in the Stats module
+ * - Traced the sailings file rewrite in updateSailing
+ * - Counted sailings created in the Metrics module
+ * - updateSailing rewrites sailings.dat atomically in one write
+ * - updateSailing, getVessel and querySailing keep their scratch containers
+ *   in the RequestArena
+ * - getVesselLength and printSailingReport scan mapped snapshots
+ * - Added checkInWave() for checking in a queue of plates from a file
+ * - createSailing holds the DataWriteLock once its prompts are answered
+ * - checkInReservation sets onBoard only after the payment is confirmed
  * Rev. 2 - 25/08/04 Modified by L. Xu and A. Kong
  * - Fixed querySailing()
  * - Added function for print sailing report
@@ -29,9 +46,15 @@
 #include "sailingManager.hpp"
 #include "vessel.hpp"            
 #include "sailing.hpp"
+#include "sailingIndex.hpp"
 #include "vehicle.hpp"
 #include "reservation.hpp"
 #include "reservationManager.hpp"
+#include "stats.hpp"
+#include "metrics.hpp"
+#include "requestArena.hpp"
+#include "dataLock.hpp"
+#include "replication.hpp"
 #include <vector>
 #include <string>
 #include <cstring>              
@@ -43,7 +66,10 @@
 #include <cctype>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 //================================================================
 
 // Function getVessel displays all available vessels for sailings
@@ -53,9 +79,11 @@
 //----------------------------------------------------------------
 char* getVessel()
 {
+    TIME_FUNCTION("getVessel");
     vesselReset();
     Vessel vessel;
-    std::vector<std::string> names;
+    RequestArena scratch;
+    std::pmr::vector<std::pmr::string> names(scratch.resource());
     std::cout << "\nVessels:\n";
     // Get all vessels for sailings
     while (getNextVessel(vessel))
@@ -125,7 +153,7 @@ char* getVessel()
         }
         for (auto &nm : names)
         {
-            if (nm == input)
+            if (nm.compare(input.c_str()) == 0)
             {
                 std::strncpy(vesselName, nm.c_str(),sizeof(vesselName) - 1);
                 vesselName[sizeof(vesselName) - 1] = '\0';
@@ -144,14 +172,14 @@ char* getVessel()
 // as an int value
 // Throws an exception if vessel does not exist
 //----------------------------------------------------------------
-int getVesselLength(char vesselName[])
+int getVesselLength(const char vesselName[])
 {
-    vesselReset();
-    Vessel vessel;
+    TIME_FUNCTION("getVesselLength");
+    RecordSnapshot<Vessel> vessels = vesselSnapshot();
     // Find the specified vessel and get total lane length
-    while (getNextVessel(vessel))
+    for (const Vessel& vessel : vessels.records())
     {
-        if (std::strcmp(vesselName, vessel.name) == 0)
+        if (std::strncmp(vesselName, vessel.name, sizeof(vessel.name)) == 0)
         {
             return static_cast<int>(vessel.HCLL + vessel.LCLL);
         }
@@ -166,6 +194,7 @@ int getVesselLength(char vesselName[])
 //----------------------------------------------------------------
 int sailingManagerExists(char sailingID[])
 {
+    TIME_FUNCTION("sailingManagerExists");
     checkSailingExists(sailingID);
     return 1;
 }
@@ -176,6 +205,7 @@ int sailingManagerExists(char sailingID[])
 //----------------------------------------------------------------
 void accessReservationManager(char sailingID[])
 {
+    TIME_FUNCTION("accessReservationManager");
     int count = viewReservations(sailingID);
     std::cout << "Total reservations on " << sailingID << ": " << count << "\n";
 } 
@@ -185,6 +215,7 @@ void accessReservationManager(char sailingID[])
 //----------------------------------------------------------------
 void createSailing(char vesselName[])
 {
+    TIME_FUNCTION("createSailing (prompt)");
     // total capacity and if vessel exists and ask user for id
     
     
@@ -263,29 +294,49 @@ void createSailing(char vesselName[])
         }
     }
 
+    DataWriteLock request;
+    ShippedRequest shipped;
+    createSailing(sailingID, vesselName);
+}
+
+// Function createSailing with a sailingID creates the sailing on a vessel
+// without prompting
+// Throws an exception if the ID is invalid or already exists, or the
+// vessel does not exist
+//----------------------------------------------------------------
+void createSailing(char sailingID[], char vesselName[])
+{
+    TIME_FUNCTION("createSailing");
+    // Check format ttt-dd-hh
+    if (std::strlen(sailingID) != 9 || !isalpha(sailingID[0]) || !isalpha(sailingID[1]) ||
+        !isalpha(sailingID[2]) || sailingID[3] != '-' || !isdigit(sailingID[4]) ||
+        !isdigit(sailingID[5]) || sailingID[6] != '-' || !isdigit(sailingID[7]) || !isdigit(sailingID[8]))
+    {
+        throw std::runtime_error("createSailing: Invalid format. Please use ttt-dd-hh.");
+    }
+
     Vessel temp;
     vesselReset();
     // Find the correct vessel record to be used
     while (true)
     {
-        getNextVessel(temp);
+        if (!getNextVessel(temp))
+        {
+            throw std::runtime_error(std::string("createSailing: Vessel ") + vesselName + " not found.");
+        }
         if (std::strcmp(temp.name, vesselName) == 0)
         {
             break;
         }
     }
     //check uniqueness
-    try
+    if (sailingIndexFind(sailingID) != nullptr)
     {
-        checkSailingExists(sailingID);
         throw std::runtime_error("createSailing: ID already exists.");
     }
-    catch (const std::runtime_error&)
-    {                                          // ?
-    }
 
     // build record name length lrl hrl
-    Sailing s;
+    Sailing s = {};
     std::strncpy(s.vesselName, vesselName, sizeof(s.vesselName) - 1);
     std::strncpy(s.sailingID, sailingID, sizeof(s.sailingID) - 1);
     s.lowRemainingLength = temp.LCLL;
@@ -293,9 +344,156 @@ void createSailing(char vesselName[])
 
     //call write sailing
     writeSailing(s);
+    countMetric(sailingsCreatedTotal);
     std::cout << "Created sailing " << sailingID << " on vessel " << vesselName << ".\n";
 }
 
+// Function parseTimetableList is a helper of createSailingsFromTimetable;
+// it parses a comma separated list of 2 digit values and/or ranges
+// (e.g. "01,03-05") into numbers
+// Throws an exception if the list is malformed
+//----------------------------------------------------------------
+static std::vector<int> parseTimetableList(const std::string& field, int lineNumber)
+{
+    std::vector<int> values;
+    std::stringstream items(field);
+    std::string item;
+    while (std::getline(items, item, ','))
+    {
+        int first = -1;
+        int last = -1;
+        bool valid = false;
+        if (item.size() == 2 && isdigit(item[0]) && isdigit(item[1]))
+        {
+            first = last = std::stoi(item);
+            valid = true;
+        }
+        else if (item.size() == 5 && item[2] == '-' && isdigit(item[0]) && isdigit(item[1]) &&
+                 isdigit(item[3]) && isdigit(item[4]))
+        {
+            first = std::stoi(item.substr(0, 2));
+            last = std::stoi(item.substr(3, 2));
+            valid = first <= last;
+        }
+        if (!valid)
+        {
+            throw std::runtime_error("createSailingsFromTimetable: line " + std::to_string(lineNumber) +
+                                     ": invalid day/hour list '" + field + "'.");
+        }
+        for (int value = first; value <= last; ++value)
+        {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+// Function createSailingsFromTimetable creates a batch of sailings from a
+// timetable template file of "terminal days hours vesselName" lines
+// Returns the number of sailings created
+// Throws an exception if the file cannot be read or the timetable is invalid
+//----------------------------------------------------------------
+int createSailingsFromTimetable(char fileName[])
+{
+    TIME_FUNCTION("createSailingsFromTimetable");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::ifstream timetable(fileName);
+    if (!timetable.is_open())
+    {
+        throw std::runtime_error(std::string("createSailingsFromTimetable: Cannot open ") + fileName + ".");
+    }
+
+    // Load every vessel once instead of rescanning per sailing
+    std::unordered_map<std::string, Vessel> vessels;
+    Vessel vessel;
+    vesselReset();
+    while (getNextVessel(vessel))
+    {
+        vessels[vessel.name] = vessel;
+    }
+
+    // Build all records in memory
+    std::vector<Sailing> batch;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(timetable, line))
+    {
+        lineNumber++;
+        std::stringstream fields(line);
+        std::string terminal, days, hours, vesselName;
+        if (!(fields >> terminal) || terminal[0] == '#')
+        {
+            continue; // blank or comment line
+        }
+        if (!(fields >> days >> hours >> vesselName))
+        {
+            throw std::runtime_error("createSailingsFromTimetable: line " + std::to_string(lineNumber) +
+                                     ": expected terminal days hours vesselName.");
+        }
+        if (terminal.size() != 3 || !isalpha(terminal[0]) || !isalpha(terminal[1]) || !isalpha(terminal[2]))
+        {
+            throw std::runtime_error("createSailingsFromTimetable: line " + std::to_string(lineNumber) +
+                                     ": terminal must be 3 letters.");
+        }
+        std::unordered_map<std::string, Vessel>::const_iterator assigned = vessels.find(vesselName);
+        if (assigned == vessels.end())
+        {
+            throw std::runtime_error("createSailingsFromTimetable: line " + std::to_string(lineNumber) +
+                                     ": vessel " + vesselName + " not found.");
+        }
+        std::vector<int> dayList = parseTimetableList(days, lineNumber);
+        std::vector<int> hourList = parseTimetableList(hours, lineNumber);
+        for (int day : dayList)
+        {
+            for (int hour : hourList)
+            {
+                Sailing s = {};
+                std::snprintf(s.sailingID, sizeof(s.sailingID), "%s-%02d-%02d", terminal.c_str(), day, hour);
+                std::snprintf(s.vesselName, sizeof(s.vesselName), "%.*s",
+                              static_cast<int>(sizeof(assigned->second.name)), assigned->second.name);
+                s.lowRemainingLength = assigned->second.LCLL;
+                s.highRemainingLength = assigned->second.HCLL;
+                batch.push_back(s);
+            }
+        }
+    }
+
+    // Check uniqueness within the batch with one sort, then against the file
+    std::vector<std::string> ids;
+    ids.reserve(batch.size());
+    for (const Sailing& s : batch)
+    {
+        ids.emplace_back(s.sailingID);
+    }
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::string>::const_iterator duplicate = std::adjacent_find(ids.begin(), ids.end());
+    if (duplicate != ids.end())
+    {
+        throw std::runtime_error("createSailingsFromTimetable: " + *duplicate + " appears more than once.");
+    }
+    for (const std::string& id : ids)
+    {
+        if (sailingIndexFind(id.c_str()) != nullptr)
+        {
+            throw std::runtime_error("createSailingsFromTimetable: " + id + " already exists.");
+        }
+    }
+
+    // Append the whole season in one write
+    writeSailings(batch.data(), static_cast<int>(batch.size()));
+    countMetric(sailingsCreatedTotal, static_cast<long long>(batch.size()));
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Created " << batch.size() << " sailings from " << fileName
+              << " in " << std::fixed << std::setprecision(3) << seconds << "s";
+    if (seconds > 0)
+    {
+        std::cout << " (" << std::setprecision(0) << batch.size() / seconds << " sailings/s)";
+    }
+    std::cout << ".\n" << std::defaultfloat << std::setprecision(6);
+    return static_cast<int>(batch.size());
+}
+
 // Function updateSailing updates the total space available on a sailing
 // vehicleLen is the length of the vehicle being added/removed, measured in meters
 // Throws an exception if space on sailing cannot be added to/subtracted from,
@@ -303,7 +501,10 @@ void createSailing(char vesselName[])
 //----------------------------------------------------------------
 void updateSailing(char sailingID[], int vehicleLen)
 {
-    std::vector<Sailing> all;
+    TIME_FUNCTION("updateSailing");
+    RequestArena scratch;
+    std::pmr::vector<Sailing> all(scratch.resource());
+    all.reserve(sailingIndexSize());
     sailingReset();
     Sailing s;
     while (getNextSailing(s)) all.push_back(s);
@@ -328,13 +529,8 @@ void updateSailing(char sailingID[], int vehicleLen)
     {
         throw std::runtime_error(std::string("updateSailing: ") + sailingID + " not found.");
     }
-    sailingClose();
-    std::remove("sailings.dat");
-    sailingOpen();
-    for (auto & rec : all)
-    {
-        writeSailing(rec);
-    }
+    TRACE_SPAN("rewrite sailings.dat");
+    rewriteSailings(all.data(), static_cast<int>(all.size()));
     std::cout << "Updated sailing " << sailingID << ".\n";
 }
 
@@ -345,19 +541,79 @@ void updateSailing(char sailingID[], int vehicleLen)
 //----------------------------------------------------------------
 void checkInReservation(char sailingID[], char vehicleLicence[])
 {
-    float fare = checkIn(sailingID, vehicleLicence);
+    TIME_FUNCTION("checkInReservation");
+    int recordNumber = -1;
+    float fare = checkInFare(sailingID, vehicleLicence, true, recordNumber);
     std::cout<<"Collect fare: $"<< fare << "\nConfirm payment [Y/N]: ";
     char c; std::cin>> c;
     if (std::toupper(c) != 'Y')
     {
         throw std::runtime_error("checkInReservation: Payment not confirmed.");
     }
+    // Boarded only once the fare is paid, so a declined payment can retry
+    commitCheckIn(recordNumber);
     std::cout<<"Reservation checked in.\n";
 }
 
+// Function checkInWave reads the plate queue, checks the whole wave in
+// with checkInReservations and prints the refusals, fares and rate
+//----------------------------------------------------------------
+int checkInWave(const char sailingID[], const char fileName[])
+{
+    TIME_FUNCTION("checkInWave");
+    std::ifstream queue(fileName);
+    if (!queue.is_open())
+    {
+        throw std::runtime_error(std::string("checkInWave: Cannot open ") + fileName + ".");
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<CheckInRequest> requests;
+    std::string line;
+    while (std::getline(queue, line))
+    {
+        // One plate per line; blank lines and # comments are skipped
+        std::istringstream fields(line);
+        std::string plate;
+        if (!(fields >> plate) || plate[0] == '#')
+        {
+            continue;
+        }
+        CheckInRequest request = {};
+        std::strncpy(request.vehicleLicence, plate.c_str(), sizeof(request.vehicleLicence) - 1);
+        if (plate.size() >= sizeof(request.vehicleLicence))
+        {
+            request.vehicleLicence[0] = '\0'; // matches no reservation
+        }
+        requests.push_back(request);
+    }
+
+    int boarded = checkInReservations(sailingID, requests.data(), static_cast<int>(requests.size()));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    float fares = 0;
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        if (requests[i].checkedIn)
+        {
+            fares += requests[i].fare;
+        }
+        else
+        {
+            std::cout << "  " << (requests[i].vehicleLicence[0] == '\0' ? "(unreadable plate)" : requests[i].vehicleLicence)
+                      << " refused: " << requests[i].error << "\n";
+        }
+    }
+    std::cout << "Checked in " << boarded << " of " << requests.size() << " vehicles on " << sailingID
+              << ". Collect fares: $" << fares << "\n"
+              << "Processed in " << std::fixed << std::setprecision(3) << seconds * 1000 << " ms ("
+              << std::setprecision(0) << (seconds > 0 ? requests.size() * 60.0 / seconds : 0.0)
+              << " vehicles/minute)" << std::defaultfloat << std::setprecision(6) << std::endl;
+    return boarded;
+}
+
 // helper function for printing relevant sailing info. used by querySailing
 void printSailingInfo(char sailingID[])
 {
+    TIME_FUNCTION("printSailingInfo");
     Sailing tempSailing;
     Reservation tempRes;
     Vehicle tempVehicle;
@@ -476,9 +732,11 @@ void printSailingInfo(char sailingID[])
 //----------------------------------------------------------------
 char* querySailing()
 {
+    TIME_FUNCTION("querySailing");
     sailingReset();
     Sailing s;
-    std::vector<std::string> ids;
+    RequestArena scratch;
+    std::pmr::vector<std::pmr::string> ids(scratch.resource());
     static char sailingID[10]; //9 characters for id, 1 buffer
     std::cout<<"\nAvailable sailings:\n";
 
@@ -519,6 +777,7 @@ char* querySailing()
 //----------------------------------------------------------------
 void removeReservations(char sailingID[])
 {
+    TIME_FUNCTION("removeReservations");
     
     deleteReservations(sailingID);
     deleteSailing(sailingID);
@@ -529,10 +788,9 @@ void removeReservations(char sailingID[])
 //----------------------------------------------------------------
 void printSailingReport(char printerName[])
 {
-    Sailing tempSailing;
+    TIME_FUNCTION("printSailingReport");
     Vessel tempVessel;
-    sailingReset();
-    vesselReset();
+    RecordSnapshot<Sailing> sailings = sailingSnapshot();
     std::time_t now = std::time(nullptr);
     std::tm* local_time = std::localtime(&now);
     char date_str[9];
@@ -547,7 +805,7 @@ void printSailingReport(char printerName[])
               << std::setw(12) << "#Vehicles"
               << std::setw(12) << "LenFull(%)" << std::endl;
     // print a line for every sailing
-    while (getNextSailing(tempSailing))
+    for (const Sailing& tempSailing : sailings.records())
     {
         // calculate the percent of the total lane length full
         float vesselTtlLen = (float)getVesselLength(tempSailing.vesselName);
@@ -561,4 +819,64 @@ void printSailingReport(char printerName[])
             << std::setw(12) << viewReservations(tempSailing.sailingID)
             << std::setw(12) << percentLenFull << std::endl;
     } 
+}
+
+// Function printDepartureBoard displays the sailings leaving the given
+// terminal on the given day between fromHour and toHour inclusive,
+// in departure order, using the SailingIndex module
+// Throws an exception if the day or hours are out of range
+//----------------------------------------------------------------
+void printDepartureBoard(char terminal[], int day, int fromHour, int toHour)
+{
+    TIME_FUNCTION("printDepartureBoard");
+    SailingRange departures = sailingIndexRange(terminal, day, fromHour, toHour);
+    std::cout << "\nDepartures from " << terminal << " on day "
+              << std::setfill('0') << std::setw(2) << day << std::setfill(' ') << ":\n";
+    if (departures.empty())
+    {
+        std::cout << "No sailings in the requested hours.\n";
+        return;
+    }
+    std::cout << std::left
+              << std::setw(12) << "Sailing ID"
+              << std::setw(8) << "Hour"
+              << std::setw(28) << "Vessel Name"
+              << std::setw(10) << "LRL(m)"
+              << std::setw(10) << "HRL(m)" << std::endl;
+    // print a line for every sailing in the slice
+    for (const Sailing& s : departures)
+    {
+        std::cout << std::left << std::fixed << std::setprecision(1)
+                  << std::setw(12) << s.sailingID
+                  << std::setw(8) << std::string(s.sailingID + 7, 2)
+                  << std::setw(28) << s.vesselName
+                  << std::setw(10) << s.lowRemainingLength
+                  << std::setw(10) << s.highRemainingLength << std::endl;
+    }
+}
+
+// Function findAvailableSailings returns the first k sailings leaving the
+// given terminal at or after fromTime (Format: dd-hh) that can fit a vehicle
+// of the given length and height, in departure order
+// Throws an exception if fromTime is not in the dd-hh format
+//----------------------------------------------------------------
+std::vector<Sailing> findAvailableSailings(char terminal[],
+                                           char fromTime[],
+                                           float vehicleLength,
+                                           float vehicleHeight,
+                                           int k)
+{
+    TIME_FUNCTION("findAvailableSailings");
+    // Check format dd-hh
+    if (std::strlen(fromTime) != 5 || !isdigit(fromTime[0]) || !isdigit(fromTime[1]) ||
+        fromTime[2] != '-' || !isdigit(fromTime[3]) || !isdigit(fromTime[4]))
+    {
+        throw std::runtime_error("findAvailableSailings: Time must use the format dd-hh.");
+    }
+    int day = (fromTime[0] - '0') * 10 + (fromTime[1] - '0');
+    int hour = (fromTime[3] - '0') * 10 + (fromTime[4] - '0');
+
+    // Same lane rule as createReservation
+    bool isLRL = (vehicleHeight <= 2 && vehicleLength <= 7);
+    return sailingIndexFindAvailable(terminal, day, hour, vehicleLength, !isLRL, k);
 }
\ No newline at end of file
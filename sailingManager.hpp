@@ -15,6 +15,8 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <vector>
+#include "sailing.hpp"
 using std::endl; 
 using std::cout;
 using std::string;
@@ -33,7 +35,7 @@ char* getVessel();
 // as an int value
 // Throws an exception if vessel does not exist
 //----------------------------------------------------------------
-int getVesselLength(char vesselName[]); 
+int getVesselLength(const char vesselName[]); 
 
 // Function sailingManagerExists checks if a sailing with the provided 
 // sailing ID exists.
@@ -52,6 +54,25 @@ void accessReservationManager(char sailingID[]);
 //----------------------------------------------------------------
 void createSailing(char vesselName[]); 
 
+// Function createSailing with a sailingID creates the sailing on a vessel
+// without prompting
+// Throws an exception if the ID is invalid or already exists, or the
+// vessel does not exist
+//----------------------------------------------------------------
+void createSailing(char sailingID[], char vesselName[]);
+
+// Function createSailingsFromTimetable creates a batch of sailings from a
+// timetable template file. Each non-blank line that does not start with #
+// has the form: terminal days hours vesselName
+// where days and hours are 2 digit lists and/or ranges, e.g.
+//   ABC 01-07 06,09,12-14 QUEEN_OF_SURREY
+// Every line must be valid and every generated sailing ID unique (in the
+// batch and in the Sailing file), otherwise nothing is written.
+// Returns the number of sailings created
+// Throws an exception if the file cannot be read or the timetable is invalid
+//----------------------------------------------------------------
+int createSailingsFromTimetable(char fileName[]);
+
 // Function updateSailing updates the total space available on a sailing
 // vehicleLen is the length of the vehicle being added/removed, measured in meters
 // Throws an exception if space on sailing cannot be added to/subtracted from,
@@ -66,6 +87,14 @@ void updateSailing(char sailingID[], int vehicleLen);
 //----------------------------------------------------------------
 void checkInReservation(char sailingID[], char vehicleLicence[]); 
 
+// Function checkInWave checks in a boarding wave on one sailing from a
+// queue file of licence plates, one per line, without prompting, and
+// prints the fares to collect and the vehicles processed per minute
+// Returns the number of vehicles checked in
+// Throws an exception if the file cannot be opened
+//----------------------------------------------------------------
+int checkInWave(const char sailingID[], const char fileName[]);
+
 // Function querySailing displays all available sailings,
 // and prompts the user to select a sailing
 // Displays information on the sailing and 
@@ -80,4 +109,24 @@ void removeReservations(char sailingID[]);
 
 // Function printSailingReport sends a sailing report to a printer to be printed
 //----------------------------------------------------------------
-void printSailingReport(char printerName[]);
\ No newline at end of file
+void printSailingReport(char printerName[]);
+
+// Function printDepartureBoard displays the sailings leaving the given
+// terminal on the given day between fromHour and toHour inclusive,
+// in departure order, using the SailingIndex module
+// Throws an exception if the day or hours are out of range
+//----------------------------------------------------------------
+void printDepartureBoard(char terminal[], int day, int fromHour, int toHour);
+
+// Function findAvailableSailings returns the first k sailings leaving the
+// given terminal at or after fromTime (Format: dd-hh) that can fit a vehicle
+// of the given length and height, in departure order.
+// Vehicles that qualify for the low ceiling lane may use either lane,
+// all others need room in the high ceiling lane.
+// Throws an exception if fromTime is not in the dd-hh format
+//----------------------------------------------------------------
+std::vector<Sailing> findAvailableSailings(char terminal[],
+                                           char fromTime[],
+                                           float vehicleLength,
+                                           float vehicleHeight,
+                                           int k);
\ No newline at end of file
@@ -0,0 +1,287 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: stats.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *        - Reported the Bloom filters after the storage I/O table
+ *
+ * Description: Implementation file of the Stats module of the Ferry
+ *              Reservation System. Histograms live in a map keyed by
+ *              function name, so references handed out stay valid and the
+ *              report comes out sorted. Counters are a fixed table indexed
+ *              by storage module and event.
+ *
+ * Design Issues: Bucket index = value below 32, otherwise 16 * shift plus
+ *                the top five bits of the value, where shift brings the
+ *                value into [16, 31]
+ */
+//================================================================
+#include "stats.hpp"
+#include "bloomFilter.hpp"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static std::map<std::string, LatencyHistogram> histograms;
+static long long ioCounters[STORAGEMODULES][IOEVENTS];
+static bool everOpened[STORAGEMODULES]; // first open is not a reopen
+static const char* MODULENAMES[STORAGEMODULES] = {"vessels", "sailings", "vehicles", "reservations"};
+
+//================================================================
+// Helper function highestBit returns the position of the highest set bit
+//----------------------------------------------------------------
+static int highestBit(unsigned long long value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Helper function bucketOf returns the bucket holding a latency
+//----------------------------------------------------------------
+static int bucketOf(long long ns)
+{
+    if (ns < 32)
+    {
+        return ns < 0 ? 0 : static_cast<int>(ns);
+    }
+    int shift = highestBit(static_cast<unsigned long long>(ns)) - 4;
+    return 16 * shift + static_cast<int>(ns >> shift);
+}
+
+// Helper function bucketTop returns the largest latency in a bucket
+//----------------------------------------------------------------
+static long long bucketTop(int bucket)
+{
+    if (bucket < 32)
+    {
+        return bucket;
+    }
+    int shift = bucket / 16 - 1;
+    long long first = static_cast<long long>(bucket % 16 + 16) << shift;
+    return first + (1LL << shift) - 1;
+}
+
+// Helper function microseconds formats nanoseconds as microseconds
+//----------------------------------------------------------------
+static std::string microseconds(long long ns)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", ns / 1000.0);
+    return text;
+}
+
+//================================================================
+// Function latencyHistogram returns the histogram with the given name
+//----------------------------------------------------------------
+LatencyHistogram& latencyHistogram(const char name[])
+{
+    std::map<std::string, LatencyHistogram>::iterator it = histograms.find(name);
+    if (it == histograms.end())
+    {
+        it = histograms.insert(std::make_pair(std::string(name), LatencyHistogram())).first;
+        it->second.name = it->first.c_str();
+    }
+    return it->second;
+}
+
+// Function recordLatency adds one call of the given duration
+//----------------------------------------------------------------
+void recordLatency(LatencyHistogram& histogram, long long ns)
+{
+    histogram.counts[bucketOf(ns)]++;
+    histogram.calls++;
+    histogram.totalNs += ns;
+    if (ns > histogram.maxNs)
+    {
+        histogram.maxNs = ns;
+    }
+}
+
+// Function latencyPercentile returns the latency below which the given
+// fraction of calls fall
+//----------------------------------------------------------------
+long long latencyPercentile(const LatencyHistogram& histogram, double fraction)
+{
+    long long wanted = static_cast<long long>(fraction * histogram.calls + 0.5);
+    if (wanted < 1)
+    {
+        wanted = 1;
+    }
+    long long seen = 0;
+    for (int bucket = 0; bucket < LATENCYBUCKETS; ++bucket)
+    {
+        seen += histogram.counts[bucket];
+        if (seen >= wanted)
+        {
+            long long top = bucketTop(bucket);
+            return top < histogram.maxNs ? top : histogram.maxNs;
+        }
+    }
+    return histogram.maxNs;
+}
+
+// Function latencyCountAtMost returns the number of calls that took at
+// most ns nanoseconds, counting whole buckets
+//----------------------------------------------------------------
+long long latencyCountAtMost(const LatencyHistogram& histogram, long long ns)
+{
+    long long count = 0;
+    for (int bucket = 0; bucket < LATENCYBUCKETS && bucketTop(bucket) <= ns; ++bucket)
+    {
+        count += histogram.counts[bucket];
+    }
+    return count;
+}
+
+// Function latencyHistograms returns every histogram, sorted by name
+//----------------------------------------------------------------
+std::vector<const LatencyHistogram*> latencyHistograms()
+{
+    std::vector<const LatencyHistogram*> all;
+    for (const std::pair<const std::string, LatencyHistogram>& entry : histograms)
+    {
+        all.push_back(&entry.second);
+    }
+    return all;
+}
+
+// Function countIo adds count events of one kind to a storage module
+//----------------------------------------------------------------
+void countIo(StorageModule module, IoEvent event, long long count)
+{
+    if (event == fileOpen && !everOpened[module])
+    {
+        everOpened[module] = true;
+        count--;
+    }
+    ioCounters[module][event] += count;
+}
+
+// Function ioCount returns the number of events of one kind so far
+//----------------------------------------------------------------
+long long ioCount(StorageModule module, IoEvent event)
+{
+    return ioCounters[module][event];
+}
+
+// Function storageModuleName returns the name used for a module in reports
+//----------------------------------------------------------------
+const char* storageModuleName(StorageModule module)
+{
+    return MODULENAMES[module];
+}
+
+// Function writeStats writes every histogram and the I/O counters
+//----------------------------------------------------------------
+void writeStats(std::ostream& out)
+{
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    std::ios::fmtflags flags = out.flags();
+    out << "Ferry Reservation System statistics, " << date << "\n\n";
+
+    out << "Function latency (us)\n" << std::left << std::setw(34) << "Function" << std::right
+        << std::setw(10) << "Calls" << std::setw(11) << "Mean" << std::setw(11) << "p50"
+        << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "p99.9"
+        << std::setw(11) << "Max" << "\n";
+    for (const std::pair<const std::string, LatencyHistogram>& entry : histograms)
+    {
+        const LatencyHistogram& h = entry.second;
+        if (h.calls == 0)
+        {
+            continue;
+        }
+        out << std::left << std::setw(34) << h.name << std::right
+            << std::setw(10) << h.calls
+            << std::setw(11) << microseconds(h.totalNs / h.calls)
+            << std::setw(11) << microseconds(latencyPercentile(h, 0.50))
+            << std::setw(11) << microseconds(latencyPercentile(h, 0.90))
+            << std::setw(11) << microseconds(latencyPercentile(h, 0.99))
+            << std::setw(11) << microseconds(latencyPercentile(h, 0.999))
+            << std::setw(11) << microseconds(h.maxNs) << "\n";
+    }
+
+    out << "\nStorage I/O\n" << std::left << std::setw(14) << "Module" << std::right
+        << std::setw(14) << "Read" << std::setw(14) << "Written" << std::setw(12) << "Seeks"
+        << std::setw(12) << "Flushes" << std::setw(11) << "Truncates" << std::setw(9) << "Reopens" << "\n";
+    for (int m = 0; m < STORAGEMODULES; ++m)
+    {
+        out << std::left << std::setw(14) << MODULENAMES[m] << std::right
+            << std::setw(14) << ioCounters[m][recordRead]
+            << std::setw(14) << ioCounters[m][recordWritten]
+            << std::setw(12) << ioCounters[m][fileSeek]
+            << std::setw(12) << ioCounters[m][fileFlush]
+            << std::setw(11) << ioCounters[m][fileTruncate]
+            << std::setw(9) << ioCounters[m][fileOpen] << "\n";
+    }
+
+    out << "\nBloom filters\n" << std::left << std::setw(14) << "Filter" << std::right
+        << std::setw(10) << "Keys" << std::setw(12) << "Bits" << std::setw(12) << "Queries"
+        << std::setw(12) << "Misses" << std::setw(10) << "FP %" << std::setw(12) << "Expected %" << "\n";
+    for (const BloomFilter* f : bloomFilters())
+    {
+        out << std::left << std::setw(14) << f->name() << std::right
+            << std::setw(10) << f->keys()
+            << std::setw(12) << f->bits()
+            << std::setw(12) << f->queries()
+            << std::setw(12) << f->definiteMisses()
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << f->observedFalsePositiveRate() * 100
+            << std::setw(12) << f->expectedFalsePositiveRate() * 100 << "\n";
+    }
+    out.flags(flags);
+}
+
+// Function writeStatsFile writes the report of writeStats to a file
+//----------------------------------------------------------------
+void writeStatsFile(const char fileName[])
+{
+    std::ofstream out(fileName);
+    if (!out)
+    {
+        throw std::runtime_error(std::string("Cannot write ") + fileName);
+    }
+    writeStats(out);
+    if (!out)
+    {
+        throw std::runtime_error(std::string("Error writing ") + fileName);
+    }
+}
+
+// Function resetStats clears all histograms and counters
+//----------------------------------------------------------------
+void resetStats()
+{
+    for (std::pair<const std::string, LatencyHistogram>& entry : histograms)
+    {
+        const char* name = entry.second.name;
+        entry.second = LatencyHistogram();
+        entry.second.name = name;
+    }
+    for (int m = 0; m < STORAGEMODULES; ++m)
+    {
+        for (int e = 0; e < IOEVENTS; ++e)
+        {
+            ioCounters[m][e] = 0;
+        }
+    }
+}
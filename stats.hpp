@@ -0,0 +1,142 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: stats.hpp
+ *
+ * Description: Header file of the Stats module of the Ferry Reservation
+ *              System. Keeps a latency histogram for every public storage
+ *              and manager function and I/O counters for every storage
+ *              module, and writes them out as a text report.
+ *
+ * Design Issues: Histograms are log-linear (HDR style): 16 buckets per
+ *                power of two, so any latency is kept within about 6%
+ *                with a fixed 8KB table and no allocation per call
+ *                Per-record reads (getNextSailing etc.) are counted but
+ *                not timed, since timing them would double scan costs
+ *                Not thread safe; the system is single threaded
+ */
+//================================================================
+#pragma once
+#include "trace.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+//================================================================
+// Constants
+//----------------------------------------------------------------
+const int LATENCYBUCKETS = 1024; // covers 0 ns to beyond 2^62 ns
+const char STATSFILENAME[] = "stats.txt"; // written by the statistics menu option
+
+//================================================================
+// Enum: StorageModule
+// Purpose: Storage module an I/O counter belongs to
+//----------------------------------------------------------------
+enum StorageModule {vesselStorage, sailingStorage, vehicleStorage, reservationStorage, STORAGEMODULES};
+
+// Enum: IoEvent
+// Purpose: Kind of I/O being counted
+//----------------------------------------------------------------
+enum IoEvent {recordRead, recordWritten, fileSeek, fileFlush, fileTruncate, fileOpen, IOEVENTS};
+
+// Struct: LatencyHistogram
+// Purpose: Latency distribution of one function, in nanoseconds
+//----------------------------------------------------------------
+struct LatencyHistogram
+{
+    const char* name; // function being timed
+    long long counts[LATENCYBUCKETS]; // calls per bucket
+    long long calls; // total calls
+    long long totalNs; // sum of latencies
+    long long maxNs; // slowest call
+};
+
+//================================================================
+// Function latencyHistogram returns the histogram with the given name,
+// creating it on first use. The reference stays valid for the whole run.
+//----------------------------------------------------------------
+LatencyHistogram& latencyHistogram(const char name[]);
+
+// Function recordLatency adds one call of the given duration
+//----------------------------------------------------------------
+void recordLatency(LatencyHistogram& histogram, long long ns);
+
+// Function latencyPercentile returns the latency (ns) below which the
+// given fraction (0 to 1) of calls fall, to within one bucket
+//----------------------------------------------------------------
+long long latencyPercentile(const LatencyHistogram& histogram, double fraction);
+
+// Function latencyCountAtMost returns the number of calls that took at
+// most ns nanoseconds, to within one bucket
+//----------------------------------------------------------------
+long long latencyCountAtMost(const LatencyHistogram& histogram, long long ns);
+
+// Function latencyHistograms returns every histogram, sorted by name
+//----------------------------------------------------------------
+std::vector<const LatencyHistogram*> latencyHistograms();
+
+// Function countIo adds count events of one kind to a storage module.
+// The first fileOpen of a module is not counted, so the fileOpen counter
+// holds the number of reopens.
+//----------------------------------------------------------------
+void countIo(StorageModule module, IoEvent event, long long count = 1);
+
+// Function ioCount returns the number of events of one kind so far
+//----------------------------------------------------------------
+long long ioCount(StorageModule module, IoEvent event);
+
+// Function storageModuleName returns the name used for a module in reports
+//----------------------------------------------------------------
+const char* storageModuleName(StorageModule module);
+
+// Function writeStats writes every histogram that has calls (calls, mean,
+// p50, p90, p99, p99.9 and max in microseconds) and the I/O counters of
+// every storage module
+//----------------------------------------------------------------
+void writeStats(std::ostream& out);
+
+// Function writeStatsFile writes the report of writeStats to a file
+// Throws an exception if the file cannot be written
+//----------------------------------------------------------------
+void writeStatsFile(const char fileName[]);
+
+// Function resetStats clears all histograms and counters
+//----------------------------------------------------------------
+void resetStats();
+
+//================================================================
+// Class: ScopedLatency
+// Purpose: Records the time from construction to destruction,
+// including when the function exits with an exception, and writes it as
+// a trace event while tracing is on
+//----------------------------------------------------------------
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedLatency()
+    {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        recordLatency(histogram, ns);
+        if (traceEnabled())
+        {
+            traceSpan(histogram.name, start, ns);
+        }
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Times the rest of the enclosing function under the given name; the
+// histogram is looked up once per function
+#define TIME_FUNCTION(name) \
+    static LatencyHistogram& functionHistogram = latencyHistogram(name); \
+    ScopedLatency functionTimer(functionHistogram)
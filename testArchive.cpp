@@ -0,0 +1,224 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: testArchive.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Unit Test: Archive codec, block format and reruns
+* Round trips byte strings through archiveCompress and
+* archiveDecompress, archives sailings with licences that share
+* prefixes and reads them back, then archives a sailing a second time
+* with none of its reservations, as a run cut short between rewriting
+* reservations.dat and sailings.dat would, and checks nothing is lost.
+*
+* Test Type: Bottom-up integration
+* Preconditions:
+* - The Sailing and Reservation files are not used by another module
+* - The files may or may not already exist; they are emptied
+* Test Steps:
+* 1. Compress and decompress empty, short, repetitive and mixed bytes
+*    and compare; check a truncated body is refused
+* 2. Write 3 sailings and their reservations, archive the 2 that
+*    departed before day 02 hour 00 and compare readArchive() with them
+* 3. Check the data files keep only the later sailing and its booking
+* 4. Write one archived sailing back without reservations, archive
+*    again and check its reservations are still in the archive
+* 5. Print "Pass" or "Fail"
+*/
+//============================================================
+
+#include "archive.hpp"
+#include "sailing.hpp"
+#include "reservation.hpp"
+#include "reservationScan.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//============================================================
+// Constants
+//------------------------------------------------------------
+static const char PERIOD[] = "unittest";
+
+//============================================================
+// Helper function roundTrips compresses and decompresses bytes and
+// returns true if they come back unchanged
+//------------------------------------------------------------
+static bool roundTrips(const std::vector<unsigned char>& bytes, const char name[])
+{
+    std::vector<unsigned char> stored = archiveCompress(bytes);
+    std::vector<unsigned char> back = archiveDecompress(stored.data(), stored.size(), bytes.size());
+    std::cout << "  " << name << ": " << bytes.size() << " bytes stored in " << stored.size() << "\n";
+    return back == bytes;
+}
+
+// Helper function makeSailing fills in a sailing record
+//------------------------------------------------------------
+static Sailing makeSailing(const char id[], float low)
+{
+    Sailing s = {};
+    std::memcpy(s.sailingID, id, strnlen(id, sizeof(s.sailingID) - 1));
+    std::memcpy(s.vesselName, "Spirit of Sooke", std::strlen("Spirit of Sooke"));
+    s.lowRemainingLength = low;
+    s.highRemainingLength = 40.5f;
+    return s;
+}
+
+// Helper function makeReservation fills in a reservation record
+//------------------------------------------------------------
+static Reservation makeReservation(const char id[], const char licence[], bool onBoard, bool isLRL)
+{
+    Reservation r = {};
+    std::memcpy(r.sailingID, id, strnlen(id, sizeof(r.sailingID) - 1));
+    std::memcpy(r.vehicleLicence, licence, strnlen(licence, sizeof(r.vehicleLicence) - 1));
+    r.onBoard = onBoard;
+    r.isLRL = isLRL;
+    return r;
+}
+
+// Helper function sameReservations compares two lists record by record
+//------------------------------------------------------------
+static bool sameReservations(const std::vector<Reservation>& a, const std::vector<Reservation>& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        if (std::memcmp(&a[i], &b[i], sizeof(Reservation)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//============================================================
+// Function main runs the codec, archive and rerun checks
+//------------------------------------------------------------
+int main()
+{
+    bool pass = true;
+
+    try
+    {
+        std::cout << "Codec round trips:\n";
+        std::vector<unsigned char> mixed;
+        for (int i = 0; i < 5000; ++i)
+        {
+            // Runs, repeats further back than the last match and noise
+            mixed.push_back(static_cast<unsigned char>(i % 7 == 0 ? (i * 131) % 251 : 'A' + (i / 40) % 3));
+        }
+        std::vector<unsigned char> noise;
+        unsigned int seed = 12345;
+        for (int i = 0; i < 300; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            noise.push_back(static_cast<unsigned char>(seed >> 16));
+        }
+        if (!roundTrips(std::vector<unsigned char>(), "empty") ||
+            !roundTrips(std::vector<unsigned char>{'a', 'b', 'c'}, "short") ||
+            !roundTrips(std::vector<unsigned char>(1000, 'x'), "one byte repeated") ||
+            !roundTrips(noise, "noise") || !roundTrips(mixed, "mixed"))
+        {
+            std::cout << "Codec round trip is not correct\n";
+            pass = false;
+        }
+        std::vector<unsigned char> stored = archiveCompress(mixed);
+        try
+        {
+            archiveDecompress(stored.data(), stored.size() - 1, mixed.size());
+            std::cout << "Truncated body was accepted\n";
+            pass = false;
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+
+        // Start from empty files and no archive
+        std::remove(archiveFileName(PERIOD).c_str());
+        sailingOpen();
+        reservationOpen();
+        rewriteSailings(nullptr, 0);
+        rewriteReservations(nullptr, 0);
+
+        std::cout << "Archive of day 01:\n";
+        Sailing early = makeSailing("ABC-01-08", 12.25f);
+        Sailing late = makeSailing("ABC-01-23", 0.5f);
+        Sailing kept = makeSailing("ABC-02-08", 100.0f);
+        writeSailing(kept);
+        writeSailing(late);
+        writeSailing(early);
+        std::vector<Reservation> earlyBookings = {makeReservation("ABC-01-08", "CAR1", true, true),
+                                                  makeReservation("ABC-01-08", "CAR10", false, true),
+                                                  makeReservation("ABC-01-08", "CAR100", true, false),
+                                                  makeReservation("ABC-01-08", "TRUCK7", false, false)};
+        std::vector<Reservation> lateBookings = {makeReservation("ABC-01-23", "CAR1", false, true)};
+        // Written out of licence order; the archive sorts them
+        writeReservation(earlyBookings[3], false);
+        writeReservation(makeReservation("ABC-02-08", "CAR1", false, true), false);
+        writeReservation(earlyBookings[1], false);
+        writeReservation(lateBookings[0], false);
+        writeReservation(earlyBookings[0], false);
+        writeReservation(earlyBookings[2], false);
+
+        ArchiveSummary summary = archiveDepartedSailings(2, 0, PERIOD);
+        std::vector<ArchivedSailing> archived = readArchive(PERIOD);
+        if (summary.sailings != 2 || summary.reservations != 5 || archived.size() != 2 ||
+            std::memcmp(&archived[0].sailing, &early, sizeof(Sailing)) != 0 ||
+            std::memcmp(&archived[1].sailing, &late, sizeof(Sailing)) != 0 ||
+            !sameReservations(archived[0].reservations, earlyBookings) ||
+            !sameReservations(archived[1].reservations, lateBookings))
+        {
+            std::cout << "Archive read back is not correct\n";
+            pass = false;
+        }
+        if (sailingSnapshot().records().size() != 1 || countReservations(sailingQuery("ABC-02-08")) != 1 ||
+            reservationSnapshot().records().size() != 1)
+        {
+            std::cout << "Data files after archiving are not correct\n";
+            pass = false;
+        }
+
+        std::cout << "Rerun after a crash between the rewrites:\n";
+        writeSailing(early);
+        summary = archiveDepartedSailings(2, 0, PERIOD);
+        ArchivedSailing found;
+        if (summary.sailings != 1 || summary.reservations != 0 ||
+            !findArchivedSailing(PERIOD, "ABC-01-08", found) ||
+            !sameReservations(found.reservations, earlyBookings))
+        {
+            std::cout << "Rerun lost archived reservations\n";
+            pass = false;
+        }
+        reservationClose();
+        sailingClose();
+        std::remove(archiveFileName(PERIOD).c_str());
+    }
+    // Print out errors with reading/writing binary file data
+    catch (const std::exception& e)
+    {
+        std::cout << "Problem with test: " << e.what();
+        return 1;
+    }
+
+    // Check if the test passed
+    if (pass)
+    {
+        std::cout << "Pass" << '\n';
+    }
+    else
+    {
+        std::cout << "Fail" << '\n';
+    }
+
+    std::cout << "---Archive Complete---";
+    return 0;
+}
@@ -0,0 +1,161 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: testReservationScan.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Unit Test: Compiled reservation queries
+* Builds reservations in memory, some with bytes left after the
+* terminator of a field, then checks that every combination of query
+* conditions gives the same count, first match and positions as the
+* same conditions written with strncmp.
+*
+* Test Type: Unit
+* Preconditions:
+* - None; no data file is used
+* Test Steps:
+* 1. Build 1000 reservations over 4 sailings and 50 licences
+* 2. For each sailing, licence and flag combination, compile a
+*    ReservationScan and compare count(), find() and collect() with a
+*    strncmp loop
+* 3. Check that a licence longer than its field is refused
+* 4. Print "Pass" or "Fail"
+*/
+//============================================================
+
+#include "reservationScan.hpp"
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//============================================================
+// Helper function makeReservation fills in a reservation; leftover
+// puts a stray byte after the terminator of the sailing ID
+//------------------------------------------------------------
+static Reservation makeReservation(const char sailingID[], const char licence[], bool onBoard, bool isLRL, bool leftover)
+{
+    Reservation r = {};
+    std::memcpy(r.sailingID, sailingID, strnlen(sailingID, sizeof(r.sailingID) - 1));
+    std::memcpy(r.vehicleLicence, licence, strnlen(licence, sizeof(r.vehicleLicence) - 1));
+    r.onBoard = onBoard;
+    r.isLRL = isLRL;
+    if (leftover && std::strlen(sailingID) + 1 < sizeof(r.sailingID))
+    {
+        r.sailingID[sizeof(r.sailingID) - 1] = 'X';
+    }
+    return r;
+}
+
+// Helper function flagMatches applies a FlagMatch to a bool
+//------------------------------------------------------------
+static bool flagMatches(FlagMatch match, bool value)
+{
+    return match == anyFlag || (match == flagSet) == value;
+}
+
+// Helper function expected is the query written with strncmp
+//------------------------------------------------------------
+static bool expected(const ReservationQuery& q, const Reservation& r)
+{
+    return (q.sailingID == nullptr || q.sailingID[0] == '\0' ||
+            std::strncmp(r.sailingID, q.sailingID, sizeof(r.sailingID)) == 0) &&
+           (q.vehicleLicence == nullptr || q.vehicleLicence[0] == '\0' ||
+            std::strncmp(r.vehicleLicence, q.vehicleLicence, sizeof(r.vehicleLicence)) == 0) &&
+           flagMatches(q.onBoard, r.onBoard) && flagMatches(q.isLRL, r.isLRL);
+}
+
+//============================================================
+// Function main compares compiled queries with strncmp loops
+//------------------------------------------------------------
+int main()
+{
+    bool pass = true;
+
+    try
+    {
+        const char* sailings[] = {"ABC-05-08", "ABC-05-0", "XYZ-12-23", "Q"};
+        std::vector<std::string> licences;
+        for (int i = 0; i < 50; ++i)
+        {
+            licences.push_back(i % 10 == 9 ? "LONGPLATE" + std::to_string(i % 10) : "P" + std::to_string(i));
+        }
+        std::vector<Reservation> records;
+        for (int i = 0; i < 1000; ++i)
+        {
+            records.push_back(makeReservation(sailings[i % 4], licences[(i * 7) % 50].c_str(),
+                                              i % 3 == 0, i % 5 < 2, i % 11 == 0));
+        }
+        RecordView<Reservation> view(records.data(), records.size());
+
+        const char* sailingChoices[] = {nullptr, "ABC-05-08", "ABC-05-0", "Q", "NONE"};
+        const char* licenceChoices[] = {nullptr, "P7", "LONGPLATE9", "P70"};
+        const FlagMatch flags[] = {anyFlag, flagSet, flagClear};
+        int queries = 0;
+        for (const char* sailingID : sailingChoices)
+        {
+            for (const char* licence : licenceChoices)
+            {
+                for (FlagMatch onBoard : flags)
+                {
+                    for (FlagMatch isLRL : flags)
+                    {
+                        ReservationQuery query = {sailingID, licence, onBoard, isLRL};
+                        ReservationScan scan(query);
+                        std::vector<std::size_t> want;
+                        for (std::size_t i = 0; i < records.size(); ++i)
+                        {
+                            if (expected(query, records[i]))
+                            {
+                                want.push_back(i);
+                            }
+                        }
+                        std::size_t first = want.empty() ? records.size() : want[0];
+                        if (scan.count(view) != want.size() || scan.find(view) != first || scan.collect(view) != want)
+                        {
+                            std::cout << "Query " << (sailingID ? sailingID : "*") << " " << (licence ? licence : "*")
+                                      << " " << onBoard << " " << isLRL << " is not correct\n";
+                            pass = false;
+                        }
+                        queries++;
+                    }
+                }
+            }
+        }
+        std::cout << queries << " queries compared\n";
+
+        try
+        {
+            ReservationQuery tooLong = {nullptr, "TWELVECHARSX", anyFlag, anyFlag};
+            ReservationScan scan(tooLong);
+            std::cout << "Overlong licence was accepted\n";
+            pass = false;
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+    }
+    // Print out errors from the scan
+    catch (const std::exception& e)
+    {
+        std::cout << "Problem with test: " << e.what();
+        return 1;
+    }
+
+    // Check if the test passed
+    if (pass)
+    {
+        std::cout << "Pass" << '\n';
+    }
+    else
+    {
+        std::cout << "Fail" << '\n';
+    }
+
+    std::cout << "---Reservation Scan Complete---";
+    return 0;
+}
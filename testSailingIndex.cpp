@@ -0,0 +1,158 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//============================================================
+//============================================================
+/*
+* Filename: testSailingIndex.cpp
+*
+* Revision History:
+* Rev. 1 - 26/10/18 Original by L. Xu
+*
+* Unit Test: Sailing index range and capacity queries
+* Writes sailings out of departure order, then checks that a
+* terminal/day/hour range returns exactly the matching sailings in
+* departure order, and that the index follows deleteSailing().
+*
+* Test Type: Bottom-up integration
+* Preconditions:
+* - The Sailing file is not used by another module
+* - The file may or may not already exist
+* - If the file alreaady exists, it must be empty
+* Test Steps:
+* 1. Call sailingOpen()
+* 2. Write 5 sailings with writeSailing() in mixed order
+* 3. Query ABC day 05 hours 08-12 with sailingIndexRange()
+* 4. Compare the returned IDs to the expected order
+* 5. Delete one sailing and check the range shrinks
+* 6. Close and reopen the file and check the index is rebuilt
+* 7. Fill one sailing and check sailingIndexFindAvailable() skips it
+* 8. Print "Pass" or "Fail"
+*/
+//============================================================
+
+#include "sailing.hpp"
+#include "sailingIndex.hpp"
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+//============================================================
+// Helper function makeSailing fills in a sailing record
+//------------------------------------------------------------
+static Sailing makeSailing(const char id[])
+{
+    Sailing s = {};
+    std::strncpy(s.sailingID, id, sizeof(s.sailingID) - 1);
+    std::strncpy(s.vesselName, "TESTVESSEL", sizeof(s.vesselName) - 1);
+    s.lowRemainingLength = 100.0f;
+    s.highRemainingLength = 50.0f;
+    return s;
+}
+
+// Helper function rangeMatches compares a range to the expected IDs
+//------------------------------------------------------------
+static bool rangeMatches(const SailingRange& range, const char* expected[], int count)
+{
+    int i = 0;
+    for (const Sailing& s : range)
+    {
+        std::cout << "  " << s.sailingID << "\n";
+        if (i >= count || std::strcmp(s.sailingID, expected[i]) != 0)
+        {
+            return false;
+        }
+        i++;
+    }
+    return i == count;
+}
+
+//============================================================
+// Function main writes sailings and checks the range queries
+//------------------------------------------------------------
+int main()
+{
+    bool pass = true;
+
+    try
+    {
+        sailingOpen();
+        writeSailing(makeSailing("ABC-05-12"));
+        writeSailing(makeSailing("XYZ-05-09"));
+        writeSailing(makeSailing("ABC-05-08"));
+        writeSailing(makeSailing("ABC-06-09"));
+        writeSailing(makeSailing("ABC-05-10"));
+
+        std::cout << "Range ABC day 05 hours 08-12:\n";
+        const char* expected[] = {"ABC-05-08", "ABC-05-10", "ABC-05-12"};
+        if (!rangeMatches(sailingIndexRange("ABC", 5, 8, 12), expected, 3))
+        {
+            std::cout << "Range query is not correct\n";
+            pass = false;
+        }
+
+        std::cout << "Range after deleting ABC-05-10:\n";
+        deleteSailing("ABC-05-10");
+        const char* afterDelete[] = {"ABC-05-08", "ABC-05-12"};
+        if (!rangeMatches(sailingIndexRange("ABC", 5, 8, 12), afterDelete, 2))
+        {
+            std::cout << "Range query after delete is not correct\n";
+            pass = false;
+        }
+
+        std::cout << "Terminal ABC after reopening:\n";
+        sailingClose();
+        sailingOpen();
+        const char* terminal[] = {"ABC-05-08", "ABC-05-12", "ABC-06-09"};
+        if (!rangeMatches(sailingIndexTerminal("ABC"), terminal, 3))
+        {
+            std::cout << "Rebuilt index is not correct\n";
+            pass = false;
+        }
+        if (sailingIndexFind("XYZ-05-09") == nullptr)
+        {
+            std::cout << "XYZ-05-09 missing from index\n";
+            pass = false;
+        }
+
+        std::cout << "Sailings from ABC day 05 hour 09 with 60m high lane:\n";
+        Sailing big = makeSailing("ABC-06-09");
+        big.highRemainingLength = 60.0f;
+        deleteSailing("ABC-06-09");
+        writeSailing(big);
+        std::vector<Sailing> found = sailingIndexFindAvailable("ABC", 5, 9, 55.0f, true, 3);
+        for (const Sailing& s : found)
+        {
+            std::cout << "  " << s.sailingID << "\n";
+        }
+        if (found.size() != 1 || std::strcmp(found[0].sailingID, "ABC-06-09") != 0)
+        {
+            std::cout << "Capacity search is not correct\n";
+            pass = false;
+        }
+        found = sailingIndexFindAvailable("ABC", 5, 9, 80.0f, false, 1);
+        if (found.size() != 1 || std::strcmp(found[0].sailingID, "ABC-05-12") != 0)
+        {
+            std::cout << "Capacity search using either lane is not correct\n";
+            pass = false;
+        }
+        sailingClose();
+    }
+    // Print out errors with reading/writing binary file data
+    catch (const std::exception& e)
+    {
+        std::cout << "Problem with test: " << e.what();
+        return 1;
+    }
+
+    // Check if the test passed
+    if (pass)
+    {
+        std::cout << "Pass" << '\n';
+    }
+    else
+    {
+        std::cout << "Fail" << '\n';
+    }
+
+    std::cout << "---Sailing Index Complete---";
+    return 0;
+}
@@ -0,0 +1,100 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: trace.cpp
+ *
+ * Revision History:
+ * Rev. 1 - 26/10/18 Original by L. Xu
+ *
+ * Description: Implementation file of the Trace module of the Ferry
+ *              Reservation System. Events are complete ("X") events with
+ *              microsecond timestamps from the start of the trace, written
+ *              through a 1MB stdio buffer.
+ */
+//================================================================
+#include "trace.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//============================================================
+// Module scope static variables
+//------------------------------------------------------------
+static const std::size_t TRACEBUFFERSIZE = 1 << 20;
+static std::FILE* traceFile = nullptr;
+static std::vector<char> traceBuffer;
+static std::chrono::steady_clock::time_point traceOrigin;
+
+//================================================================
+// Helper function putEscaped writes a string as JSON string contents
+//----------------------------------------------------------------
+static void putEscaped(const char text[])
+{
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            std::fputc('\\', traceFile);
+            std::fputc(*c, traceFile);
+        }
+        else if (static_cast<unsigned char>(*c) >= 0x20)
+        {
+            std::fputc(*c, traceFile);
+        }
+    }
+}
+
+//================================================================
+// Function traceStart starts writing trace events to the given file
+//----------------------------------------------------------------
+void traceStart(const char fileName[])
+{
+    traceStop();
+    traceFile = std::fopen(fileName, "w");
+    if (traceFile == nullptr)
+    {
+        throw std::runtime_error(std::string("Cannot create trace file ") + fileName);
+    }
+    traceBuffer.resize(TRACEBUFFERSIZE);
+    std::setvbuf(traceFile, traceBuffer.data(), _IOFBF, traceBuffer.size());
+    traceOrigin = std::chrono::steady_clock::now();
+    std::fputs("[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+               "\"args\":{\"name\":\"Ferry Reservation System\"}}", traceFile);
+}
+
+// Function traceStop finishes and closes the trace file
+//----------------------------------------------------------------
+void traceStop()
+{
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+    std::fputs("\n]\n", traceFile);
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
+
+// Function traceEnabled returns true while tracing is on
+//----------------------------------------------------------------
+bool traceEnabled()
+{
+    return traceFile != nullptr;
+}
+
+// Function traceSpan writes one complete event
+//----------------------------------------------------------------
+void traceSpan(const char name[], std::chrono::steady_clock::time_point start, long long durationNs)
+{
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+    double ts = std::chrono::duration<double, std::micro>(start - traceOrigin).count();
+    std::fputs(",\n{\"name\":\"", traceFile);
+    putEscaped(name);
+    std::fprintf(traceFile, "\",\"cat\":\"ferry\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                 ts, durationNs / 1000.0);
+}
@@ -0,0 +1,75 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//================================================================
+//================================================================
+/*
+ * Filename: trace.hpp
+ *
+ * Description: Header file of the Trace module of the Ferry Reservation
+ *              System. While tracing is on, every timed function (see
+ *              TIME_FUNCTION in stats.hpp) and every TRACE_SPAN is written
+ *              as a Chrome trace event, so the nested calls of one
+ *              operation can be viewed in chrome://tracing or Perfetto.
+ *
+ * Design Issues: Events use the JSON array format and are buffered 1 MB at
+ *                a time; a crash loses the events still in the buffer
+ *                Tracing is off by default and costs one check per span
+ *                when off
+ */
+//================================================================
+#pragma once
+#include <chrono>
+
+//================================================================
+// Function traceStart starts writing trace events to the given file,
+// stopping any trace already running
+// Throws an exception if the file cannot be created
+//----------------------------------------------------------------
+void traceStart(const char fileName[]);
+
+// Function traceStop finishes and closes the trace file, if tracing is on
+//----------------------------------------------------------------
+void traceStop();
+
+// Function traceEnabled returns true while tracing is on
+//----------------------------------------------------------------
+bool traceEnabled();
+
+// Function traceSpan writes one complete event that started at start and
+// lasted durationNs nanoseconds
+//----------------------------------------------------------------
+void traceSpan(const char name[], std::chrono::steady_clock::time_point start, long long durationNs);
+
+//================================================================
+// Class: TraceSpan
+// Purpose: Writes a trace event from construction to destruction, for
+// code that is traced but not timed in the Stats module
+//----------------------------------------------------------------
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char name[])
+        : name(name), active(traceEnabled())
+    {
+        if (active)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceSpan()
+    {
+        if (active)
+        {
+            traceSpan(name, start, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+private:
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Traces the rest of the enclosing block under the given name
+#define TRACE_SPAN(name) TraceSpan traceSpanHere(name)
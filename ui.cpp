@@ -6,6 +6,39 @@
  * Filename: ui.cpp
  * 
  * Revision History: 
+ * Rev. 2 - 26/10/18 Modified by L. Xu
+ *        - Added the departure board option to the sailing menu
+ *        - Added the find available sailings option to the reservation menu
+ *        - Added the create sailings from timetable option to the sailing menu
+ *        - Added the CSV import option to the main menu
+ *        - Added the export option to the sailing menu
+ *        - Added runScript for headless command scripts
+ *        - Added the statistics option to the main menu and the stats
+ *          script command
+ *        - Added trace spans, the tracing option to the main menu and the
+ *          trace script command
+ *        - Metrics are written between menu inputs and script commands;
+ *          added the metrics script command
+ *        - Added the reserve-batch script command
+ *        - Each script command runs in one RequestArena scope; the
+ *          argument count table is built once
+ *        - Added the archive option to the sailing menu and the archive
+ *          and archive-query script commands
+ *        - Added the snapshot and restore script commands
+ *        - Each script command, and each change a menu action makes once
+ *          its prompts are answered, holds the DataWriteLock
+ *        - Each of those is one ShippedRequest;
+ *          added the replicate and replication-status script commands
+ *        - Added the batch check in option to the sailing menu and the
+ *          checkin-batch script command
+ *        - Script numbers must be whole arguments; vessel lane lengths
+ *          are range checked
+ *        - available and board read their numbers with parseNumber and
+ *          parseWholeNumber
+ *        - restore reads the snapshot number with parseWholeNumber
+ *        - archive reads its day and hour with parseWholeNumber
+ *        - reserve-batch reports unreadable lines by line number
+ *        - The metrics script command replaces its file by rename
  * Rev. 1 - 25/07/21 Original by A. Kong
  *
  * Description: UI of the Ferry Reservation System,
@@ -19,8 +52,27 @@
 #include <iostream>
 #include "sailing.hpp"
 #include "ui.hpp"
+#include "bulkImport.hpp"
+#include "dataExport.hpp"
+#include "archive.hpp"
+#include "backup.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "requestArena.hpp"
+#include "dataLock.hpp"
+#include "replication.hpp"
 #include <cstring>
 #include <cctype>
+#include <climits>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 // different submenus user can be in, start at main menu
 enum menu{mainMenu, sailingMenu, reservationMenu, exitProgram};
 enum menu currentMenu = mainMenu;
@@ -37,8 +89,21 @@ void reservation()
     return;
 }
 
+// Function storageRequest runs change, which must not prompt, as one
+// request: ferryReport waits for it and the standby applies it whole.
+// Menu actions call it once their prompts are answered, so the lock is
+// never held while the program waits for the user
+template <typename Change>
+static void storageRequest(Change change)
+{
+    DataWriteLock request;
+    ShippedRequest shipped;
+    change();
+}
+
 void createVessel()
 {
+    TRACE_SPAN("createVessel");
     Vessel userVessel;
     std::cout << "Please enter a valid vessel name (max 25 char.)" << std::endl;
     cin >> userVessel.name;
@@ -52,7 +117,7 @@ void createVessel()
     cin >> userVessel.HCLL;
     cin.clear();
     cin.ignore(10000,'\n');
-    writeVessel(userVessel);
+    storageRequest([&] { writeVessel(userVessel); });
 }
 
 // Function takes user input and takes an action
@@ -67,6 +132,7 @@ void processInput()
     char vesselName[26];
     std::cout << "Enter choice: " << std::endl;
     std::cin >> userInput;
+    TRACE_SPAN("processInput");
 
     switch(currentMenu)
     {
@@ -85,8 +151,53 @@ void processInput()
         case 3:
             createVessel();
             break;
-        // exitProgram program
+        // import vehicles or reservations from a CSV file
         case 4:
+        {
+            char importType;
+            char fileName[256];
+            std::cout << "Enter V to import vehicles, R to import reservations" << std::endl;
+            std::cin >> importType;
+            std::cout << "Please enter the CSV file name" << std::endl;
+            std::cin >> std::setw(sizeof(fileName)) >> fileName;
+            if (std::toupper(importType) == 'V')
+            {
+                storageRequest([&] { importVehicles(fileName); });
+            }
+            else if (std::toupper(importType) == 'R')
+            {
+                storageRequest([&] { importReservations(fileName); });
+            }
+            else
+            {
+                std::cout << "Please select a valid option" << std::endl;
+            }
+            break;
+        }
+        // show the latency and I/O statistics and save them to the stats file
+        case 5:
+            writeStats(std::cout);
+            writeStatsFile(STATSFILENAME);
+            std::cout << "Statistics saved to " << STATSFILENAME << std::endl;
+            break;
+        // turn tracing on (to a file) or off
+        case 6:
+            if (traceEnabled())
+            {
+                traceStop();
+                std::cout << "Tracing stopped" << std::endl;
+            }
+            else
+            {
+                char traceName[256];
+                std::cout << "Please enter the trace file name" << std::endl;
+                std::cin >> std::setw(sizeof(traceName)) >> traceName;
+                traceStart(traceName);
+                std::cout << "Tracing to " << traceName << std::endl;
+            }
+            break;
+        // exitProgram program
+        case 7:
             currentMenu = exitProgram;
         // invalid user input
         default:
@@ -210,10 +321,42 @@ void processInput()
             std::cin >> sailingID;
             std::cout << "Please enter the vehicle's licence plate" << std::endl;
             std::cin >> vehicleLicence;
-            deleteReservations(sailingID, vehicleLicence);
+            storageRequest([&] { deleteReservations(sailingID, vehicleLicence); });
             break;
-        // return to main menu
+        // find the next sailings with room for a vehicle
         case 3:
+        {
+            char terminal[4];
+            char fromTime[6];
+            float vehicleLength, vehicleHeight;
+            std::cout << "Please enter the departure terminal (3 letters)" << std::endl;
+            std::cin >> std::setw(sizeof(terminal)) >> terminal;
+            std::cout << "Please enter the earliest departure (Format: dd-hh)" << std::endl;
+            std::cin >> std::setw(sizeof(fromTime)) >> fromTime;
+            std::cout << "Please enter the vehicle length and height in meters" << std::endl;
+            std::cin >> vehicleLength >> vehicleHeight;
+            if (!std::cin)
+            {
+                std::cin.clear();
+                std::cin.ignore(10000, '\n');
+                std::cout << "Please enter numbers for the length and height" << std::endl;
+                break;
+            }
+            std::vector<Sailing> found = findAvailableSailings(terminal, fromTime, vehicleLength, vehicleHeight, 5);
+            if (found.empty())
+            {
+                std::cout << "No sailings with enough space" << std::endl;
+            }
+            for (const Sailing& s : found)
+            {
+                std::cout << s.sailingID << " on " << s.vesselName
+                          << "  LRL=" << s.lowRemainingLength
+                          << "  HRL=" << s.highRemainingLength << std::endl;
+            }
+            break;
+        }
+        // return to main menu
+        case 4:
             currentMenu = mainMenu;
         // invalid user input
         default:
@@ -244,8 +387,11 @@ void processInput()
             break;
         // delete sailing
         case 4:
-            removeReservations(querySailing());
+        {
+            char* chosen = querySailing();
+            storageRequest([&] { removeReservations(chosen); });
             break;
+        }
         // print sailing report
         case 5:
             cout << "Please enter the name"
@@ -253,8 +399,107 @@ void processInput()
             cin >> printerName;
             printSailingReport(printerName);
             break;
-        // return to main menu
+        // departure board for a terminal and day
         case 6:
+        {
+            char terminal[4];
+            int day, fromHour, toHour;
+            std::cout << "Please enter the departure terminal (3 letters)" << std::endl;
+            std::cin >> std::setw(sizeof(terminal)) >> terminal;
+            std::cout << "Please enter the day of departure (dd)" << std::endl;
+            std::cin >> day;
+            std::cout << "Please enter the first and last hour to show (hh hh)" << std::endl;
+            std::cin >> fromHour >> toHour;
+            if (!std::cin)
+            {
+                std::cin.clear();
+                std::cin.ignore(10000, '\n');
+                std::cout << "Please enter numbers for the day and hours" << std::endl;
+                break;
+            }
+            printDepartureBoard(terminal, day, fromHour, toHour);
+            break;
+        }
+        // create a season of sailings from a timetable file
+        case 7:
+        {
+            char fileName[256];
+            std::cout << "Please enter the timetable file name" << std::endl;
+            std::cin >> std::setw(sizeof(fileName)) >> fileName;
+            storageRequest([&] { createSailingsFromTimetable(fileName); });
+            break;
+        }
+        // export sailings, manifests or the fleet report to a file
+        case 8:
+        {
+            char exportType;
+            char formatType;
+            char fileName[256];
+            std::cout << "Enter S to export sailings, M for a sailing manifest, "
+                << "A for all manifests, R for the fleet report" << std::endl;
+            std::cin >> exportType;
+            exportType = std::toupper(exportType);
+            if (exportType == 'M')
+            {
+                std::cout << "Please enter a valid sailing ID" << std::endl;
+                std::cin >> std::setw(sizeof(sailingID)) >> sailingID;
+            }
+            std::cout << "Enter C for CSV or J for JSON" << std::endl;
+            std::cin >> formatType;
+            ExportFormat format = std::toupper(formatType) == 'J' ? jsonFormat : csvFormat;
+            std::cout << "Please enter the export file name" << std::endl;
+            std::cin >> std::setw(sizeof(fileName)) >> fileName;
+            switch (exportType)
+            {
+            case 'S':
+                exportSailings(fileName, format);
+                break;
+            case 'M':
+                exportManifest(sailingID, fileName, format);
+                break;
+            case 'A':
+                exportManifest(nullptr, fileName, format);
+                break;
+            case 'R':
+                exportFleetReport(fileName, format);
+                break;
+            default:
+                std::cout << "Please select a valid option" << std::endl;
+            }
+            break;
+        }
+        // move departed sailings to the archive of a period
+        case 9:
+        {
+            char period[33];
+            int day, hour;
+            std::cout << "Please enter the archive period (e.g. 2026-10)" << std::endl;
+            std::cin >> std::setw(sizeof(period)) >> period;
+            std::cout << "Archive sailings departing before which day and hour? (dd hh)" << std::endl;
+            std::cin >> day >> hour;
+            if (!std::cin)
+            {
+                std::cin.clear();
+                std::cin.ignore(10000, '\n');
+                std::cout << "Please enter numbers for the day and hour" << std::endl;
+                break;
+            }
+            storageRequest([&] { archiveDepartedSailings(day, hour, period); });
+            break;
+        }
+        // check in a boarding wave from a plate queue file
+        case 10:
+        {
+            char queueName[256];
+            std::cout << "Please enter a valid sailing ID" << std::endl;
+            std::cin >> std::setw(sizeof(sailingID)) >> sailingID;
+            std::cout << "Please enter the plate queue file name" << std::endl;
+            std::cin >> std::setw(sizeof(queueName)) >> queueName;
+            storageRequest([&] { checkInWave(sailingID, queueName); });
+            break;
+        }
+        // return to main menu
+        case 11:
             currentMenu = mainMenu;
             break;
         // invalid user input
@@ -275,6 +520,7 @@ void displayCurrentMenu()
     // display menus and take input until user decides to exit
     while (currentMenu != exitProgram)
     {
+        metricsTick();
         switch(currentMenu)
         {
         case mainMenu:
@@ -282,14 +528,18 @@ void displayCurrentMenu()
                 << "1. Reservation Submenu\n"
                 << "2. Sailing Submenu\n"
                 << "3. Create Vessel\n"
-                << "4. Exit" << std::endl;
+                << "4. Import Data (CSV)\n"
+                << "5. Statistics\n"
+                << "6. Tracing On/Off\n"
+                << "7. Exit" << std::endl;
             processInput();
             break;
         case reservationMenu:
             std::cout << "\n=== Reservation Menu ===\n"
                 << "1. Create Reservation\n"
                 << "2. Delete Reservation\n"
-                << "3. Return to Main Menu" << std::endl;
+                << "3. Find Available Sailings\n"
+                << "4. Return to Main Menu" << std::endl;
             processInput();
             break;
         case sailingMenu:
@@ -299,7 +549,12 @@ void displayCurrentMenu()
                 << "3. Query Sailing\n"
                 << "4. Delete Sailing\n"
                 << "5. Print Sailing Report\n"
-                << "6. Return to Main Menu" << std::endl;
+                << "6. Departure Board\n"
+                << "7. Create Sailings from Timetable\n"
+                << "8. Export Data\n"
+                << "9. Archive Departed Sailings\n"
+                << "10. Batch Check In\n"
+                << "11. Return to Main Menu" << std::endl;
             processInput();
             break;
         }
@@ -307,4 +562,485 @@ void displayCurrentMenu()
     currentMenu = mainMenu;
     std::cout << "Exiting Ferry Reservation System. Goodbye!" << std::endl;
     return;
+}
+
+// helper function copyToken copies a script argument into a fixed size field
+// Throws an exception if the argument is too long
+static void copyToken(const std::string& token, char field[], std::size_t size)
+{
+    if (token.empty() || token.size() >= size)
+    {
+        throw std::runtime_error("argument '" + token + "' must be 1-" + std::to_string(size - 1) + " characters");
+    }
+    std::strncpy(field, token.c_str(), size - 1);
+    field[size - 1] = '\0';
+}
+
+// helper function parseNumber reads a whole script argument as a number
+// Throws an exception if any of it is not part of the number
+static float parseNumber(const std::string& token)
+{
+    std::size_t used = 0;
+    float value = 0;
+    try
+    {
+        value = std::stof(token, &used);
+    }
+    catch (const std::logic_error&)
+    {
+        used = 0;
+    }
+    if (used == 0 || used != token.size())
+    {
+        throw std::runtime_error("argument '" + token + "' is not a number");
+    }
+    return value;
+}
+
+// helper function parseWholeNumber reads a whole script argument as an int
+// Throws an exception if it is not a number or has a fractional part
+static int parseWholeNumber(const std::string& token)
+{
+    float value = parseNumber(token);
+    if (value != static_cast<float>(static_cast<long long>(value)) || value < INT_MIN || value > INT_MAX)
+    {
+        throw std::runtime_error("argument '" + token + "' is not a whole number");
+    }
+    return static_cast<int>(value);
+}
+
+// helper function exportFormat reads a csv/json script argument
+static ExportFormat exportFormat(const std::string& token)
+{
+    if (token == "json")
+    {
+        return jsonFormat;
+    }
+    if (token == "csv")
+    {
+        return csvFormat;
+    }
+    throw std::runtime_error("format must be csv or json");
+}
+
+// helper function formatNumber formats a value with 3 decimals, independent
+// of the formatting flags other modules leave on std::cout
+static std::string formatNumber(double value)
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3) << value;
+    return text.str();
+}
+
+// helper function runCommand executes one script command
+// Throws an exception if the command is unknown, its arguments are
+// invalid, or the operation fails
+static void runCommand(const std::string& command, std::istringstream& args)
+{
+    char sailingID[10];
+    char vehicleLicence[11];
+    char vesselName[26];
+    char fileName[256];
+    RequestArena request; // shared by every manager call of the command
+    DataWriteLock writing; // ferryReport copies the files between commands
+    ShippedRequest shipped; // the standby applies the whole command at once
+    std::vector<std::string> arg;
+    std::string token;
+    while (args >> token)
+    {
+        arg.push_back(token);
+    }
+    static const std::map<std::string, std::size_t> argCount = {
+        {"reserve", 5}, {"cancel", 2}, {"checkin", 2}, {"count", 1},
+        {"create-sailing", 2}, {"delete-sailing", 1}, {"vessel", 3},
+        {"available", 5}, {"board", 4}, {"report", 0}, {"timetable", 1},
+        {"import-vehicles", 1}, {"import-reservations", 1},
+        {"export-sailings", 2}, {"export-manifest", 3}, {"export-report", 2}, {"stats", 1}, {"trace", 1},
+        {"metrics", 1}, {"reserve-batch", 1}, {"archive", 3}, {"archive-query", 2},
+        {"snapshot", 2}, {"restore", 3}, {"replicate", 1}, {"replication-status", 0},
+        {"checkin-batch", 2}};
+    std::map<std::string, std::size_t>::const_iterator expected = argCount.find(command);
+    if (expected == argCount.end())
+    {
+        throw std::runtime_error("unknown command");
+    }
+    if (arg.size() != expected->second)
+    {
+        throw std::runtime_error("expected " + std::to_string(expected->second) + " arguments");
+    }
+
+    if (command == "reserve")
+    {
+        // reserve ttt-dd-hh PLATE length height phone
+        Vehicle v = {};
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        copyToken(arg[1], v.vehicleLicence, sizeof(v.vehicleLicence));
+        v.vehicleLength = parseNumber(arg[2]);
+        v.vehicleHeight = parseNumber(arg[3]);
+        copyToken(arg[4], v.phone, sizeof(v.phone));
+        createReservation(sailingID, v);
+    }
+    else if (command == "reserve-batch")
+    {
+        // reserve-batch FILE, one "ttt-dd-hh PLATE length height phone" per line
+        std::ifstream batch(arg[0]);
+        if (!batch.is_open())
+        {
+            throw std::runtime_error("Cannot open " + arg[0]);
+        }
+        std::vector<ReservationRequest> requests;
+        std::vector<std::string> unreadable; // "line N: reason" for lines not booked
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(batch, line))
+        {
+            lineNumber++;
+            std::istringstream fields(line);
+            std::string id, plate, length, height, phone, extra;
+            if (!(fields >> id))
+            {
+                continue; // blank line
+            }
+            try
+            {
+                if (!(fields >> plate >> length >> height >> phone) || (fields >> extra))
+                {
+                    throw std::runtime_error("expected ttt-dd-hh PLATE length height phone");
+                }
+                ReservationRequest request = {};
+                copyToken(id, request.sailingID, sizeof(request.sailingID));
+                copyToken(plate, request.vehicle.vehicleLicence, sizeof(request.vehicle.vehicleLicence));
+                request.vehicle.vehicleLength = parseNumber(length);
+                request.vehicle.vehicleHeight = parseNumber(height);
+                copyToken(phone, request.vehicle.phone, sizeof(request.vehicle.phone));
+                requests.push_back(request);
+            }
+            catch (const std::runtime_error& e)
+            {
+                unreadable.push_back("line " + std::to_string(lineNumber) + ": " + e.what());
+            }
+        }
+        int booked = createReservations(requests.data(), static_cast<int>(requests.size()));
+        std::cout << "Booked " << booked << " of " << requests.size() + unreadable.size() << " vehicles." << std::endl;
+        for (const std::string& problem : unreadable)
+        {
+            std::cout << "  " << problem << std::endl;
+        }
+        std::map<std::string, std::string> refused;
+        for (const ReservationRequest& request : requests)
+        {
+            if (!request.error.empty())
+            {
+                refused[request.sailingID] = request.error;
+            }
+        }
+        for (const std::pair<const std::string, std::string>& group : refused)
+        {
+            std::cout << "  " << group.first << " refused: " << group.second << std::endl;
+        }
+    }
+    else if (command == "cancel")
+    {
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        copyToken(arg[1], vehicleLicence, sizeof(vehicleLicence));
+        deleteReservations(sailingID, vehicleLicence);
+    }
+    else if (command == "checkin")
+    {
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        copyToken(arg[1], vehicleLicence, sizeof(vehicleLicence));
+        float fare = checkIn(sailingID, vehicleLicence, false);
+        std::cout << "Collect fare: $" << fare << std::endl;
+    }
+    else if (command == "checkin-batch")
+    {
+        // checkin-batch ttt-dd-hh FILE, one licence plate per line
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        copyToken(arg[1], fileName, sizeof(fileName));
+        checkInWave(sailingID, fileName);
+    }
+    else if (command == "count")
+    {
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        accessReservationManager(sailingID);
+    }
+    else if (command == "create-sailing")
+    {
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        copyToken(arg[1], vesselName, sizeof(vesselName));
+        createSailing(sailingID, vesselName);
+    }
+    else if (command == "delete-sailing")
+    {
+        copyToken(arg[0], sailingID, sizeof(sailingID));
+        removeReservations(sailingID);
+    }
+    else if (command == "vessel")
+    {
+        // vessel NAME lowCeilingLength highCeilingLength
+        Vessel v = {};
+        copyToken(arg[0], v.name, sizeof(v.name));
+        v.LCLL = parseNumber(arg[1]);
+        v.HCLL = parseNumber(arg[2]);
+        if (!(v.LCLL >= 0 && v.LCLL <= 9999.9f) || !(v.HCLL >= 0 && v.HCLL <= 9999.9f))
+        {
+            throw std::runtime_error("lane lengths must be 0-9999.9 m");
+        }
+        writeVessel(v);
+    }
+    else if (command == "available")
+    {
+        // available ttt dd-hh length height k
+        char terminal[4];
+        char fromTime[6];
+        copyToken(arg[0], terminal, sizeof(terminal));
+        copyToken(arg[1], fromTime, sizeof(fromTime));
+        std::vector<Sailing> found = findAvailableSailings(terminal, fromTime, parseNumber(arg[2]),
+                                                           parseNumber(arg[3]), parseWholeNumber(arg[4]));
+        for (const Sailing& s : found)
+        {
+            std::cout << s.sailingID << " on " << s.vesselName
+                      << "  LRL=" << s.lowRemainingLength
+                      << "  HRL=" << s.highRemainingLength << std::endl;
+        }
+    }
+    else if (command == "board")
+    {
+        // board ttt dd fromHour toHour
+        char terminal[4];
+        copyToken(arg[0], terminal, sizeof(terminal));
+        printDepartureBoard(terminal, parseWholeNumber(arg[1]), parseWholeNumber(arg[2]),
+                            parseWholeNumber(arg[3]));
+    }
+    else if (command == "report")
+    {
+        char printerName[] = "stdout";
+        printSailingReport(printerName);
+    }
+    else if (command == "timetable")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        createSailingsFromTimetable(fileName);
+    }
+    else if (command == "import-vehicles")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        importVehicles(fileName);
+    }
+    else if (command == "import-reservations")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        importReservations(fileName);
+    }
+    else if (command == "export-sailings")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        exportSailings(fileName, exportFormat(arg[1]));
+    }
+    else if (command == "export-manifest")
+    {
+        // export-manifest ttt-dd-hh|all file csv|json
+        copyToken(arg[1], fileName, sizeof(fileName));
+        if (arg[0] == "all")
+        {
+            exportManifest(nullptr, fileName, exportFormat(arg[2]));
+        }
+        else
+        {
+            copyToken(arg[0], sailingID, sizeof(sailingID));
+            exportManifest(sailingID, fileName, exportFormat(arg[2]));
+        }
+    }
+    else if (command == "export-report")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        exportFleetReport(fileName, exportFormat(arg[1]));
+    }
+    else if (command == "stats")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        writeStatsFile(fileName);
+    }
+    else if (command == "trace")
+    {
+        if (arg[0] == "off")
+        {
+            traceStop();
+        }
+        else
+        {
+            copyToken(arg[0], fileName, sizeof(fileName));
+            traceStart(fileName);
+        }
+    }
+    else if (command == "archive")
+    {
+        // archive PERIOD dd hh moves sailings departing before dd-hh
+        archiveDepartedSailings(parseWholeNumber(arg[1]), parseWholeNumber(arg[2]), arg[0].c_str());
+    }
+    else if (command == "archive-query")
+    {
+        // archive-query PERIOD ttt-dd-hh|all
+        std::vector<ArchivedSailing> found;
+        if (arg[1] == "all")
+        {
+            found = readArchive(arg[0].c_str());
+        }
+        else
+        {
+            ArchivedSailing archived;
+            copyToken(arg[1], sailingID, sizeof(sailingID));
+            if (!findArchivedSailing(arg[0].c_str(), sailingID, archived))
+            {
+                throw std::runtime_error(arg[1] + " is not archived in " + arg[0]);
+            }
+            found.push_back(std::move(archived));
+        }
+        for (const ArchivedSailing& a : found)
+        {
+            int checkedIn = 0;
+            for (const Reservation& r : a.reservations)
+            {
+                checkedIn += r.onBoard ? 1 : 0;
+            }
+            std::cout << a.sailing.sailingID << " on " << a.sailing.vesselName
+                      << "  vehicles=" << a.reservations.size() << "  checkedIn=" << checkedIn
+                      << "  LRL=" << a.sailing.lowRemainingLength
+                      << "  HRL=" << a.sailing.highRemainingLength << std::endl;
+        }
+    }
+    else if (command == "snapshot")
+    {
+        // snapshot DIR full|incremental
+        if (arg[1] != "full" && arg[1] != "incremental")
+        {
+            throw std::runtime_error("snapshot must be full or incremental");
+        }
+        takeSnapshot(arg[0].c_str(), arg[1] == "incremental");
+    }
+    else if (command == "restore")
+    {
+        // restore DIR N|latest TARGETDIR
+        int snapshot = arg[1] == "latest" ? latestSnapshot(arg[0].c_str()) : parseWholeNumber(arg[1]);
+        restoreSnapshot(arg[0].c_str(), snapshot, arg[2].c_str());
+    }
+    else if (command == "replicate")
+    {
+        // replicate DIR|off
+        if (arg[0] == "off")
+        {
+            replicationStop();
+        }
+        else
+        {
+            replicationStart(arg[0].c_str());
+        }
+    }
+    else if (command == "replication-status")
+    {
+        ReplicationStatus status = replicationStatus();
+        std::cout << "Replication " << (status.shipping ? "on" : "off") << ": shipped "
+                  << status.shippedRecords << " records, " << status.shippedBytes << " bytes; last commit "
+                  << status.committedSequence << ", applied ";
+        if (status.appliedSequence < 0)
+        {
+            std::cout << "unknown";
+        }
+        else
+        {
+            std::cout << status.appliedSequence;
+        }
+        std::cout << ", lag " << std::fixed << std::setprecision(3) << status.lagSeconds << std::defaultfloat
+                  << " s" << std::endl;
+    }
+    else if (command == "metrics")
+    {
+        copyToken(arg[0], fileName, sizeof(fileName));
+        writeMetricsFile(fileName);
+    }
+}
+
+// Function runScript executes a command script without prompting,
+// printing the latency of each command and a throughput summary
+// Returns the number of commands that failed
+//----------------------------------------------------------------
+int runScript(const char fileName[])
+{
+    std::ifstream script(fileName);
+    if (!script.is_open())
+    {
+        throw std::runtime_error(std::string("runScript: Cannot open ") + fileName + ".");
+    }
+
+    std::vector<double> latencies; // milliseconds per command
+    std::map<std::string, std::pair<int, double> > perCommand; // count, total ms
+    int failed = 0;
+    int lineNumber = 0;
+    std::string line;
+    std::chrono::steady_clock::time_point scriptStart = std::chrono::steady_clock::now();
+
+    while (std::getline(script, line))
+    {
+        lineNumber++;
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command) || command[0] == '#')
+        {
+            continue; // blank or comment line
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::string error;
+        try
+        {
+            runCommand(command, args);
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (traceEnabled() && command != "trace")
+        {
+            traceSpan(("script " + command).c_str(), start, static_cast<long long>(ms * 1e6));
+        }
+        metricsTick();
+
+        latencies.push_back(ms);
+        perCommand[command].first++;
+        perCommand[command].second += ms;
+        if (error.empty())
+        {
+            std::cout << "[line " << lineNumber << "] " << command << " ok " << formatNumber(ms) << " ms" << std::endl;
+        }
+        else
+        {
+            failed++;
+            std::cout << "[line " << lineNumber << "] " << command << " FAILED " << formatNumber(ms) << " ms: "
+                      << error << std::endl;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scriptStart).count();
+
+    // Throughput summary
+    std::cout << "\n=== Script Summary ===\n"
+              << "Commands: " << latencies.size() << " (" << failed << " failed)\n"
+              << "Elapsed: " << formatNumber(seconds) << " s\n";
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        std::size_t n = latencies.size();
+        std::cout << "Throughput: " << formatNumber(seconds > 0 ? n / seconds : 0.0) << " commands/s\n"
+                  << "Latency p50: " << formatNumber(latencies[n / 2]) << " ms  p99: "
+                  << formatNumber(latencies[std::min(n - 1, n * 99 / 100)]) << " ms  max: "
+                  << formatNumber(latencies[n - 1]) << " ms\n";
+        for (const auto& entry : perCommand)
+        {
+            std::cout << std::left << std::setw(22) << entry.first << std::right
+                      << std::setw(8) << entry.second.first << " calls  "
+                      << formatNumber(entry.second.second / entry.second.first) << " ms avg\n";
+        }
+    }
+    std::cout << std::flush;
+    return failed;
 }
\ No newline at end of file
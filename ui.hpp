@@ -42,4 +42,13 @@ void reservation();
 
 // Function displays the appropriate menu to the user depending on currentMenu
 //----------------------------------------------------------------
-void displayCurrentMenu();
\ No newline at end of file
+void displayCurrentMenu();
+
+// Function runScript executes a command script without prompting, one
+// operation per line (e.g. "reserve ttt-dd-hh PLATE len height phone"),
+// printing the latency of each command and a throughput summary.
+// Blank lines and lines starting with # are ignored.
+// Returns the number of commands that failed
+// Throws an exception if the script cannot be opened
+//----------------------------------------------------------------
+int runScript(const char fileName[]);
\ No newline at end of file
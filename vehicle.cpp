@@ -5,6 +5,17 @@
 * Filename: vehicle.cpp
 *
 * Revision History:
+* Rev. 3 - 26/10/18 Modified by L. Xu
+*        - Added writeVehicles for appending a block of records at once
+*        - Timed public functions and counted I/O in the Stats module
+*        - Traced per-record reads
+*        - Added rewriteVehicles for atomic whole-file rewrites
+*        - Added async appends, block reads and readahead through the
+*          AsyncIo module; synchronous functions settle them first
+*        - Added vehicleSnapshot for zero-copy scans
+*        - Kept a Bloom filter of stored licences, rebuilt at open and
+*          updated on every write, for vehicleMayExist
+*        - Shipped every change to the Replication module
 * Rev. 2 - 25/08/03 Modified by L. Xu
 *        - Fixed eof handling
 * Rev. 1 - 25/07/20 Original by L. Xu
@@ -26,15 +37,60 @@
 //============================================================
 
 #include "vehicle.hpp"
+#include "stats.hpp"
+#include "atomicFile.hpp"
+#include "asyncIo.hpp"
+#include "replication.hpp"
+#include "bloomFilter.hpp"
 #include <fstream>
 #include <stdexcept>
 #include <cstring> 
+#include <vector>
 
 //============================================================
 // Module scope static variables
 //------------------------------------------------------------
 static std::fstream vehicleFile; // file stream for the vehicle data file
 static const std::string VEHICLEFILENAME = "vehicles.dat"; // name of the vessel file
+static AsyncRecordFile vehicleAsync = {"vehicles.dat", -1, 0, 0}; // async state of the file
+static BloomFilter vehicleFilter("vehicles"); // licences stored in the file
+
+//============================================================
+// Helper function licenceLength returns the length of a licence field
+//------------------------------------------------------------
+static std::size_t licenceLength(const char vehicleLicence[])
+{
+    return strnlen(vehicleLicence, sizeof(Vehicle::vehicleLicence));
+}
+
+// Helper function addToFilter adds the licences of count records
+//------------------------------------------------------------
+static void addToFilter(const Vehicle records[], int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        vehicleFilter.add(records[i].vehicleLicence, licenceLength(records[i].vehicleLicence));
+    }
+}
+
+// Helper function rebuildFilter refills the filter from count records,
+// sized with room for the file to double
+//------------------------------------------------------------
+static void rebuildFilter(const Vehicle records[], int count)
+{
+    vehicleFilter.reset(static_cast<std::size_t>(count) * 2);
+    addToFilter(records, count);
+}
+
+// Helper function rebuildFilterFromFile refills the filter from the file
+//------------------------------------------------------------
+static void rebuildFilterFromFile()
+{
+    vehicleFile.flush();
+    RecordSnapshot<Vehicle> snapshot{MappedFile(VEHICLEFILENAME)};
+    RecordView<Vehicle> records = snapshot.records();
+    rebuildFilter(records.data(), static_cast<int>(records.size()));
+}
 
 //============================================================
 // Function vehicleOpen creates and opens the Vehicle file for binary read/write
@@ -43,6 +99,7 @@ static const std::string VEHICLEFILENAME = "vehicles.dat"; // name of the vessel
 //------------------------------------------------------------
 void vehicleOpen()
 {
+    TIME_FUNCTION("vehicleOpen");
     // Try to open the vehicle file without overwriting the contents
     vehicleFile.open(VEHICLEFILENAME, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
     if (!vehicleFile.is_open())
@@ -66,6 +123,8 @@ void vehicleOpen()
             throw std::runtime_error("Cannot open " + VEHICLEFILENAME + ".");
         } 
     }
+    countIo(vehicleStorage, fileOpen);
+    rebuildFilterFromFile();
 }
 
 // Function vehicleReset seeks to the beginning of the Vehicle file
@@ -74,6 +133,8 @@ void vehicleOpen()
 //------------------------------------------------------------
 void vehicleReset()
 {
+    TIME_FUNCTION("vehicleReset");
+    asyncSettle(vehicleAsync);
     if (!vehicleFile.is_open())
     {
         // Throw an exception if the file could not be opened
@@ -81,6 +142,7 @@ void vehicleReset()
     }
     vehicleFile.clear();
     vehicleFile.seekg(0, std::ios::beg); // Set get position to the start of the file
+    countIo(vehicleStorage, fileSeek);
     
 }
 
@@ -91,6 +153,7 @@ void vehicleReset()
 //------------------------------------------------------------
 bool getNextVehicle(Vehicle& v)
 {
+    TRACE_SPAN("getNextVehicle");
     if (!vehicleFile.is_open())
     {
         // Throw an exception if the file is not open
@@ -108,12 +171,14 @@ bool getNextVehicle(Vehicle& v)
     }
 
     vehicleFile.flush();
+    countIo(vehicleStorage, fileFlush);
 
     if (!vehicleFile)
     {
         // Throw an exception if the file could not be read from
         throw std::runtime_error("Error reading from file " + VEHICLEFILENAME + ".");
     }
+    countIo(vehicleStorage, recordRead);
 
     return true;
 }
@@ -125,6 +190,8 @@ bool getNextVehicle(Vehicle& v)
 //------------------------------------------------------------
 void writeVehicle(const Vehicle& v)
 {
+    TIME_FUNCTION("writeVehicle");
+    asyncSettle(vehicleAsync);
     if (!vehicleFile.is_open())
     {
         // Throw an exception if the file is not open
@@ -134,6 +201,8 @@ void writeVehicle(const Vehicle& v)
     // Write information of the vehicle object at the end 
     vehicleFile.clear();
     vehicleFile.seekp(0, std::ios::end); // Move to the end of the file
+    countIo(vehicleStorage, fileSeek);
+    long long offset = static_cast<long long>(vehicleFile.tellp());
     vehicleFile.write(reinterpret_cast<const char *>(&v), sizeof(Vehicle));
     
     if (!vehicleFile)
@@ -141,6 +210,178 @@ void writeVehicle(const Vehicle& v)
         // Throw an exception if the file could not be written to
         throw std::runtime_error("Error writing to file " + VEHICLEFILENAME + ".");
     }
+    countIo(vehicleStorage, recordWritten);
+    shipWrite(vehicleStorage, offset, &v, sizeof(Vehicle));
+    addToFilter(&v, 1);
+    if (vehicleFilter.full())
+    {
+        rebuildFilterFromFile();
+    }
+}
+
+// Function writeVehicles binary writes a block of vehicles to the
+// end of the Vehicle file with one write and one flush
+// Returns nothing
+// Takes an array of Vehicle objects and its length
+// Throws an exception if the binary write operation fails
+//------------------------------------------------------------
+void writeVehicles(const Vehicle vehicles[], int count)
+{
+    TIME_FUNCTION("writeVehicles");
+    asyncSettle(vehicleAsync);
+    if (!vehicleFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + VEHICLEFILENAME + " is not open.");
+    }
+    if (count <= 0)
+    {
+        return;
+    }
+
+    // Write the whole block at the end
+    vehicleFile.clear();
+    vehicleFile.seekp(0, std::ios::end);
+    countIo(vehicleStorage, fileSeek);
+    long long offset = static_cast<long long>(vehicleFile.tellp());
+    vehicleFile.write(reinterpret_cast<const char *>(vehicles), static_cast<std::streamsize>(count) * sizeof(Vehicle));
+    vehicleFile.flush();
+    countIo(vehicleStorage, fileFlush);
+
+    if (!vehicleFile)
+    {
+        // Throw an exception if the file could not be written to
+        throw std::runtime_error("Error writing to file " + VEHICLEFILENAME + ".");
+    }
+    countIo(vehicleStorage, recordWritten, count);
+    shipWrite(vehicleStorage, offset, vehicles, static_cast<std::size_t>(count) * sizeof(Vehicle));
+    addToFilter(vehicles, count);
+    if (vehicleFilter.full())
+    {
+        rebuildFilterFromFile();
+    }
+}
+
+// Function rewriteVehicles replaces the whole Vehicle file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//------------------------------------------------------------
+void rewriteVehicles(const Vehicle records[], int count)
+{
+    TIME_FUNCTION("rewriteVehicles");
+    asyncRecordFileClose(vehicleAsync);
+    if (!vehicleFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + VEHICLEFILENAME + " is not open.");
+    }
+    vehicleFile.close();
+    std::string error;
+    try
+    {
+        rewriteAtomically(VEHICLEFILENAME, records, static_cast<std::size_t>(count) * sizeof(Vehicle));
+        countIo(vehicleStorage, recordWritten, count);
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+
+    // Reopen the new file, or the untouched old one if the rewrite failed
+    vehicleFile.open(VEHICLEFILENAME, std::ios::in | std::ios::out | std::ios::binary);
+    if (!vehicleFile.is_open())
+    {
+        throw std::runtime_error("Cannot open " + VEHICLEFILENAME + ".");
+    }
+    countIo(vehicleStorage, fileOpen);
+    if (!error.empty())
+    {
+        throw std::runtime_error(error);
+    }
+    shipReplace(vehicleStorage, records, static_cast<std::size_t>(count) * sizeof(Vehicle));
+    rebuildFilter(records, count);
+}
+
+// Function appendVehiclesAsync queues count vehicle records to be appended
+// through the AsyncIo backend; done gets the records written or -1
+//----------------------------------------------------------------
+void appendVehiclesAsync(const Vehicle records[], int count, bool sync, RecordCallback done)
+{
+    TIME_FUNCTION("appendVehiclesAsync");
+    // Added when queued; a failed append only leaves a false positive
+    addToFilter(records, count);
+    long long offset = asyncAppendOffset(vehicleAsync);
+    std::vector<Vehicle> appended(records, records + count);
+    asyncAppend(vehicleAsync, records, static_cast<std::size_t>(count) * sizeof(Vehicle), sync, [count, offset, appended, done](long result)
+    {
+        bool ok = result == static_cast<long>(count * sizeof(Vehicle));
+        if (ok)
+        {
+            countIo(vehicleStorage, recordWritten, count);
+            shipWrite(vehicleStorage, offset, appended.data(), appended.size() * sizeof(Vehicle));
+        }
+        if (done)
+        {
+            done(ok ? count : -1);
+        }
+    });
+}
+
+// Function readVehiclesAsync queues a read of count vehicle records from
+// firstRecord into records; done gets the records read or -1
+//----------------------------------------------------------------
+void readVehiclesAsync(Vehicle records[], int firstRecord, int count, RecordCallback done)
+{
+    TIME_FUNCTION("readVehiclesAsync");
+    asyncReadAt(vehicleAsync, records, static_cast<std::size_t>(count) * sizeof(Vehicle),
+                static_cast<long long>(firstRecord) * sizeof(Vehicle), [done](long result)
+    {
+        int read = result < 0 ? -1 : static_cast<int>(result / static_cast<long>(sizeof(Vehicle)));
+        if (read > 0)
+        {
+            countIo(vehicleStorage, recordRead, read);
+        }
+        if (done)
+        {
+            done(read);
+        }
+    });
+}
+
+// Function vehicleReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void vehicleReadahead()
+{
+    asyncReadahead(vehicleAsync);
+}
+
+// Function vehicleSnapshot flushes pending writes and maps the file
+//----------------------------------------------------------------
+RecordSnapshot<Vehicle> vehicleSnapshot()
+{
+    TIME_FUNCTION("vehicleSnapshot");
+    asyncSettle(vehicleAsync);
+    if (!vehicleFile.is_open())
+    {
+        throw std::runtime_error("File " + VEHICLEFILENAME + " is not open.");
+    }
+    vehicleFile.flush();
+    return RecordSnapshot<Vehicle>(MappedFile(VEHICLEFILENAME));
+}
+
+// Function vehicleMayExist checks the licence against the filter
+//----------------------------------------------------------------
+bool vehicleMayExist(const char vehicleLicence[])
+{
+    return vehicleFilter.mayContain(vehicleLicence, licenceLength(vehicleLicence));
+}
+
+// Function vehicleFilterFalsePositive counts a wrong "maybe" of the filter
+//----------------------------------------------------------------
+void vehicleFilterFalsePositive()
+{
+    vehicleFilter.noteFalsePositive();
 }
 
 // Function close closes the Vehicle file
@@ -149,6 +390,8 @@ void writeVehicle(const Vehicle& v)
 //------------------------------------------------------------
 void vehicleClose()
 {
+    TIME_FUNCTION("vehicleClose");
+    asyncRecordFileClose(vehicleAsync);
     if (vehicleFile.is_open())
     {
         vehicleFile.close();
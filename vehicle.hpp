@@ -14,6 +14,8 @@
 */
 //============================================================
 #pragma once
+#include "asyncIo.hpp"
+#include "mappedFile.hpp"
 #include <iostream>
 #include <string>
 
@@ -50,6 +52,49 @@ bool getNextVehicle(Vehicle& v);
 // Throws an exception if the write operation fails
 //------------------------------------------------------------
 void writeVehicle(const Vehicle& v);
+// Function writeVehicles appends count vehicles to the Vehicle file
+// using one write and one flush
+// Throws an exception if the write operation fails
+//------------------------------------------------------------
+void writeVehicles(const Vehicle vehicles[], int count);
+// Function rewriteVehicles replaces the whole Vehicle file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//------------------------------------------------------------
+void rewriteVehicles(const Vehicle records[], int count);
+// Function appendVehiclesAsync queues count vehicle records to be
+// appended through the AsyncIo backend, linked to a data sync if sync is
+// set. done runs from asyncPoll or asyncWait with the records written,
+// or -1 if the write failed.
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void appendVehiclesAsync(const Vehicle records[], int count, bool sync, RecordCallback done);
+// Function readVehiclesAsync queues a read of count vehicle records
+// starting at record firstRecord into records, which must stay valid
+// until done runs with the records read, or -1 if the read failed
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void readVehiclesAsync(Vehicle records[], int firstRecord, int count, RecordCallback done);
+// Function vehicleReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void vehicleReadahead();
+
+// Function vehicleSnapshot maps the vehicle file read-only for scans that
+// compare records in place; views of it stay valid while it lives
+// Throws an exception if the file is not open or cannot be read
+//----------------------------------------------------------------
+RecordSnapshot<Vehicle> vehicleSnapshot();
+
+// Function vehicleMayExist returns false if no vehicle with the licence is
+// stored, without reading the file; true means the file must be checked
+//----------------------------------------------------------------
+bool vehicleMayExist(const char vehicleLicence[]);
+
+// Function vehicleFilterFalsePositive records that a licence reported by
+// vehicleMayExist was not found, for the false-positive rate
+//----------------------------------------------------------------
+void vehicleFilterFalsePositive();
 // Function close closes the Vehicle file
 // Throws an exception if the file was already closed
 //------------------------------------------------------------
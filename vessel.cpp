@@ -5,6 +5,14 @@
 * Filename: vessel.cpp
 *
 * Revision History:
+* Rev. 3 - 26/10/18 Modified by L. Xu
+*        - Timed public functions and counted I/O in the Stats module
+*        - Traced per-record reads
+*        - Added rewriteVessels for atomic whole-file rewrites
+*        - Added async appends, block reads and readahead through the
+*          AsyncIo module; synchronous functions settle them first
+*        - Added vesselSnapshot for zero-copy scans
+*        - Shipped every change to the Replication module
 * Rev. 2 - 25/08/03 Modified by L. Xu
 *        - Fixed eof handling
 * Rev. 1 - 25/07/20 Original by L. Xu
@@ -26,15 +34,21 @@
 //============================================================
 
 #include "vessel.hpp"
+#include "stats.hpp"
+#include "atomicFile.hpp"
+#include "asyncIo.hpp"
+#include "replication.hpp"
 #include <fstream>
 #include <stdexcept>
 #include <cstring> 
+#include <vector>
 
 //============================================================
 // Module scope static variables
 //------------------------------------------------------------
 static std::fstream vesselFile; // file stream for the vessel data file
 static const std::string VESSELFILENAME = "vessels.dat"; // name of the vessel file
+static AsyncRecordFile vesselAsync = {"vessels.dat", -1, 0, 0}; // async state of the file
 
 //============================================================
 // Function vesselOpen creates and opens the Vessel file for binary read/write
@@ -43,6 +57,7 @@ static const std::string VESSELFILENAME = "vessels.dat"; // name of the vessel f
 //------------------------------------------------------------
 void vesselOpen()
 {
+    TIME_FUNCTION("vesselOpen");
     // Try to open the vessel file without overwriting the contents
     vesselFile.open(VESSELFILENAME, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
     if (!vesselFile.is_open())
@@ -66,6 +81,7 @@ void vesselOpen()
             throw std::runtime_error("Cannot open " + VESSELFILENAME + ".");
         } 
     }
+    countIo(vesselStorage, fileOpen);
 }
 
 // Function vesselReset seeks to the beginning of the Vessel file
@@ -74,6 +90,8 @@ void vesselOpen()
 //------------------------------------------------------------
 void vesselReset()
 {
+    TIME_FUNCTION("vesselReset");
+    asyncSettle(vesselAsync);
     if (!vesselFile.is_open())
     {
         // Throw an exception if the file could not be opened
@@ -81,6 +99,7 @@ void vesselReset()
     }
     vesselFile.clear();
     vesselFile.seekg(0, std::ios::beg); // Set get position to the start of the file
+    countIo(vesselStorage, fileSeek);
     
 }
 
@@ -91,6 +110,7 @@ void vesselReset()
 //------------------------------------------------------------
 bool getNextVessel(Vessel& v)
 {
+    TRACE_SPAN("getNextVessel");
     if (!vesselFile.is_open())
     {
         // Throw an exception if the file is not open
@@ -108,12 +128,14 @@ bool getNextVessel(Vessel& v)
     }
 
     vesselFile.flush();
+    countIo(vesselStorage, fileFlush);
 
     if (!vesselFile)
     {
         // Throw an exception if the file could not be read from
         throw std::runtime_error("Error reading from file " + VESSELFILENAME + ".");
     }
+    countIo(vesselStorage, recordRead);
 
     return true;
 }
@@ -125,6 +147,8 @@ bool getNextVessel(Vessel& v)
 //------------------------------------------------------------
 void writeVessel(const Vessel& v)
 {
+    TIME_FUNCTION("writeVessel");
+    asyncSettle(vesselAsync);
     if (!vesselFile.is_open())
     {
         // Throw an exception if the file is not open
@@ -134,6 +158,8 @@ void writeVessel(const Vessel& v)
     // Write information of the vessel object at the end 
     vesselFile.clear();
     vesselFile.seekp(0, std::ios::end); // Move to the end of the file
+    countIo(vesselStorage, fileSeek);
+    long long offset = static_cast<long long>(vesselFile.tellp());
     vesselFile.write(reinterpret_cast<const char *>(&v), sizeof(Vessel));
     
     if (!vesselFile)
@@ -141,6 +167,113 @@ void writeVessel(const Vessel& v)
         // Throw an exception if the file could not be written to
         throw std::runtime_error("Error writing to file " + VESSELFILENAME + ".");
     }
+    countIo(vesselStorage, recordWritten);
+    shipWrite(vesselStorage, offset, &v, sizeof(Vessel));
+}
+
+// Function rewriteVessels replaces the whole Vessel file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//------------------------------------------------------------
+void rewriteVessels(const Vessel records[], int count)
+{
+    TIME_FUNCTION("rewriteVessels");
+    asyncRecordFileClose(vesselAsync);
+    if (!vesselFile.is_open())
+    {
+        // Throw an exception if the file is not open
+        throw std::runtime_error("File " + VESSELFILENAME + " is not open.");
+    }
+    vesselFile.close();
+    std::string error;
+    try
+    {
+        rewriteAtomically(VESSELFILENAME, records, static_cast<std::size_t>(count) * sizeof(Vessel));
+        countIo(vesselStorage, recordWritten, count);
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+
+    // Reopen the new file, or the untouched old one if the rewrite failed
+    vesselFile.open(VESSELFILENAME, std::ios::in | std::ios::out | std::ios::binary);
+    if (!vesselFile.is_open())
+    {
+        throw std::runtime_error("Cannot open " + VESSELFILENAME + ".");
+    }
+    countIo(vesselStorage, fileOpen);
+    if (!error.empty())
+    {
+        throw std::runtime_error(error);
+    }
+    shipReplace(vesselStorage, records, static_cast<std::size_t>(count) * sizeof(Vessel));
+}
+
+// Function appendVesselsAsync queues count vessel records to be appended
+// through the AsyncIo backend; done gets the records written or -1
+//----------------------------------------------------------------
+void appendVesselsAsync(const Vessel records[], int count, bool sync, RecordCallback done)
+{
+    TIME_FUNCTION("appendVesselsAsync");
+    long long offset = asyncAppendOffset(vesselAsync);
+    std::vector<Vessel> appended(records, records + count);
+    asyncAppend(vesselAsync, records, static_cast<std::size_t>(count) * sizeof(Vessel), sync, [count, offset, appended, done](long result)
+    {
+        bool ok = result == static_cast<long>(count * sizeof(Vessel));
+        if (ok)
+        {
+            countIo(vesselStorage, recordWritten, count);
+            shipWrite(vesselStorage, offset, appended.data(), appended.size() * sizeof(Vessel));
+        }
+        if (done)
+        {
+            done(ok ? count : -1);
+        }
+    });
+}
+
+// Function readVesselsAsync queues a read of count vessel records from
+// firstRecord into records; done gets the records read or -1
+//----------------------------------------------------------------
+void readVesselsAsync(Vessel records[], int firstRecord, int count, RecordCallback done)
+{
+    TIME_FUNCTION("readVesselsAsync");
+    asyncReadAt(vesselAsync, records, static_cast<std::size_t>(count) * sizeof(Vessel),
+                static_cast<long long>(firstRecord) * sizeof(Vessel), [done](long result)
+    {
+        int read = result < 0 ? -1 : static_cast<int>(result / static_cast<long>(sizeof(Vessel)));
+        if (read > 0)
+        {
+            countIo(vesselStorage, recordRead, read);
+        }
+        if (done)
+        {
+            done(read);
+        }
+    });
+}
+
+// Function vesselReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void vesselReadahead()
+{
+    asyncReadahead(vesselAsync);
+}
+
+// Function vesselSnapshot flushes pending writes and maps the file
+//----------------------------------------------------------------
+RecordSnapshot<Vessel> vesselSnapshot()
+{
+    TIME_FUNCTION("vesselSnapshot");
+    asyncSettle(vesselAsync);
+    if (!vesselFile.is_open())
+    {
+        throw std::runtime_error("File " + VESSELFILENAME + " is not open.");
+    }
+    vesselFile.flush();
+    return RecordSnapshot<Vessel>(MappedFile(VESSELFILENAME));
 }
 
 // Function vesselClose closes the Vessel file
@@ -149,6 +282,8 @@ void writeVessel(const Vessel& v)
 //------------------------------------------------------------
 void vesselClose()
 {
+    TIME_FUNCTION("vesselClose");
+    asyncRecordFileClose(vesselAsync);
     if (vesselFile.is_open())
     {
         vesselFile.close();
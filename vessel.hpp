@@ -14,6 +14,8 @@
 */
 //============================================================
 #pragma once
+#include "asyncIo.hpp"
+#include "mappedFile.hpp"
 #include <iostream>
 #include <string>
 //============================================================
@@ -46,6 +48,34 @@ bool getNextVessel(Vessel& v);
 // Throws an exception if the write operation fails
 //------------------------------------------------------------
 void writeVessel(const Vessel& v);
+// Function rewriteVessels replaces the whole Vessel file with count
+// records in one sequential write, crash-safe (see rewriteAtomically)
+// Throws an exception if the file cannot be rewritten; the old contents
+// are then kept
+//------------------------------------------------------------
+void rewriteVessels(const Vessel records[], int count);
+// Function appendVesselsAsync queues count vessel records to be
+// appended through the AsyncIo backend, linked to a data sync if sync is
+// set. done runs from asyncPoll or asyncWait with the records written,
+// or -1 if the write failed.
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void appendVesselsAsync(const Vessel records[], int count, bool sync, RecordCallback done);
+// Function readVesselsAsync queues a read of count vessel records
+// starting at record firstRecord into records, which must stay valid
+// until done runs with the records read, or -1 if the read failed
+// Throws an exception if the file cannot be opened for async I/O
+//----------------------------------------------------------------
+void readVesselsAsync(Vessel records[], int firstRecord, int count, RecordCallback done);
+// Function vesselReadahead starts loading the whole file into the page cache
+//----------------------------------------------------------------
+void vesselReadahead();
+
+// Function vesselSnapshot maps the vessel file read-only for scans that
+// compare records in place; views of it stay valid while it lives
+// Throws an exception if the file is not open or cannot be read
+//----------------------------------------------------------------
+RecordSnapshot<Vessel> vesselSnapshot();
 // Function vesselClose closes the Vessel file
 // Throws an exception if the file was already closed
 //------------------------------------------------------------